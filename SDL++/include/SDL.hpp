@@ -15,6 +15,7 @@
 #include "error.hpp"
 #include "events.hpp"
 #include "filesystem.hpp"
+#include "filter.hpp"
 #include "gamecontroller.hpp"
 #include "guid.hpp"
 //#include "haptic.hpp"
@@ -25,22 +26,40 @@
 //#include "log.hpp"
 //#include "messagebox.hpp"
 //#include "metal.hpp"
+#include "mipmap.hpp"
 #include "mutex.hpp"
 //#include "power.hpp"
+#include "quantize.hpp"
 #include "render.hpp"
 #include "rwops.hpp"
 #include "sensor.hpp"
 #include "shape.hpp"
+#include "sprite.hpp"
+#include "surfacecache.hpp"
+#include "textureregistry.hpp"
 //#include "system.hpp"
 //#include "thread.hpp"
 #include "timer.hpp"
+#include "typedsurface.hpp"
 #include "version.hpp"
 #include "video.hpp"
+#include "yuv.hpp"
 //#include "locale.hpp"
 //#include "misc.hpp"
 
+#include "aabbtree.hpp"
+#include "fixed.hpp"
 #include "input.hpp"
+#include "parallel.hpp"
+#include "pointmath.hpp"
+#include "polygon.hpp"
 #include "ray.hpp"
+#include "rectpacker.hpp"
+#include "rectsoa.hpp"
+#include "region.hpp"
+#include "spatialhash.hpp"
+#include "sweepandprune.hpp"
+#include "transform.hpp"
 
 #if SDL_VERSION_ATLEAST(2, 0, 0)
 namespace SDL
@@ -79,6 +79,25 @@ namespace SDL::IMG
 		if (freesrc) (SDL_RWops*&)src = NULL;
 		return Surface::FromPtr(IMG_Load_RW(ptr, freesrc));
 	}
+	/* Premultiply a surface just loaded, which nothing else shares yet.
+		Paletted images are converted to ARGB8888 first, as palettes cannot
+		be premultiplied in place.
+		*/
+	inline Surface Premultiplied(Surface surface)
+	{
+		if (surface.surface != nullptr && surface.surface->format->palette != NULL)
+			surface = Surface::FromPtr(SDL_ConvertSurfaceFormat(surface.surface.get(), SDL_PIXELFORMAT_ARGB8888, 0));
+		if (surface.surface != nullptr && !surface.Premultiply()) surface.surface = nullptr;
+		return surface;
+	}
+	/* Load an image and premultiply its colour by alpha once, up front.
+		The surface is flagged with Surface::IsPremultiplied(), so blits and
+		textures made from it use premultiplied blending.
+		*/
+	inline Surface LoadPremultiplied(const char* file)
+		{ return Premultiplied(Load(file)); }
+	inline Surface LoadPremultiplied_RW(RWops& src, bool freesrc)
+		{ return Premultiplied(Load_RW(src, freesrc)); }
 #pragma endregion
 
 #pragma region Load Texture
@@ -101,6 +120,15 @@ namespace SDL::IMG
 		if (freesrc) (SDL_RWops*&)src = NULL;
 		return Texture::FromPtr(renderer, IMG_LoadTextureTyped_RW(renderer.renderer.get(), ptr, freesrc, type));
 	}
+	// Load an image, premultiply it and upload it as a premultiplied render texture.
+	inline Texture LoadTexturePremultiplied(Renderer& renderer, const char* file)
+	{
+		Surface surface = LoadPremultiplied(file);
+		if (surface.surface == nullptr) return Texture();
+		return Texture(renderer, surface);
+	}
+	inline Texture LoadTexturePremultiplied(Renderer& renderer, const std::string& file)
+		{ return LoadTexturePremultiplied(renderer, file.c_str()); }
 #endif /* SDL 2.0 */
 #endif
 #pragma endregion
@@ -0,0 +1,272 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+#ifndef SDL_aabbtree_hpp_
+#define SDL_aabbtree_hpp_
+#pragma once
+
+#include "ray.hpp"
+#include "rect.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace SDL
+{
+	/**
+	 *  \brief    A dynamic bounding volume hierarchy of rectangles, for overlap, point and ray queries in logarithmic time.
+	 *
+	 *  \details  Each rectangle added is a proxy, identified by an index that stays the same until it is removed.
+	 *            Proxies sit in the tree with fattened bounds, grown by a margin and by how far they are predicted to
+	 *            move, so a proxy that moves a little is updated in place rather than reinserted. New leaves go where
+	 *            they add the least perimeter to the tree, and branches are rotated as heights change to keep the tree
+	 *            balanced; Rebuild() rebuilds it from scratch with binned surface area splits when it has degraded.
+	 *
+	 *            Nodes live in one contiguous array and are recycled through a free list, so the tree allocates only
+	 *            when it grows past its largest size so far. Queries test the fattened bounds on the way down and the
+	 *            proxies' own rectangles at the leaves, with the same edge rules as RectsIntersect(), FRect::contains()
+	 *            and Ray::IntersectRect().
+	 */
+	struct AABBTree
+	{
+		static constexpr int NONE = -1;
+
+		struct Node
+		{
+			FPoint min, max;    // The bounds of the node, fattened for leaves
+			FRect rect;         // Leaves: the proxy's rectangle
+			void* data = NULL;  // Leaves: the proxy's user data
+			int parent = NONE;  // Or the next free node, for nodes in the free list
+			int child1 = NONE;
+			int child2 = NONE;
+			int height = -1;    // 0 for leaves, -1 for free nodes
+
+			inline bool IsLeaf() const { return child1 == NONE; }
+		};
+
+		std::vector<Node> nodes;
+		int root = NONE;
+		int freeList = NONE;
+		int proxyCount = 0;
+
+		float margin;      // How far leaves' bounds are grown on every side
+		float prediction;  // How many times a move's displacement the bounds are extended by in its direction
+
+		/**
+		 *  \brief    Create an empty tree.
+		 *
+		 *  \param    margin:     How far the bounds of each proxy are grown on every side.
+		 *  \param    prediction: How many times the displacement passed to Move() the bounds are extended by.
+		 */
+		inline AABBTree(float margin = 4.f, float prediction = 2.f) : margin(margin), prediction(prediction) {}
+
+		/**
+		 * Add a rectangle to the tree.
+		 *
+		 * \param rect the rectangle
+		 * \param data user data to keep with it
+		 * \returns the proxy index of the rectangle.
+		 */
+		int Insert(const FRect& rect, void* data = NULL);
+
+		// Remove a proxy from the tree. Its index may be reused by a later Insert().
+		void Remove(int proxy);
+
+		/**
+		 * Change the rectangle of a proxy.
+		 *
+		 * If the new rectangle still fits in the proxy's fattened bounds only
+		 * the rectangle is updated; otherwise the proxy is reinserted with new
+		 * bounds, extended in the direction it is moving.
+		 *
+		 * \param proxy the proxy to move
+		 * \param rect the new rectangle
+		 * \param displacement how far the proxy is expected to move next
+		 * \returns true if the proxy was reinserted.
+		 */
+		bool Move(int proxy, const FRect& rect, const FPoint& displacement = FPoint(0, 0));
+
+		inline const FRect& GetRect(int proxy) const { return nodes[proxy].rect; }
+		inline FRect GetFatRect(int proxy) const { return FRect(nodes[proxy].min, nodes[proxy].max - nodes[proxy].min); }
+		inline void* GetData(int proxy) const { return nodes[proxy].data; }
+		inline void SetData(int proxy, void* data) { nodes[proxy].data = data; }
+
+		inline int Size() const { return proxyCount; }
+		inline bool Empty() const { return proxyCount == 0; }
+
+		// The height of the tree, 0 for a single leaf and -1 if it is empty.
+		inline int Height() const { return root == NONE ? -1 : nodes[root].height; }
+
+		// The total perimeter of every node over the perimeter of the root, which grows as the tree degrades.
+		float Cost() const;
+
+		// Rebuild the tree from top to bottom, splitting proxies where the children's perimeters are smallest. Proxy indices are kept.
+		void Rebuild();
+
+		// Remove every proxy.
+		void Clear();
+
+		/**
+		 * Find every proxy whose rectangle overlaps a rectangle.
+		 *
+		 * \param rect the rectangle to test
+		 * \param callback called as callback(proxy) for each proxy found;
+		 *                 return false to stop the query
+		 */
+		template <typename F>
+		inline void Query(const FRect& rect, F&& callback) const
+		{
+			const FPoint min = rect.pos, max = rect.pos + rect.size;
+			Traverse(
+				[&](const Node& n) { return n.min.x <= max.x && n.max.x >= min.x && n.min.y <= max.y && n.max.y >= min.y; },
+				[&](int i) { return !RectsIntersect(nodes[i].rect, rect) || callback(i); });
+		}
+
+		/**
+		 * Find every proxy whose rectangle contains a point.
+		 *
+		 * \param point the point to test
+		 * \param callback called as callback(proxy) for each proxy found;
+		 *                 return false to stop the query
+		 */
+		template <typename F>
+		inline void QueryPoint(const FPoint& point, F&& callback) const
+		{
+			Traverse(
+				[&](const Node& n) { return n.min.x <= point.x && n.max.x >= point.x && n.min.y <= point.y && n.max.y >= point.y; },
+				[&](int i) { return !nodes[i].rect.contains(point) || callback(i); });
+		}
+
+		/**
+		 * Find every pair of proxies whose rectangles overlap.
+		 *
+		 * \param callback called as callback(a, b) once for each pair, with
+		 *                 a < b; return false to stop the query
+		 */
+		template <typename F>
+		inline void QueryPairs(F&& callback) const
+		{
+			bool stopped = false;
+			for (int a = 0; a < (int)nodes.size() && !stopped; a++)
+			{
+				if (nodes[a].height != 0) continue;
+				Query(nodes[a].rect, [&](int b)
+				{
+					if (b > a && !callback(a, b)) stopped = true;
+					return !stopped;
+				});
+			}
+		}
+
+		/**
+		 * Find every proxy whose rectangle a ray passes through.
+		 *
+		 * The ray is the segment from origin to origin + dir, as with
+		 * Ray::IntersectAll(). Proxies are visited in no particular order.
+		 *
+		 * \param ray the ray to cast
+		 * \param callback called as callback(proxy, time) for each proxy hit,
+		 *                 where time is the proportion of dir at which the ray
+		 *                 enters it; return false to stop the query
+		 */
+		template <typename F>
+		inline void RayCast(const Ray& ray, F&& callback) const
+		{
+			if (ray.dir.x == 0 && ray.dir.y == 0) return; // No ray
+
+			const FPoint inv = InverseDir(ray);
+			float entry;
+			Traverse(
+				[&](const Node& n) { return SlabTest(ray.origin, inv, n.min, n.max, 1.f, entry); },
+				[&](int i) { return !SlabTest(ray.origin, inv, nodes[i].rect, 1.f, entry) || callback(i, entry); });
+		}
+
+		/**
+		 * Find the first proxy a ray enters.
+		 *
+		 * Once a proxy is hit, branches the ray can only reach later are
+		 * skipped.
+		 *
+		 * \param ray the ray to cast
+		 * \param contact filled in with the point, normal and time of the hit,
+		 *                as Ray::IntersectRect() would, if there is one
+		 * \returns the proxy entered first, or NONE if none are hit.
+		 */
+		int FirstHit(const Ray& ray, Ray::Contact& contact) const;
+
+		// Evaluates to true if every node's bounds contain its children's and the heights and parents are consistent.
+		bool Validate() const;
+
+		// A stack for walking the tree, which only allocates if the tree is unusually deep
+		struct Stack
+		{
+			int fixed[64];
+			std::vector<int> overflow;
+			int count = 0;
+
+			inline void Push(int i)
+			{
+				if (count < 64) fixed[count] = i;
+				else overflow.push_back(i);
+				count++;
+			}
+
+			inline int Pop()
+			{
+				count--;
+				if (count < 64) return fixed[count];
+				const int i = overflow.back();
+				overflow.pop_back();
+				return i;
+			}
+		};
+
+		// Walk the nodes whose bounds pass enter(node), calling leaf(index) on leaves until it returns false
+		template <typename E, typename L>
+		inline void Traverse(E&& enter, L&& leaf) const
+		{
+			if (root == NONE) return;
+
+			Stack stack;
+			stack.Push(root);
+
+			while (stack.count > 0)
+			{
+				const int i = stack.Pop();
+				const Node& n = nodes[i];
+				if (!enter(n)) continue;
+
+				if (n.IsLeaf())
+				{
+					if (!leaf(i)) return;
+				}
+				else
+				{
+					stack.Push(n.child1);
+					stack.Push(n.child2);
+				}
+			}
+		}
+
+		// The reciprocal of a ray's direction, with a huge value for an axis it does not move along
+		inline static FPoint InverseDir(const Ray& ray)
+			{ return FPoint(ray.dir.x != 0 ? 1.f / ray.dir.x : 1e30f, ray.dir.y != 0 ? 1.f / ray.dir.y : 1e30f); }
+
+		// Slab test a box against the part of a ray up to time limit, giving the time it enters the box in entry
+		inline static bool SlabTest(const FPoint& origin, const FPoint& inv, const FPoint& min, const FPoint& max, float limit, float& entry)
+		{
+			const float x1 = (min.x - origin.x) * inv.x, x2 = (max.x - origin.x) * inv.x;
+			const float y1 = (min.y - origin.y) * inv.y, y2 = (max.y - origin.y) * inv.y;
+
+			entry = std::max(std::min(x1, x2), std::min(y1, y2));
+			const float leave = std::min(std::max(x1, x2), std::max(y1, y2));
+
+			return entry <= leave && leave >= 0 && entry <= limit;
+		}
+
+		inline static bool SlabTest(const FPoint& origin, const FPoint& inv, const FRect& rect, float limit, float& entry)
+			{ return !rect.empty() && SlabTest(origin, inv, rect.pos, rect.pos + rect.size, limit, entry); }
+	};
+}
+
+#endif
+#endif
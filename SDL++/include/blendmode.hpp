@@ -78,6 +78,35 @@ namespace SDL
 			(SDL_BlendOperation)alphaOperation
 		);
 	}
+
+	/**
+	 *  \brief Get the blend mode that matches a standard mode when the source colour is premultiplied by its alpha
+	 *
+	 *  \param blendMode the blend mode as it would be used with straight alpha
+	 *
+	 *  The premultiplied equivalents of BLEND and ADD are:
+	 *      BLEND: dstRGB = srcRGB + (dstRGB * (1-srcA)), dstA = srcA + (dstA * (1-srcA))
+	 *      ADD:   dstRGB = srcRGB +  dstRGB,             dstA = dstA
+	 *  Other modes do not weight the source by its alpha and are returned unchanged.
+	 */
+	inline BlendMode PremultipliedBlendMode(BlendMode blendMode)
+	{
+		switch (blendMode)
+		{
+		case BlendMode::BLEND:
+			return ComposeCustomBlendMode(
+				BlendFactor::ONE, BlendFactor::ONE_MINUS_SRC_ALPHA, BlendOperation::ADD,
+				BlendFactor::ONE, BlendFactor::ONE_MINUS_SRC_ALPHA, BlendOperation::ADD
+			);
+		case BlendMode::ADD:
+			return ComposeCustomBlendMode(
+				BlendFactor::ONE,  BlendFactor::ONE, BlendOperation::ADD,
+				BlendFactor::ZERO, BlendFactor::ONE, BlendOperation::ADD
+			);
+		default:
+			return blendMode;
+		}
+	}
 #endif
 }
 
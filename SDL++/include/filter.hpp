@@ -0,0 +1,154 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+#ifndef SDL_filter_hpp_
+#define SDL_filter_hpp_
+#pragma once
+
+#include "pixels.hpp"
+#include "surface.hpp"
+
+namespace SDL
+{
+	// Convolution and morphology filters that run directly on Surface pixel memory.
+	//
+	// The in-place filters need a surface whose channels are 8-bit components of a
+	// 32-bit pixel (such as ARGB8888 or RGBA32), and treat the edges as repeating
+	// the outermost pixels. Every channel is filtered as stored, so colour from
+	// transparent pixels bleeds into blurred edges unless the surface has been
+	// premultiplied (see Surface::Premultiply()).
+	//
+	// The blurs and Sharpen() take a ColourSpace; with ColourSpace::LINEAR they mix
+	// colour in linear light, so bright details do not dim as they spread.
+	//
+	// Passing parallel = true splits the rows of each pass across all CPU cores.
+	namespace SurfaceFilter
+	{
+		// How Blur() builds its kernel.
+		enum class BlurMode
+		{
+			GAUSSIAN, // A true separable Gaussian; cost grows with sigma
+			BOX       // Three successive box blurs approximating the Gaussian; cost is independent of sigma
+		};
+
+		/**
+		 * Blur a surface in place.
+		 *
+		 * \param surface the surface to blur
+		 * \param sigma the standard deviation of the blur, in pixels; 0 or less does nothing
+		 * \param mode whether to use an exact Gaussian or the box approximation
+		 * \param parallel whether to split the work across CPU cores
+		 * \param space the space colour is mixed in
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool Blur(Surface& surface, float sigma, BlurMode mode = BlurMode::GAUSSIAN, bool parallel = true, ColourSpace space = ColourSpace::SRGB);
+
+		/**
+		 * Average every pixel with its neighbours in a square in place.
+		 *
+		 * \param surface the surface to blur
+		 * \param radius the number of pixels either side included in the average
+		 * \param passes the number of times to repeat the blur; three passes closely
+		 *               approximate a Gaussian
+		 * \param parallel whether to split the work across CPU cores
+		 * \param space the space colour is mixed in
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool BoxBlur(Surface& surface, int radius, int passes = 1, bool parallel = true, ColourSpace space = ColourSpace::SRGB);
+
+		/**
+		 * Sharpen a surface in place with an unsharp mask.
+		 *
+		 * Each colour channel becomes src + amount * (src - blurred). Alpha is left
+		 * unchanged.
+		 *
+		 * \param surface the surface to sharpen
+		 * \param amount how strongly differences from the blurred image are boosted
+		 * \param sigma the standard deviation of the blur used to find detail
+		 * \param parallel whether to split the work across CPU cores
+		 * \param space the space colour is mixed in
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool Sharpen(Surface& surface, float amount, float sigma = 1.0f, bool parallel = true, ColourSpace space = ColourSpace::SRGB);
+
+		/**
+		 * Grow the opaque areas of a mask in place, taking the maximum over a square.
+		 *
+		 * Only the alpha channel is changed; surfaces without alpha have every
+		 * channel dilated.
+		 *
+		 * \param surface the mask to dilate
+		 * \param radius the number of pixels either side considered
+		 * \param parallel whether to split the work across CPU cores
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool Dilate(Surface& surface, int radius, bool parallel = true);
+
+		/**
+		 * Shrink the opaque areas of a mask in place, taking the minimum over a square.
+		 *
+		 * Only the alpha channel is changed; surfaces without alpha have every
+		 * channel eroded.
+		 *
+		 * \param surface the mask to erode
+		 * \param radius the number of pixels either side considered
+		 * \param parallel whether to split the work across CPU cores
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool Erode(Surface& surface, int radius, bool parallel = true);
+
+		/**
+		 * Get how far a shadow made by DropShadow() extends past each edge of its source.
+		 *
+		 * \param sigma the blur of the shadow
+		 * \param spread how far the shadow is grown before blurring
+		 * \returns the padding, in pixels
+		 */
+		int ShadowPadding(float sigma, int spread = 0);
+
+		/**
+		 * Create a soft shadow from the alpha of a surface.
+		 *
+		 * The result is an ARGB8888 surface with blend mode BLEND, padded by
+		 * ShadowPadding(sigma, spread) pixels on every side, so blitting it at the
+		 * source's position minus the padding (plus any offset) lines it up. Its
+		 * colour is `colour`, and its alpha is the source alpha, dilated by spread,
+		 * blurred by sigma and scaled by colour.a. Colour keyed sources use their
+		 * key as transparency.
+		 *
+		 * \param surface the surface casting the shadow
+		 * \param sigma the standard deviation of the blur, in pixels
+		 * \param colour the colour and opacity of the shadow
+		 * \param spread how far to grow the shape before blurring, in pixels
+		 * \param mode whether to use an exact Gaussian or the box approximation
+		 * \param parallel whether to split the work across CPU cores
+		 * \returns the shadow, or an invalid surface on failure; call
+		 *          SDL::GetError() for more information.
+		 */
+		Surface DropShadow(const Surface& surface, float sigma, const Colour& colour, int spread = 0, BlurMode mode = BlurMode::BOX, bool parallel = true);
+
+		/**
+		 * Create a glow around the shape of a surface.
+		 *
+		 * This is a DropShadow() grown by radius, meant to be blitted without an
+		 * offset.
+		 *
+		 * \param surface the surface to glow around
+		 * \param radius how far the solid part of the glow extends, in pixels
+		 * \param sigma the softness of the glow's edge
+		 * \param colour the colour and opacity of the glow
+		 * \param parallel whether to split the work across CPU cores
+		 * \returns the glow, or an invalid surface on failure; call
+		 *          SDL::GetError() for more information.
+		 */
+		inline Surface Glow(const Surface& surface, int radius, float sigma, const Colour& colour, bool parallel = true)
+			{ return DropShadow(surface, sigma, colour, radius, BlurMode::BOX, parallel); }
+	}
+}
+
+#endif
+#endif
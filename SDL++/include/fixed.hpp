@@ -0,0 +1,423 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+#ifndef SDL_fixed_hpp_
+#define SDL_fixed_hpp_
+#pragma once
+
+#include <SDL_stdinc.h>
+
+#include "rect.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+namespace SDL
+{
+	/**
+	 *  \brief    A signed fixed point number with Q fractional bits, stored in 32 bits.
+	 *
+	 *  \details  Every operation is done with integers, so results are the same on every compiler and CPU, unlike
+	 *            float results, which can change with instruction selection, fused multiply-adds and excess
+	 *            precision. This makes FixedPoint suitable for simulations that must stay in step between machines,
+	 *            such as lockstep multiplayer.
+	 *
+	 *            Products round to nearest, and quotients truncate towards zero, both through 64-bit intermediates.
+	 *            Results outside the range of 32 bits wrap, as unsigned integers do, including converting an int out of
+	 *            range, lowest().abs() and lowest() / -1; only dividing by zero is undefined.
+	 *            Only conversion from float depends on floating point, so values from outside the simulation should
+	 *            be converted once, up front.
+	 */
+	template <int Q>
+	struct FixedPoint
+	{
+		static_assert(Q > 0 && Q < 31, "FixedPoint needs between 1 and 30 fractional bits");
+
+		static constexpr int FRACTION_BITS = Q;
+		static constexpr Sint32 ONE = Sint32(1) << Q;
+
+		Sint32 raw;
+
+		inline constexpr FixedPoint() : raw(0) {}
+		inline constexpr FixedPoint(int v) : raw(Sint32(Uint32(v) << Q)) {}
+		inline explicit constexpr FixedPoint(float v) : raw(Sint32(v * ONE + (v < 0 ? -0.5f : 0.5f))) {}
+		inline explicit constexpr FixedPoint(double v) : raw(Sint32(v * ONE + (v < 0 ? -0.5 : 0.5))) {}
+
+		inline static constexpr FixedPoint FromRaw(Sint32 raw) { FixedPoint f; f.raw = raw; return f; }
+
+		// Convert a 64-bit value with Q fractional bits, wrapping it to 32 bits.
+		inline static constexpr FixedPoint FromRaw64(Sint64 raw) { return FromRaw(Sint32(Uint32(raw))); }
+
+		// Convert a value with 30 fractional bits, rounding to nearest.
+		inline static constexpr FixedPoint FromQ30(Sint64 v)
+		{
+			if constexpr (Q == 30) return FromRaw64(v);
+			else return FromRaw64((v + (Sint64(1) << (29 - Q))) >> (30 - Q));
+		}
+
+		// The product of two values as a 64-bit value with Q fractional bits, rounded to nearest, which cannot overflow.
+		inline static constexpr Sint64 Product64(const FixedPoint& a, const FixedPoint& b) { return (Sint64(a.raw) * b.raw + (Sint64(1) << (Q - 1))) >> Q; }
+
+		inline constexpr explicit operator float() const { return float(raw) * (1.f / ONE); }
+		inline constexpr explicit operator double() const { return double(raw) * (1.0 / ONE); }
+		inline constexpr float toFloat() const { return float(raw) * (1.f / ONE); }
+
+		operator std::string() const { return std::to_string(toFloat()); }
+
+		inline constexpr int floor() const { return raw >> Q; }
+		inline constexpr int ceil() const { return Sint32((Sint64(raw) + ONE - 1) >> Q); }
+		inline constexpr int round() const { return Sint32((Sint64(raw) + ONE / 2) >> Q); }
+		inline constexpr FixedPoint abs() const { return raw < 0 ? -*this : *this; }
+		inline constexpr FixedPoint frac() const { return FromRaw(raw & (ONE - 1)); }
+
+		inline static constexpr FixedPoint min(const FixedPoint& a, const FixedPoint& b) { return a.raw < b.raw ? a : b; }
+		inline static constexpr FixedPoint max(const FixedPoint& a, const FixedPoint& b) { return a.raw > b.raw ? a : b; }
+		inline static constexpr FixedPoint clamp(const FixedPoint& v, const FixedPoint& lo, const FixedPoint& hi) { return min(max(v, lo), hi); }
+
+		// The smallest and largest values, and the smallest step between values.
+		inline static constexpr FixedPoint lowest() { return FromRaw(std::numeric_limits<Sint32>::min()); }
+		inline static constexpr FixedPoint highest() { return FromRaw(std::numeric_limits<Sint32>::max()); }
+		inline static constexpr FixedPoint epsilon() { return FromRaw(1); }
+
+		inline constexpr FixedPoint operator+() const { return *this; }
+		inline constexpr FixedPoint operator-() const { return FromRaw(Sint32(0u - Uint32(raw))); }
+
+		inline constexpr FixedPoint operator+(const FixedPoint& v) const { return FromRaw(Sint32(Uint32(raw) + Uint32(v.raw))); }
+		inline constexpr FixedPoint operator-(const FixedPoint& v) const { return FromRaw(Sint32(Uint32(raw) - Uint32(v.raw))); }
+		inline constexpr FixedPoint operator*(const FixedPoint& v) const { return FromRaw64(Product64(*this, v)); }
+		inline constexpr FixedPoint operator/(const FixedPoint& v) const { return FromRaw64(Sint64(raw) * ONE / v.raw); }
+
+		inline constexpr FixedPoint operator*(int m) const { return FromRaw(Sint32(Uint32(raw) * Uint32(m))); }
+		inline constexpr FixedPoint operator/(int m) const { return FromRaw64(Sint64(raw) / m); }
+
+		inline constexpr FixedPoint& operator+=(const FixedPoint& v) { return *this = *this + v; }
+		inline constexpr FixedPoint& operator-=(const FixedPoint& v) { return *this = *this - v; }
+		inline constexpr FixedPoint& operator*=(const FixedPoint& v) { return *this = *this * v; }
+		inline constexpr FixedPoint& operator/=(const FixedPoint& v) { return *this = *this / v; }
+		inline constexpr FixedPoint& operator*=(int m) { return *this = *this * m; }
+		inline constexpr FixedPoint& operator/=(int m) { return *this = *this / m; }
+
+		inline constexpr bool operator==(const FixedPoint& v) const { return raw == v.raw; }
+		inline constexpr bool operator!=(const FixedPoint& v) const { return raw != v.raw; }
+		inline constexpr bool operator< (const FixedPoint& v) const { return raw <  v.raw; }
+		inline constexpr bool operator<=(const FixedPoint& v) const { return raw <= v.raw; }
+		inline constexpr bool operator> (const FixedPoint& v) const { return raw >  v.raw; }
+		inline constexpr bool operator>=(const FixedPoint& v) const { return raw >= v.raw; }
+	};
+
+	template <int Q> inline constexpr FixedPoint<Q> operator*(int m, const FixedPoint<Q>& v) { return v * m; }
+
+	// The integer square root of a 64-bit value, rounded down.
+	inline constexpr Uint64 ISqrt(Uint64 v)
+	{
+		Uint64 result = 0;
+		Uint64 bit = Uint64(1) << 62;
+		while (bit > v) bit >>= 2;
+
+		while (bit != 0)
+		{
+			if (v >= result + bit)
+			{
+				v -= result + bit;
+				result = (result >> 1) + bit;
+			}
+			else result >>= 1;
+			bit >>= 2;
+		}
+		return result;
+	}
+
+	// The square root of a fixed point number, rounded down, or 0 for negative numbers.
+	template <int Q>
+	inline constexpr FixedPoint<Q> Sqrt(const FixedPoint<Q>& v) { return v.raw <= 0 ? FixedPoint<Q>() : FixedPoint<Q>::FromRaw(Sint32(ISqrt(Uint64(v.raw) << Q))); }
+
+	/**
+	 * An integer sine, by looking it up in a table and interpolating.
+	 *
+	 * \param angle the angle, where 2^32 is a whole turn, so that it wraps by
+	 *              itself when it overflows
+	 * \returns the sine with 30 fractional bits, within about 5e-6.
+	 */
+	Sint32 BinarySine(Uint32 angle);
+
+	// Convert an angle in radians to a binary angle, where 2^32 is a whole turn.
+	template <int Q>
+	inline constexpr Uint32 BinaryAngle(const FixedPoint<Q>& radians) { return Uint32((Sint64(radians.raw) * 683565276) >> Q); } // 2^32 / 2pi
+
+	// The sine of an angle in radians.
+	template <int Q>
+	inline FixedPoint<Q> Sin(const FixedPoint<Q>& angle) { return FixedPoint<Q>::FromQ30(BinarySine(BinaryAngle(angle))); }
+
+	// The cosine of an angle in radians.
+	template <int Q>
+	inline FixedPoint<Q> Cos(const FixedPoint<Q>& angle) { return FixedPoint<Q>::FromQ30(BinarySine(BinaryAngle(angle) + 0x40000000u)); }
+
+	// Fixed point with 16 integer and 16 fractional bits, covering +-32768 in steps of about 1.5e-5.
+	typedef FixedPoint<16> Fixed;
+
+	/**
+	 *  \brief    A point or vector with Fixed coordinates, mirroring FPoint.
+	 *
+	 *  \details  Lengths are worked out with 64-bit intermediates, so mag() and norm() work for any vector in
+	 *            range. sqrMag(), dot() and cross() can be far outside the range of Fixed, so they return 64-bit
+	 *            values with Fixed's fractional bits instead, to compare with each other or with Fixed::Product64().
+	 *            Casting to FPoint gives the coordinates as floats, for rendering.
+	 */
+	struct XPoint
+	{
+		Fixed x, y;
+
+		inline constexpr XPoint() : x(0), y(0) {}
+		inline constexpr XPoint(Fixed x, Fixed y) : x(x), y(y) {}
+		inline constexpr XPoint(int x, int y) : x(x), y(y) {}
+		inline constexpr XPoint(const XPoint& v) : x(v.x), y(v.y) {}
+		inline constexpr XPoint(const Point& v) : x(v.x), y(v.y) {}
+		inline explicit constexpr XPoint(const FPoint& v) : x(v.x), y(v.y) {}
+
+		inline constexpr XPoint& operator=(const XPoint& v) { x = v.x; y = v.y; return *this; }
+
+		inline constexpr explicit operator FPoint() const { return FPoint(x.toFloat(), y.toFloat()); }
+		operator std::string() const { return "(" + (std::string)x + ", " + (std::string)y + ")"; }
+
+		// A vector of a given length, at an angle in radians.
+		inline static XPoint FromAngle(Fixed angle, Fixed mag = 1) { return XPoint(Cos(angle) * mag, Sin(angle) * mag); }
+
+		inline constexpr Sint64 sqrMag() const { return Fixed::Product64(x, x) + Fixed::Product64(y, y); }
+		inline constexpr Fixed min() const { return Fixed::min(x, y); }
+		inline constexpr Fixed max() const { return Fixed::max(x, y); }
+		inline constexpr Fixed mag() const { return Fixed::FromRaw64(Sint64(ISqrt(Uint64(Sint64(x.raw) * x.raw) + Uint64(Sint64(y.raw) * y.raw)))); }
+
+		inline constexpr bool nonZero() const { return x.raw != 0 || y.raw != 0; }
+
+		inline constexpr XPoint rotate(Fixed rotx, Fixed roty) const { return XPoint(x * rotx - y * roty, x * roty + y * rotx); }
+		inline constexpr XPoint rotateAround(XPoint center, Fixed rotx, Fixed roty) const { return (*this - center).rotate(rotx, roty) + center; }
+		inline XPoint rotate(Fixed a) const { return rotate(Cos(a), Sin(a)); }
+		inline XPoint rotateAround(XPoint center, Fixed a) const { return (*this - center).rotate(a) + center; }
+		inline constexpr XPoint perp() const { return XPoint(-y, x); }
+		inline constexpr XPoint abs() const { return XPoint(x.abs(), y.abs()); }
+		inline constexpr XPoint norm() const { const Fixed size = mag(); return size.raw == 0 ? XPoint() : XPoint(x / size, y / size); }
+
+		inline constexpr Point floor() const { return Point(x.floor(), y.floor()); }
+		inline constexpr Point round() const { return Point(x.round(), y.round()); }
+		inline constexpr Point ceil()  const { return Point(x.ceil(),  y.ceil()); }
+
+		inline constexpr XPoint clamp(Fixed x1, Fixed x2, Fixed y1, Fixed y2) const { return XPoint(Fixed::clamp(x, x1, x2), Fixed::clamp(y, y1, y2)); }
+		inline constexpr XPoint clampX(Fixed x1, Fixed x2) const { return XPoint(Fixed::clamp(x, x1, x2), y); }
+		inline constexpr XPoint clampY(Fixed y1, Fixed y2) const { return XPoint(x, Fixed::clamp(y, y1, y2)); }
+
+		// Scale the vector so its length is between r1 and r2.
+		inline constexpr XPoint clampR(Fixed r1, Fixed r2) const
+		{
+			const Fixed size = mag();
+			const Fixed r = Fixed::clamp(size, r1, r2);
+			return size == r || size.raw == 0 ? *this : XPoint(x * r / size, y * r / size);
+		}
+
+		inline static constexpr Sint64 dot(const XPoint& v1, const XPoint& v2) { return Fixed::Product64(v1.x, v2.x) + Fixed::Product64(v1.y, v2.y); }
+		inline static constexpr Sint64 cross(const XPoint& v1, const XPoint& v2) { return Fixed::Product64(v1.y, v2.x) - Fixed::Product64(v1.x, v2.y); }
+		inline static constexpr XPoint min(const XPoint& v1, const XPoint& v2) { return XPoint(Fixed::min(v1.x, v2.x), Fixed::min(v1.y, v2.y)); }
+		inline static constexpr XPoint max(const XPoint& v1, const XPoint& v2) { return XPoint(Fixed::max(v1.x, v2.x), Fixed::max(v1.y, v2.y)); }
+
+		inline constexpr XPoint operator+() const { return *this; }
+		inline constexpr XPoint operator-() const { return XPoint(-x, -y); }
+
+		inline constexpr XPoint operator+(const XPoint& v) const { return XPoint(x + v.x, y + v.y); }
+		inline constexpr XPoint operator-(const XPoint& v) const { return XPoint(x - v.x, y - v.y); }
+		inline constexpr XPoint operator*(const XPoint& v) const { return XPoint(x * v.x, y * v.y); }
+		inline constexpr XPoint operator/(const XPoint& v) const { return XPoint(x / v.x, y / v.y); }
+
+		inline constexpr XPoint operator*(Fixed m) const { return XPoint(x * m, y * m); }
+		inline constexpr XPoint operator/(Fixed m) const { return XPoint(x / m, y / m); }
+		inline constexpr XPoint operator*(int m) const { return XPoint(x * m, y * m); }
+		inline constexpr XPoint operator/(int m) const { return XPoint(x / m, y / m); }
+
+		inline constexpr XPoint& operator+=(const XPoint& v) { x += v.x; y += v.y; return *this; }
+		inline constexpr XPoint& operator-=(const XPoint& v) { x -= v.x; y -= v.y; return *this; }
+		inline constexpr XPoint& operator*=(const XPoint& v) { x *= v.x; y *= v.y; return *this; }
+		inline constexpr XPoint& operator/=(const XPoint& v) { x /= v.x; y /= v.y; return *this; }
+
+		inline constexpr XPoint& operator*=(Fixed m) { x *= m; y *= m; return *this; }
+		inline constexpr XPoint& operator/=(Fixed m) { x /= m; y /= m; return *this; }
+		inline constexpr XPoint& operator*=(int m) { x *= m; y *= m; return *this; }
+		inline constexpr XPoint& operator/=(int m) { x /= m; y /= m; return *this; }
+
+		inline constexpr bool operator==(const XPoint& v) const { return x == v.x && y == v.y; }
+		inline constexpr bool operator!=(const XPoint& v) const { return x != v.x || y != v.y; }
+	};
+
+	inline constexpr XPoint operator*(Fixed m, const XPoint& v) { return v * m; }
+	inline constexpr XPoint operator*(int m, const XPoint& v) { return v * m; }
+
+	/**
+	 *  \brief    A rectangle with Fixed position and size, mirroring FRect.
+	 *
+	 *  \details  Unlike FRect, the position and size are only reachable as pos and size, not as x, y, w and h
+	 *            too, since that needs anonymous structs of types with constructors, which not every compiler
+	 *            allows. area() and perimeter() return 64-bit values with Fixed's fractional bits, as they can be
+	 *            far outside the range of Fixed. Casting to FRect gives the rectangle in floats, for rendering.
+	 */
+	struct XRect
+	{
+		XPoint pos, size;
+
+		inline constexpr XRect() : pos(), size() {}
+		inline constexpr XRect(Fixed x, Fixed y, Fixed w, Fixed h) : pos(x, y), size(w, h) {}
+		inline constexpr XRect(Fixed x, Fixed y, const XPoint& size) : pos(x, y), size(size) {}
+		inline constexpr XRect(const XPoint& pos, Fixed w, Fixed h) : pos(pos), size(w, h) {}
+		inline constexpr XRect(const XPoint& pos, const XPoint& size) : pos(pos), size(size) {}
+		inline constexpr XRect(const XRect& rect) : pos(rect.pos), size(rect.size) {}
+		inline constexpr XRect(const Rect& rect) : pos(rect.pos), size(rect.size) {}
+		inline explicit constexpr XRect(const FRect& rect) : pos(rect.pos), size(rect.size) {}
+
+		inline constexpr XRect& operator=(const XRect& rect) { pos = rect.pos; size = rect.size; return *this; }
+
+		inline constexpr explicit operator FRect() const { return FRect((FPoint)pos, (FPoint)size); }
+		operator std::string() const { return "(" + (std::string)pos.x + ", " + (std::string)pos.y + ", " + (std::string)size.x + ", " + (std::string)size.y + ")"; }
+
+		inline constexpr bool  empty() const { return size.x.raw <= 0 || size.y.raw <= 0; }
+		inline constexpr Sint64 area() const { return Fixed::Product64(size.x, size.y); }
+		inline constexpr Sint64 perimeter() const { return (Sint64(size.x.raw) + size.y.raw) * 2; }
+		inline constexpr Fixed diagonal() const { return size.mag(); }
+
+		inline constexpr Rect floor() const { return Rect(pos.floor(), (pos + size).floor() - pos.floor()); }
+		inline constexpr Rect round() const { return Rect(pos.round(), (pos + size).round() - pos.round()); }
+		inline constexpr Rect ceil()  const { return Rect(pos.ceil(),  (pos + size).ceil()  - pos.ceil()); }
+
+		inline constexpr XPoint normToPoint(XPoint v) const { return (v * size) + pos; }
+		inline constexpr XPoint pointToNorm(XPoint v) const { return (v - pos) / size; }
+
+		inline constexpr XPoint topLeft() const { return pos; }
+		inline constexpr XPoint topRight() const { return pos + XPoint(size.x, 0); }
+		inline constexpr XPoint bottomLeft() const { return pos + XPoint(0, size.y); }
+		inline constexpr XPoint bottomRight() const { return pos + size; }
+		inline constexpr XPoint middle() const { return pos + size / 2; }
+
+		inline constexpr XPoint clamp(const XPoint& v) const { return v.clamp(pos.x, pos.x + size.x, pos.y, pos.y + size.y); }
+
+		inline constexpr bool contains(const XPoint& v) const { return v.x > pos.x && v.y > pos.y && v.x < pos.x + size.x && v.y < pos.y + size.y; }
+
+		inline constexpr XRect operator+(const XPoint& v) const { return { pos + v, size }; }
+		inline constexpr XRect operator-(const XPoint& v) const { return { pos - v, size }; }
+
+		inline constexpr XRect operator*(const XPoint& v) const { return { pos, size * v }; }
+		inline constexpr XRect operator/(const XPoint& v) const { return { pos, size / v }; }
+		inline constexpr XRect operator*(Fixed m) const { return { pos, size * m }; }
+		inline constexpr XRect operator/(Fixed m) const { return { pos, size / m }; }
+		inline constexpr XRect operator*(int m) const { return { pos, size * m }; }
+		inline constexpr XRect operator/(int m) const { return { pos, size / m }; }
+
+		inline constexpr XRect& operator+=(const XPoint& v) { pos += v; return *this; }
+		inline constexpr XRect& operator-=(const XPoint& v) { pos -= v; return *this; }
+
+		inline constexpr XRect& operator*=(const XPoint& v) { size *= v; return *this; }
+		inline constexpr XRect& operator/=(const XPoint& v) { size /= v; return *this; }
+		inline constexpr XRect& operator*=(Fixed m) { size *= m; return *this; }
+		inline constexpr XRect& operator/=(Fixed m) { size /= m; return *this; }
+		inline constexpr XRect& operator*=(int m) { size *= m; return *this; }
+		inline constexpr XRect& operator/=(int m) { size /= m; return *this; }
+
+		inline constexpr bool operator==(const XRect& r) const { return pos == r.pos && size == r.size; }
+		inline constexpr bool operator!=(const XRect& r) const { return pos != r.pos || size != r.size; }
+	};
+
+	inline constexpr bool RectsIntersect(const XRect& A, const XRect& B) { return !A.empty() && !B.empty() && A.pos.x + A.size.x > B.pos.x && A.pos.x < B.pos.x + B.size.x && A.pos.y + A.size.y > B.pos.y && A.pos.y < B.pos.y + B.size.y; }
+
+	inline constexpr XRect RectIntersection(const XRect& A, const XRect& B)
+	{
+		if (!RectsIntersect(A, B)) return {};
+
+		const XPoint top_left = XPoint::max(A.topLeft(), B.topLeft());
+		const XPoint bottom_right = XPoint::min(A.bottomRight(), B.bottomRight());
+
+		return { top_left, bottom_right - top_left };
+	}
+
+	inline constexpr XRect RectUnion(const XRect& A, const XRect& B)
+	{
+		if (A.empty()) {
+			if (B.empty()) return {};
+			else return B;
+		}
+		else if (B.empty()) return A;
+
+		const XPoint top_left = XPoint::min(A.topLeft(), B.topLeft());
+		const XPoint bottom_right = XPoint::max(A.bottomRight(), B.bottomRight());
+
+		return { top_left, bottom_right - top_left };
+	}
+
+	/**
+	 *  \brief    A ray with Fixed origin and direction, mirroring Ray.
+	 */
+	struct XRay
+	{
+		struct Contact
+		{
+			bool contact = false;
+			XPoint point = { 0, 0 };
+			XPoint normal = { 0, 0 };
+			Fixed time = 0;
+		};
+
+		XPoint origin;
+		XPoint dir;
+
+		inline constexpr XRay() : origin(0, 0), dir(0, 0) {}
+		inline constexpr XRay(XPoint origin, XPoint dir) : origin(origin), dir(dir) {}
+
+		inline operator std::string() const { return "(" + (std::string)origin + " -> " + (std::string)dir + ")"; }
+
+		/**
+		 * Find where the ray, from origin to origin + dir, first meets a
+		 * rectangle.
+		 *
+		 * This matches Ray::IntersectRect(): the time is the proportion of dir
+		 * travelled, and is negative if the ray starts inside the rectangle.
+		 * Rays along an axis are handled too, hitting the rectangle if they
+		 * pass strictly between its sides.
+		 *
+		 * \param rect the rectangle to test
+		 * \returns the contact, or one with contact set to false.
+		 */
+		inline constexpr Contact IntersectRect(const XRect& rect) const
+		{
+			if (!dir.nonZero() || rect.empty()) return { false };
+
+			// Times along the ray, as 64-bit values with Fixed's fractional bits, so they cannot overflow
+			constexpr Sint64 NONE = Sint64(1) << 62;
+			Sint64 nearX = -NONE, farX = NONE, nearY = -NONE, farY = NONE;
+
+			auto slab = [](Fixed lo, Fixed hi, Fixed o, Fixed d, Sint64& tNear, Sint64& tFar)
+			{
+				if (d.raw == 0) return o > lo && o < hi;
+
+				tNear = (Sint64(lo.raw) - o.raw) * Fixed::ONE / d.raw;
+				tFar = (Sint64(hi.raw) - o.raw) * Fixed::ONE / d.raw;
+				if (tNear > tFar) std::swap(tNear, tFar);
+				return true;
+			};
+
+			if (!slab(rect.pos.x, rect.pos.x + rect.size.x, origin.x, dir.x, nearX, farX)) return { false };
+			if (!slab(rect.pos.y, rect.pos.y + rect.size.y, origin.y, dir.y, nearY, farY)) return { false };
+
+			const Sint64 tNear = std::max(nearX, nearY);
+			const Sint64 tFar = std::min(farX, farY);
+			if (tNear > tFar || tNear > Fixed::ONE || tFar < 0) return { false };
+
+			Contact hit;
+			hit.contact = true;
+			hit.time = Fixed::FromRaw64(std::max<Sint64>(tNear, std::numeric_limits<Sint32>::min()));
+			hit.point = origin + dir * hit.time;
+
+			if (nearX >= nearY) hit.normal.x = dir.x.raw < 0 ? 1 : -1;
+			if (nearX <= nearY) hit.normal.y = dir.y.raw < 0 ? 1 : -1;
+
+			return hit;
+		}
+
+		inline constexpr Contact IntersectRect(const Rect& rect) const { return IntersectRect(XRect(rect)); }
+	};
+}
+
+#endif
+#endif
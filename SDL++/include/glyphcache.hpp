@@ -0,0 +1,110 @@
+#include <SDL_ttf.h>
+#ifdef SDL_TTF_VERSION_ATLEAST
+#if SDL_TTF_VERSION_ATLEAST(2,0,18)
+#ifndef SDL_glyphcache_hpp_
+#define SDL_glyphcache_hpp_
+#pragma once
+
+#include "SDL_ttf.hpp"
+#include "pixels.hpp"
+#include "rect.hpp"
+#include "surface.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace SDL::TTF
+{
+	/**
+	 *  \brief    Draws text straight onto surfaces from an atlas of cached glyph coverage.
+	 *
+	 *  \details  Each glyph is rendered once with Font::RenderGlyph32_Blended(), trimmed to the pixels it covers and
+	 *            packed into an 8-bit atlas. Drawing a string merges the glyphs' coverage a line at a time and blends
+	 *            it, tinted with the text colour, straight into the destination with SIMD, so no surface is created
+	 *            per string and nothing is allocated once the glyphs are cached and the line buffers have grown to fit.
+	 *
+	 *            Text is placed as Font::RenderUTF8_Blended() places it, with pos at the top left of the first
+	 *            line, and '\n' starts a new line Font::LineSkip() below. Kerning is applied if the font allows it.
+	 *            Glyphs sit on whole pixels, so text can be a pixel off from what SDL_ttf renders with subpixel
+	 *            positioning. Call Clear() after changing the font's size, style, outline or hinting.
+	 */
+	struct GlyphCache
+	{
+		struct Glyph
+		{
+			Rect area;    // The glyph's coverage in the atlas, empty for glyphs that cover nothing
+			Point offset; // The position of area's top left relative to the pen at the top of the line
+			int advance;  // How far the pen moves after the glyph
+		};
+
+		Font font;
+		Surface atlas = Surface::FromPtr(NULL); // The coverage of every cached glyph, as an 8-bit surface with a grey ramp palette
+		std::unordered_map<Uint32, Glyph> glyphs;
+
+		Point cursor;        // Where the next glyph is packed in the atlas
+		int shelfHeight = 0; // The height of the row of glyphs cursor is on
+
+		std::vector<std::pair<const Glyph*, int>> placed; // The glyphs of the line being drawn and their pens, reused between calls
+		std::vector<Uint8> strip;                         // The merged coverage of the line being drawn, reused between calls
+
+		/**
+		 *  \brief    Create an empty cache for a font.
+		 *
+		 *  \param    font:        The font to render glyphs with.
+		 *  \param    atlas_width: The width of the atlas. Its height grows as glyphs are added.
+		 */
+		GlyphCache(const Font& font, int atlas_width = 256);
+
+		/**
+		 * Get a glyph, rendering and caching it if it is not cached yet.
+		 *
+		 * \param ch the character code of the glyph
+		 * \returns the glyph, or NULL if the font cannot render it; call
+		 *          SDL::GetError() for more information.
+		 */
+		const Glyph* GetGlyph(Uint32 ch);
+
+		/**
+		 * Cache every glyph in a UTF-8 string ahead of time.
+		 *
+		 * \returns true on success or false if any glyph could not be rendered;
+		 *          call SDL::GetError() for more information.
+		 */
+		bool Preload(const char* text);
+		inline bool Preload(const std::string& text) { return Preload(text.c_str()); }
+
+		/**
+		 * Calculate the size a UTF-8 string is drawn at.
+		 *
+		 * \returns the width of the widest line and the height of every line.
+		 */
+		Point MeasureUTF8(const char* text);
+		inline Point MeasureUTF8(const std::string& text) { return MeasureUTF8(text.c_str()); }
+
+		/**
+		 * Draw a UTF-8 string onto a surface.
+		 *
+		 * The text is blended as with BlendMode::BLEND, using premultiplied
+		 * arithmetic if dst is premultiplied, and is clipped to dst's clip
+		 * rectangle. Characters the font cannot render are skipped.
+		 *
+		 * \param dst the surface to draw on, in a 32-bit format with 8-bit channels
+		 * \param text the string to draw
+		 * \param pos the position of the top left of the first line on dst
+		 * \param colour the colour of the text, including its opacity
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool DrawUTF8(Surface& dst, const char* text, const Point& pos, Colour colour);
+		inline bool DrawUTF8(Surface& dst, const std::string& text, const Point& pos, Colour colour) { return DrawUTF8(dst, text.c_str(), pos, colour); }
+
+		// Forget every cached glyph and empty the atlas.
+		void Clear();
+	};
+}
+
+#endif
+#endif
+#endif
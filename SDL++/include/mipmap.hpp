@@ -0,0 +1,230 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+#ifndef SDL_mipmap_hpp_
+#define SDL_mipmap_hpp_
+#pragma once
+
+#include "rect.hpp"
+#include "render.hpp"
+#include "surface.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace SDL
+{
+	// A texture with a chain of progressively halved levels, which are chosen from when drawing
+	// so that heavily minified copies sample a pre-filtered image instead of aliasing.
+	struct MipTexture
+	{
+		// The textures for each level, the first being full size
+		std::vector<Texture> levels;
+
+		// The size of the full size level
+		Point size;
+
+		inline MipTexture() : levels(), size() {}
+
+		/**
+		 *  \brief    Create a mipmapped texture from a surface.
+		 *
+		 *  \param    renderer:   The rendering context.
+		 *  \param    surface:    The full size image. Its mip chain is built with Surface::BuildMipChain().
+		 *  \param    space:      The colour space the levels are averaged in.
+		 *  \param    max_levels: The maximum number of levels, including the full size level, or 0 for a full chain.
+		 *
+		 *  \note     If creation fails levels is left empty; call SDL::GetError() for more information.
+		 */
+		inline MipTexture(Renderer& renderer, const Surface& surface, FilterSpace space = FilterSpace::PREMULTIPLIED, int max_levels = 0)
+			: MipTexture()
+		{
+			std::vector<Surface> chain = surface.BuildMipChain(space, max_levels);
+			levels.reserve(chain.size());
+
+			for (Surface& level : chain)
+			{
+				Texture txt(renderer, level);
+				if (txt.texture == nullptr)
+				{
+					levels.clear();
+					return;
+				}
+				levels.push_back(txt);
+			}
+
+			if (!chain.empty()) size = { chain[0].surface->w, chain[0].surface->h };
+		}
+
+		/**
+		 *  \brief    Choose the level to sample when a region is drawn at a given size.
+		 *
+		 *  \param    src: The size of the region of the full size level being drawn.
+		 *  \param    dst: The size it is drawn at on the rendering target.
+		 *
+		 *  \return   The index of the largest level that is not magnified along its less minified axis.
+		 */
+		inline int SelectLevel(const FPoint& src, const FPoint& dst) const
+		{
+			if (levels.size() <= 1 || dst.x <= 0 || dst.y <= 0) return 0;
+
+			const float scale = std::min(std::abs(src.x / dst.x), std::abs(src.y / dst.y));
+			if (scale < 2.0f) return 0;
+
+			return std::min((int)std::floor(std::log2(scale)), (int)levels.size() - 1);
+		}
+
+		/**
+		 *  \brief    Map a region of the full size level onto a level.
+		 *
+		 *  \param    src:   The region of the full size level.
+		 *  \param    level: The index of the level.
+		 *
+		 *  \return   The region of the level covering the same part of the image, at least 1x1 pixels.
+		 */
+		inline Rect LevelRect(const Rect& src, int level) const
+		{
+			if (level <= 0) return src;
+
+			const Point max = { std::max(1, size.w >> level), std::max(1, size.h >> level) };
+			const int x1 = std::clamp(src.x >> level, 0, max.x - 1);
+			const int y1 = std::clamp(src.y >> level, 0, max.y - 1);
+			const int x2 = std::clamp((src.x + src.w + (1 << level) - 1) >> level, x1 + 1, max.x);
+			const int y2 = std::clamp((src.y + src.h + (1 << level) - 1) >> level, y1 + 1, max.y);
+
+			return Rect(x1, y1, x2 - x1, y2 - y1);
+		}
+
+		// Set an additional colour value multiplied into render copy operations on every level.
+		inline bool SetColourMod(Uint8 r, Uint8 g, Uint8 b)
+		{
+			bool success = !levels.empty();
+			for (Texture& level : levels) success &= level.SetColourMod(r, g, b);
+			return success;
+		}
+
+		// Set an additional alpha value multiplied into render copy operations on every level.
+		inline bool SetAlphaMod(Uint8 alpha)
+		{
+			bool success = !levels.empty();
+			for (Texture& level : levels) success &= level.SetAlphaMod(alpha);
+			return success;
+		}
+
+		// Set the blend mode used for texture copy operations on every level.
+		inline bool SetBlendMode(BlendMode blendMode)
+		{
+			bool success = !levels.empty();
+			for (Texture& level : levels) success &= level.SetBlendMode(blendMode);
+			return success;
+		}
+
+#if SDL_VERSION_ATLEAST(2, 0, 12)
+		// Set the scale mode used for texture scale operations on every level.
+		inline bool SetScaleMode(Texture::ScaleMode scaleMode)
+		{
+			bool success = !levels.empty();
+			for (Texture& level : levels) success &= level.SetScaleMode(scaleMode);
+			return success;
+		}
+#endif
+
+		/**
+		 *  \brief    Copy a portion of the image to the current rendering target, using the level best suited to the destination size.
+		 *
+		 *  \param    src: The source rectangle, in pixels of the full size level.
+		 *  \param    dst: The destination rectangle.
+		 *
+		 *  \return   true on success, or false on error
+		 */
+		inline bool Copy(const Rect& src, const Rect& dst)
+		{
+			if (levels.empty()) return false;
+			const int level = SelectLevel(src.size, dst.size);
+			return levels[level].Copy(LevelRect(src, level), dst);
+		}
+
+		/**
+		 *  \brief    Copy the image to the current rendering target, using the level best suited to the destination size.
+		 *
+		 *  \param    dst: The destination rectangle.
+		 *
+		 *  \return   true on success, or false on error
+		 */
+		inline bool Copy(const Rect& dst)
+		{
+			if (levels.empty()) return false;
+			return levels[SelectLevel(size, dst.size)].Copy(dst);
+		}
+
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+		/**
+		 *  \brief    Copy a portion of the image to the current rendering target at subpixel precision, using the level best suited to the destination size.
+		 *
+		 *  \param    src: The source rectangle, in pixels of the full size level.
+		 *  \param    dst: The destination rectangle.
+		 *
+		 *  \return   true on success, or false on error
+		 */
+		inline bool CopyF(const Rect& src, const FRect& dst)
+		{
+			if (levels.empty()) return false;
+			const int level = SelectLevel(src.size, dst.size);
+			return levels[level].CopyF(LevelRect(src, level), dst);
+		}
+
+		/**
+		 *  \brief    Copy the image to the current rendering target at subpixel precision, using the level best suited to the destination size.
+		 *
+		 *  \param    dst: The destination rectangle.
+		 *
+		 *  \return   true on success, or false on error
+		 */
+		inline bool CopyF(const FRect& dst)
+		{
+			if (levels.empty()) return false;
+			return levels[SelectLevel(size, dst.size)].CopyF(dst);
+		}
+
+		/**
+		 *  \brief    Copy a portion of the image to the current rendering target, rotating it by angle around the given center,
+		 *            using the level best suited to the destination size.
+		 *
+		 *  \param    src:      The source rectangle, in pixels of the full size level.
+		 *  \param    dst:      The destination rectangle.
+		 *  \param    center:   A point indicating the point around which dst will be rotated.
+		 *  \param    angle:    An angle in degrees that indicates the rotation that will be applied to dst, rotating it in a clockwise direction.
+		 *  \param    flipType: An Flip value stating which flipping actions should be performed on the texture.
+		 *
+		 *  \return   true on success, or false on error
+		 */
+		inline bool CopyExF(const Rect& src, const FRect& dst, const FPoint& center, double angle = 0.0, Texture::Flip flipType = Texture::Flip::NONE)
+		{
+			if (levels.empty()) return false;
+			const int level = SelectLevel(src.size, dst.size);
+			return levels[level].CopyExF(LevelRect(src, level), dst, center, angle, flipType);
+		}
+
+		/**
+		 *  \brief    Copy a portion of the image to the current rendering target, rotating it by angle around dst.w/2, dst.h/2,
+		 *            using the level best suited to the destination size.
+		 *
+		 *  \param    src:      The source rectangle, in pixels of the full size level.
+		 *  \param    dst:      The destination rectangle.
+		 *  \param    angle:    An angle in degrees that indicates the rotation that will be applied to dst, rotating it in a clockwise direction.
+		 *  \param    flipType: An Flip value stating which flipping actions should be performed on the texture.
+		 *
+		 *  \return   true on success, or false on error
+		 */
+		inline bool CopyExF(const Rect& src, const FRect& dst, double angle = 0.0, Texture::Flip flipType = Texture::Flip::NONE)
+		{
+			if (levels.empty()) return false;
+			const int level = SelectLevel(src.size, dst.size);
+			return levels[level].CopyExF(LevelRect(src, level), dst, angle, flipType);
+		}
+#endif
+	};
+}
+
+#endif
+#endif
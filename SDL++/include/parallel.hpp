@@ -0,0 +1,153 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+#ifndef SDL_parallel_hpp_
+#define SDL_parallel_hpp_
+#pragma once
+
+#include <SDL_cpuinfo.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SDL
+{
+	/**
+	 *  \brief    The worker threads ParallelFor() hands chunks to.
+	 *
+	 *  \details  Threads are started the first time that many are wanted and then kept, sleeping until the next call,
+	 *            so splitting work every frame does not start and join threads every frame. One call uses the pool
+	 *            at a time; Run() refuses a second caller, or a call from inside a chunk, instead of waiting on it.
+	 */
+	struct WorkerPool
+	{
+		std::vector<std::thread> workers;
+		std::mutex mutex;   // Guards everything below
+		std::mutex calling; // Held by the one call using the pool
+		std::condition_variable wake, finished;
+		void (*task)(void*, int) = nullptr;
+		void* context = nullptr;
+		int parts = 0, next = 0, pending = 0;
+		bool stopping = false;
+
+		inline ~WorkerPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (std::thread& worker : workers) worker.join();
+		}
+
+		// The pool shared by every ParallelFor() call
+		static inline WorkerPool& Get()
+		{
+			static WorkerPool pool;
+			return pool;
+		}
+
+		// Whether the calling thread is one of the pool's workers
+		static inline bool& IsWorker()
+		{
+			thread_local bool worker = false;
+			return worker;
+		}
+
+		/**
+		 *  \brief    Call part(i) for each i in [0, count), with part(0) on the calling thread and the rest on workers.
+		 *
+		 *  \returns  true once every part has run, or false without running any if the pool is already in use.
+		 */
+		template <typename F>
+		inline bool Run(int count, F& part)
+		{
+			if (IsWorker()) return false;
+
+			std::unique_lock<std::mutex> call(calling, std::try_to_lock);
+			if (!call.owns_lock()) return false;
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				while ((int)workers.size() < count - 1) workers.emplace_back([this]() { Work(); });
+
+				task = [](void* f, int i) { (*(F*)f)(i); };
+				context = &part;
+				parts = count;
+				next = 1;
+				pending = count - 1;
+			}
+			wake.notify_all();
+
+			part(0);
+
+			std::unique_lock<std::mutex> lock(mutex);
+			finished.wait(lock, [this]() { return pending == 0; });
+			task = nullptr;
+			context = nullptr;
+			return true;
+		}
+
+		// A worker's loop: take the next part of the current call, or sleep until there is one
+		inline void Work()
+		{
+			IsWorker() = true;
+
+			std::unique_lock<std::mutex> lock(mutex);
+			for (;;)
+			{
+				wake.wait(lock, [this]() { return stopping || next < parts; });
+				if (stopping) return;
+
+				const int i = next++;
+				lock.unlock();
+				task(context, i);
+				lock.lock();
+
+				if (--pending == 0) finished.notify_one();
+			}
+		}
+	};
+
+	/**
+	 *  \brief    Split the range [0, count) into contiguous chunks and run them on all logical CPU cores.
+	 *
+	 *  \param    count:     The number of items, such as the rows of a surface.
+	 *  \param    body:      Called as body(begin, end) for each chunk. Chunks never overlap, and one of them runs on the calling thread.
+	 *  \param    min_chunk: The smallest number of items worth handing to another thread.
+	 *
+	 *  \note     The other chunks run on the threads of WorkerPool::Get(), which are kept between calls. If there are too
+	 *            few items to split, or the pool is busy with another call (including the one this is nested in),
+	 *            body(0, count) is called on the calling thread.
+	 */
+	template <typename F>
+	inline void ParallelFor(int count, F&& body, int min_chunk = 16)
+	{
+		if (count <= 0) return;
+
+		const int threads = std::clamp(count / std::max(min_chunk, 1), 1, std::max(SDL_GetCPUCount(), 1));
+		auto part = [&body, count, threads](int i) { body((int)((long long)count * i / threads), (int)((long long)count * (i + 1) / threads)); };
+
+		if (threads == 1 || !WorkerPool::Get().Run(threads, part)) body(0, count);
+	}
+
+	/**
+	 *  \brief    Run body(begin, end) over [0, count), either split across all logical CPU cores or on the calling thread.
+	 *
+	 *  \param    parallel:  Whether the range may be split across threads.
+	 *  \param    count:     The number of items, such as the rows of a surface.
+	 *  \param    body:      Called as body(begin, end) for each chunk.
+	 *  \param    min_chunk: The smallest number of items worth handing to another thread.
+	 */
+	template <typename F>
+	inline void MaybeParallelFor(bool parallel, int count, F&& body, int min_chunk = 16)
+	{
+		if (parallel) ParallelFor(count, body, min_chunk);
+		else if (count > 0) body(0, count);
+	}
+}
+
+#endif
+#endif
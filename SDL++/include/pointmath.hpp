@@ -0,0 +1,156 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+#ifndef SDL_pointmath_hpp_
+#define SDL_pointmath_hpp_
+#pragma once
+
+#include <SDL_stdinc.h>
+
+#include "rect.hpp"
+#include "simd.hpp"
+#include "transform.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace SDL
+{
+	/**
+	 *  \brief    A set of points stored as structure of arrays, with every x in one array and every y in another.
+	 *
+	 *  \details  Both arrays are 32-byte aligned. This suits the functions in PointMath better than an array of FPoint,
+	 *            which has to be split into x and y and put back together around every operation.
+	 */
+	struct PointSoA
+	{
+		typedef std::vector<float, AlignedAllocator<float>> Array;
+
+		Array x, y;
+
+		inline PointSoA() = default;
+		inline explicit PointSoA(int n) : x(n, 0.f), y(n, 0.f) {}
+		inline PointSoA(const FPoint* points, int n) { Reserve(n); for (int i = 0; i < n; i++) Add(points[i]); }
+
+		template <typename T, typename = typename std::enable_if_t<ContinuousContainer_traits<FPoint, T>::is_continuous_container>>
+		inline PointSoA(const T& points) : PointSoA(points.data(), (int)points.size()) {}
+
+		inline int Size() const { return (int)x.size(); }
+		inline bool Empty() const { return x.empty(); }
+
+		inline void Reserve(int n) { x.reserve(n); y.reserve(n); }
+		inline void Resize(int n) { x.resize(n, 0.f); y.resize(n, 0.f); }
+		inline void Clear() { x.clear(); y.clear(); }
+
+		inline int Add(const FPoint& p) { x.push_back(p.x); y.push_back(p.y); return Size() - 1; }
+		inline void Set(int i, const FPoint& p) { x[i] = p.x; y[i] = p.y; }
+		inline FPoint Get(int i) const { return FPoint(x[i], y[i]); }
+		inline FPoint operator[](int i) const { return Get(i); }
+	};
+
+	// Operations over whole arrays of points, either FPoint arrays or PointSoA, which run 4 points at a time with
+	// SSE2 or NEON where available.
+	//
+	// Functions that write one array from others may write over one of their inputs. Those taking a Precision can
+	// trade accuracy for speed: Precision::FAST uses polynomial sines and cosines and a reciprocal square root
+	// estimate in place of cosf(), sinf(), std::sqrt() and division. With Precision::EXACT, the results match the
+	// per-point FPoint methods.
+	namespace PointMath
+	{
+		enum class Precision
+		{
+			EXACT, // As accurate as the standard library
+			FAST   // Within about 1e-6 for sines and cosines, and a relative 1e-5 for lengths
+		};
+
+		// Reduce an angle in radians to about [-pi, pi], by whole turns split into two parts so large angles stay accurate.
+		inline float ReduceAngle(float angle)
+		{
+			// Adding and taking away 1.5 * 2^23 rounds to the nearest whole number of turns, without a branch
+			const float k = (angle * 0.159154943f + 12582912.f) - 12582912.f;
+			return (angle - k * 6.28125f) - k * 1.93530717e-3f;
+		}
+
+		// An approximate sine, from a polynomial after reducing the angle to [-pi/2, pi/2].
+		inline float FastSin(float angle)
+		{
+			float x = ReduceAngle(angle);
+			x = std::min(x, 3.14159265f - x);
+			x = std::max(x, -3.14159265f - x);
+
+			const float x2 = x * x;
+			return x * (1.f + x2 * (-1.66666667e-1f + x2 * (8.33333333e-3f + x2 * (-1.98412698e-4f + x2 * (2.75573192e-6f + x2 * -2.50521084e-8f)))));
+		}
+
+		// An approximate cosine, as FastSin() a quarter turn on.
+		inline float FastCos(float angle) { return FastSin(ReduceAngle(angle) + 1.57079633f); }
+
+		// An approximate 1 / sqrt(x), for x > 0.
+		inline float FastRsqrt(float x)
+		{
+			Uint32 bits;
+			std::memcpy(&bits, &x, sizeof(bits));
+			bits = 0x5f375a86 - (bits >> 1);
+
+			float y;
+			std::memcpy(&y, &bits, sizeof(y));
+			y = y * (1.5f - 0.5f * x * y * y);
+			return y * (1.5f - 0.5f * x * y * y);
+		}
+
+#pragma region Arrays of FPoint
+
+		// Move every point by an offset.
+		void Add(FPoint* points, int count, const FPoint& offset);
+
+		// Set dst[i] to a[i] + b[i].
+		void Add(FPoint* dst, const FPoint* a, const FPoint* b, int count);
+
+		// Multiply every point by a factor on each axis, about the origin.
+		void Scale(FPoint* points, int count, const FPoint& factor);
+		inline void Scale(FPoint* points, int count, float factor) { Scale(points, count, FPoint(factor, factor)); }
+
+		// Rotate every point by the same angle in radians about a centre, as FPoint::rotateAround() does.
+		void Rotate(FPoint* points, int count, float angle, const FPoint& centre = FPoint(0, 0));
+
+		// Rotate each point about the origin by its own angle in radians, as FPoint::rotate() does.
+		void Rotate(FPoint* points, const float* angles, int count, Precision precision = Precision::EXACT);
+
+		// Scale every point to a length of 1, as FPoint::norm() does, leaving points at the origin there.
+		void Normalize(FPoint* points, int count, Precision precision = Precision::EXACT);
+
+		// Set out[i] to the dot product of a[i] and b[i].
+		void Dot(const FPoint* a, const FPoint* b, float* out, int count);
+
+		// Set out[i] to the length of points[i], as FPoint::mag() does.
+		void Length(const FPoint* points, float* out, int count, Precision precision = Precision::EXACT);
+
+		// Set dst[i] to a[i] + (b[i] - a[i]) * t.
+		void Lerp(FPoint* dst, const FPoint* a, const FPoint* b, float t, int count);
+
+		// Set dst[i] to transform.apply(src[i]).
+		void Transform(FPoint* dst, const FPoint* src, int count, const Transform2D& transform);
+
+#pragma endregion
+
+#pragma region PointSoA
+
+		// The same operations over every point in a PointSoA. Inputs must all be the same size, and dst is resized to match.
+
+		void Add(PointSoA& points, const FPoint& offset);
+		void Add(PointSoA& dst, const PointSoA& a, const PointSoA& b);
+		void Scale(PointSoA& points, const FPoint& factor);
+		inline void Scale(PointSoA& points, float factor) { Scale(points, FPoint(factor, factor)); }
+		void Rotate(PointSoA& points, float angle, const FPoint& centre = FPoint(0, 0));
+		void Rotate(PointSoA& points, const float* angles, Precision precision = Precision::EXACT);
+		void Normalize(PointSoA& points, Precision precision = Precision::EXACT);
+		void Dot(const PointSoA& a, const PointSoA& b, float* out);
+		void Length(const PointSoA& points, float* out, Precision precision = Precision::EXACT);
+		void Lerp(PointSoA& dst, const PointSoA& a, const PointSoA& b, float t);
+		void Transform(PointSoA& dst, const PointSoA& src, const Transform2D& transform);
+
+#pragma endregion
+	}
+}
+
+#endif
+#endif
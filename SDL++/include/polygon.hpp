@@ -0,0 +1,157 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+#ifndef SDL_polygon_hpp_
+#define SDL_polygon_hpp_
+#pragma once
+
+#include "container.hpp"
+#include "ray.hpp"
+#include "rect.hpp"
+#include "transform.hpp"
+
+#include <vector>
+
+namespace SDL
+{
+	struct ConvexPolygon;
+
+	/**
+	 *  \brief    A simple polygon of any shape, convex or not, as a list of vertices in order around its edge.
+	 *
+	 *  \details  The last vertex joins back to the first. The edges must not cross each other, but the vertices may
+	 *            go either way round. For collisions between shapes, take the Hull() or split the polygon into
+	 *            convex parts, and use ConvexPolygon.
+	 */
+	struct Polygon
+	{
+		std::vector<FPoint> points;
+
+		inline Polygon() = default;
+		inline Polygon(const FPoint* points, int count) : points(points, points + count) {}
+
+		template <typename T, typename = typename std::enable_if_t<ContinuousContainer_traits<FPoint, T>::is_continuous_container>>
+		inline Polygon(const T& points) : Polygon(points.data(), (int)points.size()) {}
+
+		inline int Size() const { return (int)points.size(); }
+
+		// The area enclosed, which is positive if the vertices go clockwise on screen (with y pointing down).
+		float SignedArea() const;
+		inline float Area() const { const float a = SignedArea(); return a < 0 ? -a : a; }
+
+		// The smallest rectangle holding every vertex.
+		FRect Bounds() const;
+
+		// Evaluates to true if a point is inside the polygon, by the even-odd rule.
+		bool Contains(const FPoint& point) const;
+
+		/**
+		 * Find where a ray first crosses the edge of the polygon.
+		 *
+		 * As with Ray::IntersectRect(), the contact time is the proportion of
+		 * the ray's direction travelled, from 0 to 1. The normal is the edge's
+		 * unit normal, facing back towards the side the ray came from.
+		 *
+		 * \param ray the ray, from origin to origin + dir
+		 * \returns the first crossing, or a Contact with contact set to false.
+		 */
+		Ray::Contact Intersect(const Ray& ray) const;
+
+		// The smallest convex polygon holding every vertex.
+		ConvexPolygon Hull() const;
+	};
+
+	/**
+	 *  \brief    A convex polygon, such as a rotated box, with a unit normal cached for each edge.
+	 *
+	 *  \details  Vertices are kept going clockwise on screen (with y pointing down), and normals[i] faces out of the
+	 *            edge from points[i] to points[i + 1]. The normals and bounds are worked out whenever the vertices are
+	 *            set or transformed, so repeated overlap and ray tests only need dot products.
+	 *
+	 *            Overlaps() uses the separating axis theorem: two convex shapes are apart exactly when the shadows
+	 *            they cast onto one of their edge normals do not overlap. The axis they overlap least along also
+	 *            gives the shortest move that separates them.
+	 */
+	struct ConvexPolygon
+	{
+		std::vector<FPoint> points;
+		std::vector<FPoint> normals;
+		FRect bounds;
+
+		inline ConvexPolygon() = default;
+
+		// Use points already in convex order, going either way round. To wrap arbitrary points, use Hull().
+		ConvexPolygon(const FPoint* points, int count);
+
+		template <typename T, typename = typename std::enable_if_t<ContinuousContainer_traits<FPoint, T>::is_continuous_container>>
+		inline ConvexPolygon(const T& points) : ConvexPolygon(points.data(), (int)points.size()) {}
+
+		// The four corners of a rectangle.
+		ConvexPolygon(const FRect& rect);
+
+		/**
+		 * Find the convex hull of a set of points, with quickhull.
+		 *
+		 * Points along an edge of the hull are left out, so if every point is
+		 * on one line, the hull has only its two ends.
+		 *
+		 * \param points the points to wrap
+		 * \param count the number of points
+		 * \returns the smallest convex polygon holding every point.
+		 */
+		static ConvexPolygon Hull(const FPoint* points, int count);
+
+		template <typename T, typename = typename std::enable_if_t<ContinuousContainer_traits<FPoint, T>::is_continuous_container>>
+		inline static ConvexPolygon Hull(const T& points) { return Hull(points.data(), (int)points.size()); }
+
+		// A box of a given size, turned by an angle in radians about its centre.
+		static ConvexPolygon Box(const FPoint& centre, const FPoint& size, float angle);
+
+		inline int Size() const { return (int)points.size(); }
+
+		// Replace the vertices, in convex order, and update the normals and bounds.
+		void Set(const FPoint* points, int count);
+
+		// Move every vertex by a transform, and update the normals and bounds.
+		ConvexPolygon& Transform(const Transform2D& transform);
+		inline ConvexPolygon Transformed(const Transform2D& transform) const { ConvexPolygon p = *this; return p.Transform(transform); }
+
+		ConvexPolygon& Translate(const FPoint& offset);
+
+		float Area() const;
+		FPoint Centroid() const;
+
+		// The vertex furthest along a direction.
+		FPoint Support(const FPoint& dir) const;
+
+		// Evaluates to true if a point is strictly inside the polygon.
+		bool Contains(const FPoint& point) const;
+
+		/**
+		 * Find where a ray first crosses the edge of the polygon.
+		 *
+		 * The same as Polygon::Intersect(): a ray starting outside reports
+		 * where it enters, with the normal of the edge it enters through, as
+		 * Ray::IntersectRect() does. A ray starting inside reports where it
+		 * leaves, with the normal facing back in.
+		 *
+		 * \param ray the ray, from origin to origin + dir
+		 * \returns the first crossing, or a Contact with contact set to false.
+		 */
+		Ray::Contact Intersect(const Ray& ray) const;
+
+		/**
+		 * Test whether two convex polygons overlap.
+		 *
+		 * Polygons that only touch do not overlap, as with RectsIntersect().
+		 *
+		 * \param other the polygon to test against
+		 * \param mtv if not NULL, filled in with the shortest move for this
+		 *            polygon that separates it from the other, if they overlap
+		 * \returns true if the polygons overlap.
+		 */
+		bool Overlaps(const ConvexPolygon& other, FPoint* mtv = NULL) const;
+	};
+}
+
+#endif
+#endif
@@ -0,0 +1,80 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 5)
+#ifndef SDL_quantize_hpp_
+#define SDL_quantize_hpp_
+#pragma once
+
+#include "pixels.hpp"
+#include "surface.hpp"
+
+namespace SDL
+{
+	// Palette generation and conversion of true colour surfaces to INDEX8.
+	//
+	// Colours are compared as RGBA, so translucent pixels get their own palette
+	// entries and converted surfaces keep their transparency when blitted with
+	// BlendMode::BLEND. Fully transparent pixels are all treated as (0, 0, 0, 0).
+	// Colour keyed sources use their key as transparency.
+	namespace Quantize
+	{
+		// How GeneratePalette() chooses its colours.
+		enum class Method
+		{
+			MEDIAN_CUT, // Recursively split the colour space at the median of its widest axis; fast
+			KMEANS      // Refine a median cut palette with k-means; slower but lower error
+		};
+
+		/**
+		 * Choose a palette that represents the colours of a surface well.
+		 *
+		 * \param surface the surface to take colours from
+		 * \param ncolours the largest number of colours to choose, from 1 to 256;
+		 *                 fewer are chosen if the surface has fewer distinct colours
+		 * \param method how the colours are chosen
+		 * \param iterations the most refinement passes Method::KMEANS makes; it stops
+		 *                   sooner once no colour moves
+		 * \returns a new palette, or an invalid one on failure; call SDL::GetError()
+		 *          for more information.
+		 */
+		Palette GeneratePalette(const Surface& surface, int ncolours = 256, Method method = Method::MEDIAN_CUT, int iterations = 8);
+
+		/**
+		 * Convert a surface to INDEX8 using a given palette.
+		 *
+		 * Each pixel takes the index of the nearest palette colour. With dithering
+		 * the error of each pixel is spread over its neighbours (Floyd-Steinberg,
+		 * scanning rows in alternating directions), which hides banding in
+		 * gradients at the cost of some noise.
+		 *
+		 * The result shares the palette, and copies the blend mode and premultiplied
+		 * flag of the source.
+		 *
+		 * \param surface the surface to convert
+		 * \param palette the colours the result may use
+		 * \param dither whether to diffuse the quantization error
+		 * \returns the converted surface, or an invalid surface on failure; call
+		 *          SDL::GetError() for more information.
+		 */
+		Surface ToIndexed(const Surface& surface, const Palette& palette, bool dither = true);
+
+		/**
+		 * Convert a surface to INDEX8 with a palette generated for it.
+		 *
+		 * \param surface the surface to convert
+		 * \param ncolours the largest number of colours to use, from 1 to 256
+		 * \param method how the palette is chosen
+		 * \param dither whether to diffuse the quantization error
+		 * \returns the converted surface, or an invalid surface on failure; call
+		 *          SDL::GetError() for more information.
+		 */
+		inline Surface ToIndexed(const Surface& surface, int ncolours = 256, Method method = Method::MEDIAN_CUT, bool dither = true)
+		{
+			const Palette palette = GeneratePalette(surface, ncolours, method);
+			if (palette.palette == nullptr) return Surface::FromPtr(NULL);
+			return ToIndexed(surface, palette, dither);
+		}
+	}
+}
+
+#endif
+#endif
@@ -3,9 +3,13 @@
 #pragma once
 
 #include "rect.hpp"
+#include "rectsoa.hpp"
 
+#include <cmath>
+#include <limits>
 #include <ostream>
 #include <string>
+#include <vector>
 
 namespace SDL
 {
@@ -19,6 +23,13 @@ namespace SDL
 			float time = 0;
 		};
 
+		// A rectangle a ray passes through: its index in a RectSoA and the proportion of dir at which the ray enters it.
+		struct Hit
+		{
+			int index = -1;
+			float time = 0;
+		};
+
 		FPoint origin;
 		FPoint dir;
 
@@ -197,6 +208,164 @@ namespace SDL
 
 			return nearNorm.x < farNorm.y && nearNorm.y > farNorm.x && nearNorm.max() <= 1;
 		}
+
+		/**
+		 * Sweep a moving rectangle against a still one.
+		 *
+		 * The target is grown by the size of the moving rectangle (their
+		 * Minkowski sum), and the moving rectangle's position cast against it
+		 * as a ray. Edges that only touch do not count, as with
+		 * RectsIntersect(), so a rectangle can slide along a surface it rests
+		 * on. Rectangles already overlapping at the start are ignored, so a
+		 * rectangle stuck inside another can always move out of it.
+		 *
+		 * \param moving the moving rectangle at the start of the move
+		 * \param velocity how far it moves
+		 * \param target the rectangle it may hit
+		 * \returns the contact, if the rectangles meet in [0, 1) of the move.
+		 *          The point is the moving rectangle's position when they meet,
+		 *          placed exactly against the side hit, and the normal is that
+		 *          of the side hit, as with IntersectRect().
+		 */
+		inline static Contact SweepRect(const FRect& moving, const FPoint& velocity, const FRect& target)
+		{
+			if (moving.empty() || target.empty()) return { false };
+
+			constexpr float inf = std::numeric_limits<float>::infinity();
+
+			// The positions of the moving rectangle at which it touches the target
+			const FPoint lo = target.pos - moving.size;
+			const FPoint hi = target.pos + target.size;
+			const FPoint& o = moving.pos;
+
+			float entryX = -inf, leaveX = inf;
+			if (velocity.x != 0)
+			{
+				const float inv = 1.f / velocity.x;
+				entryX = std::min((lo.x - o.x) * inv, (hi.x - o.x) * inv);
+				leaveX = std::max((lo.x - o.x) * inv, (hi.x - o.x) * inv);
+			}
+			else if (!(o.x > lo.x && o.x < hi.x)) return { false };
+
+			float entryY = -inf, leaveY = inf;
+			if (velocity.y != 0)
+			{
+				const float inv = 1.f / velocity.y;
+				entryY = std::min((lo.y - o.y) * inv, (hi.y - o.y) * inv);
+				leaveY = std::max((lo.y - o.y) * inv, (hi.y - o.y) * inv);
+			}
+			else if (!(o.y > lo.y && o.y < hi.y)) return { false };
+
+			const float entry = std::max(entryX, entryY);
+			const float leave = std::min(leaveX, leaveY);
+			if (entry >= leave || entry < 0 || entry >= 1) return { false };
+
+			Contact hit
+			{
+				true,
+				o + entry * velocity,
+				{ 0, 0 },
+				entry
+			};
+
+			// Place the rectangle against the side hit, backing off by a step if rounding would leave it overlapping
+			if (entryX >= entryY)
+			{
+				hit.normal.x = velocity.x < 0 ? 1.f : -1.f;
+				hit.point.x = velocity.x < 0 ? hi.x : lo.x + moving.w > target.x ? std::nextafter(lo.x, -inf) : lo.x;
+			}
+			if (entryX <= entryY)
+			{
+				hit.normal.y = velocity.y < 0 ? 1.f : -1.f;
+				hit.point.y = velocity.y < 0 ? hi.y : lo.y + moving.h > target.y ? std::nextafter(lo.y, -inf) : lo.y;
+			}
+
+			return hit;
+		}
+
+		/**
+		 * Find the first of many still rectangles a moving rectangle hits.
+		 *
+		 * \param moving the moving rectangle at the start of the move
+		 * \param velocity how far it moves
+		 * \param obstacles the rectangles it may hit, such as those found by a
+		 *                  broadphase query over the swept area
+		 * \param count the number of obstacles
+		 * \param contact filled in with the contact, as with SweepRect(), if
+		 *                there is one
+		 * \returns the index of the obstacle hit first, or -1 if none are hit.
+		 *          Of obstacles hit at the same time, one hit on a side is
+		 *          preferred over one hit exactly on a corner, then the lowest
+		 *          index.
+		 */
+		static int TimeOfImpact(const FRect& moving, const FPoint& velocity, const FRect* obstacles, int count, Contact& contact);
+
+		template <typename T, typename = typename std::enable_if_t<ContinuousContainer_traits<FRect, T>::is_continuous_container>>
+		inline static int TimeOfImpact(const FRect& moving, const FPoint& velocity, const T& obstacles, Contact& contact)
+			{ return TimeOfImpact(moving, velocity, obstacles.data(), (int)obstacles.size(), contact); }
+
+		/**
+		 * Move a rectangle against still ones, sliding along whatever it hits.
+		 *
+		 * At each hit, the rectangle is placed against the side hit and the
+		 * rest of its motion into that side is dropped, then it carries on
+		 * with what is left. This stops fast rectangles tunnelling through
+		 * thin ones without substepping.
+		 *
+		 * \param moving the moving rectangle at the start of the move
+		 * \param velocity how far it moves
+		 * \param obstacles the rectangles it may hit
+		 * \param count the number of obstacles
+		 * \param contacts if not NULL, each contact is appended to this, in
+		 *                 order, with times relative to the part of the move
+		 *                 left when it happened
+		 * \param iterations the most hits to slide off; any motion left after
+		 *                   this many is dropped
+		 * \returns the final position of the rectangle.
+		 */
+		static FPoint SlideRect(const FRect& moving, const FPoint& velocity, const FRect* obstacles, int count, std::vector<Contact>* contacts = NULL, int iterations = 4);
+
+		template <typename T, typename = typename std::enable_if_t<ContinuousContainer_traits<FRect, T>::is_continuous_container>>
+		inline static FPoint SlideRect(const FRect& moving, const FPoint& velocity, const T& obstacles, std::vector<Contact>* contacts = NULL, int iterations = 4)
+			{ return SlideRect(moving, velocity, obstacles.data(), (int)obstacles.size(), contacts, iterations); }
+
+		/**
+		 * Find every rectangle in a set that this ray passes through.
+		 *
+		 * The ray is treated as the segment from origin to origin + dir, and
+		 * each rectangle is slab tested against it 4 or 8 at a time with SSE,
+		 * AVX or NEON where available. Unlike IntersectsRect(), rays along an
+		 * axis are handled, and a ray starting inside a rectangle hits it with
+		 * a negative time. Empty rectangles are never hit.
+		 *
+		 * \param rects the rectangles to test
+		 * \param results the hits are appended to this, in order of index
+		 * \returns the number of hits appended.
+		 */
+		size_t IntersectAll(const RectSoA& rects, std::vector<Hit>& results) const;
+
+		/**
+		 * Find the first rectangle in a set that this ray enters.
+		 *
+		 * \param rects the rectangles to test, as with IntersectAll()
+		 * \param contact filled in with the point, normal and time of the hit,
+		 *                as IntersectRect() would, if there is one
+		 * \returns the index of the rectangle entered first, the lowest index
+		 *          if several are entered at once, or -1 if none are hit.
+		 */
+		int FirstHit(const RectSoA& rects, Contact& contact) const;
+
+		/**
+		 * Find the first rectangle each of many rays enters, as with FirstHit().
+		 *
+		 * \param rays the rays to cast
+		 * \param count the number of rays
+		 * \param rects the rectangles to test
+		 * \param indices filled in with the index hit by each ray, or -1
+		 * \param contacts if not NULL, filled in with the contact of each ray
+		 * \param parallel true to split the rays across CPU cores
+		 */
+		static void FirstHits(const Ray* rays, int count, const RectSoA& rects, int* indices, Contact* contacts = NULL, bool parallel = true);
 	};
 
 	inline std::ostream& operator<<(std::ostream& os, const Ray& r)
@@ -0,0 +1,85 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+#ifndef SDL_rectsoa_hpp_
+#define SDL_rectsoa_hpp_
+#pragma once
+
+#include "rect.hpp"
+#include "simd.hpp"
+
+#include <vector>
+
+namespace SDL
+{
+	/**
+	 *  \brief    A set of rectangles stored as structure of arrays, for testing many rectangles at once with SIMD.
+	 *
+	 *  \details  The x, y, w and h of every rectangle are kept in four separate 32-byte aligned arrays, so a vector
+	 *            load reads the same field of several rectangles. The arrays are padded to a multiple of 8 with empty
+	 *            rectangles, which never intersect anything, so kernels need no scalar tail.
+	 */
+	struct RectSoA
+	{
+		typedef std::vector<float, AlignedAllocator<float>> Array;
+
+		static constexpr int BATCH = 8; // The arrays' lengths are a multiple of this
+
+		Array x, y, w, h;
+		int count = 0; // The number of rectangles, not counting padding
+
+		inline RectSoA() = default;
+		inline RectSoA(const FRect* rects, int n) { Reserve(n); for (int i = 0; i < n; i++) Add(rects[i]); }
+		inline RectSoA(const Rect* rects, int n) { Reserve(n); for (int i = 0; i < n; i++) Add(rects[i]); }
+
+		template <typename T, typename = typename std::enable_if_t<ContinuousContainer_traits<FRect, T>::is_continuous_container>>
+		inline RectSoA(const T& rects) : RectSoA(rects.data(), (int)rects.size()) {}
+
+		// The number of rectangles, not counting padding.
+		inline int Size() const { return count; }
+		inline bool Empty() const { return count == 0; }
+
+		// The length of the arrays, including padding.
+		inline int Padded() const { return (int)x.size(); }
+
+		inline void Reserve(int n)
+		{
+			const size_t padded = (size_t)(n + BATCH - 1) / BATCH * BATCH;
+			x.reserve(padded); y.reserve(padded); w.reserve(padded); h.reserve(padded);
+		}
+
+		// Add a rectangle to the end, returning its index.
+		inline int Add(const FRect& rect)
+		{
+			if (count == Padded())
+			{
+				x.resize(x.size() + BATCH, 0.f); y.resize(y.size() + BATCH, 0.f);
+				w.resize(w.size() + BATCH, 0.f); h.resize(h.size() + BATCH, 0.f);
+			}
+
+			Set(count, rect);
+			return count++;
+		}
+		inline int Add(const Rect& rect) { return Add(FRect(rect)); }
+
+		// Replace the rectangle at an index below Size().
+		inline void Set(int i, const FRect& rect) { x[i] = rect.x; y[i] = rect.y; w[i] = rect.w; h[i] = rect.h; }
+		inline void Set(int i, const Rect& rect) { Set(i, FRect(rect)); }
+
+		inline FRect Get(int i) const { return FRect(x[i], y[i], w[i], h[i]); }
+		inline FRect operator[](int i) const { return Get(i); }
+
+		// Remove the rectangle at an index by moving the last one into its place, returning the last one's old index.
+		inline int SwapRemove(int i)
+		{
+			const int last = --count;
+			Set(i, Get(last));
+			Set(last, FRect(0, 0, 0, 0));
+			return last;
+		}
+
+		inline void Clear() { x.clear(); y.clear(); w.clear(); h.clear(); count = 0; }
+	};
+}
+
+#endif
+#endif
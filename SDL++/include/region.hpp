@@ -0,0 +1,96 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+#ifndef SDL_region_hpp_
+#define SDL_region_hpp_
+#pragma once
+
+#include "container.hpp"
+#include "rect.hpp"
+
+#include <vector>
+
+namespace SDL
+{
+	/**
+	 *  \brief    An area made of any number of rectangles, such as the damaged parts of a window, a clip area or
+	 *            what is left visible of something under other things.
+	 *
+	 *  \details  The area is kept as a list of non-overlapping rectangles in bands, the same way as X11 and pixman
+	 *            regions. Every rectangle in a band has the same top and height, the bands are sorted top to bottom
+	 *            and the rectangles in each band left to right, and no two rectangles in a band touch. Bands that
+	 *            meet and hold the same spans are joined into one. This makes every area have exactly one list, and
+	 *            lets unions, subtractions and intersections be worked out in one pass down both lists.
+	 *
+	 *            A Region has data() and size(), so it can be passed straight to anything taking a container of
+	 *            rectangles, such as Renderer::FillRects(), Surface::FillRects() or Window::UpdateSurfaceRects().
+	 */
+	struct Region
+	{
+		std::vector<Rect> rects; // The banded rectangles, top to bottom and then left to right
+		Rect extents;            // The smallest rectangle holding the whole area
+
+		inline Region() = default;
+		inline Region(const Rect& rect) { if (!rect.empty()) { rects.push_back(rect); extents = rect; } }
+
+		// Make a region covering the union of some rectangles. Empty rectangles are left out.
+		Region(const Rect* rects, int count);
+
+		template <typename T, typename = typename std::enable_if_t<ContinuousContainer_traits<Rect, T>::is_continuous_container>>
+		inline Region(const T& rects) : Region(rects.data(), (int)rects.size()) {}
+
+		inline bool Empty() const { return rects.empty(); }
+		inline const Rect& Bounds() const { return extents; }
+		inline void Clear() { rects.clear(); extents = Rect(); }
+
+		inline const Rect* data() const { return rects.data(); }
+		inline size_t size() const { return rects.size(); }
+
+		inline std::vector<Rect>::const_iterator begin() const { return rects.begin(); }
+		inline std::vector<Rect>::const_iterator end() const { return rects.end(); }
+
+		// Add the area of another region to this one.
+		Region& Union(const Region& other);
+
+		// Take the area of another region away from this one.
+		Region& Subtract(const Region& other);
+
+		// Keep only the area this region shares with another.
+		Region& Intersect(const Region& other);
+
+		// Keep only the area covered by exactly one of this region and another.
+		Region& Xor(const Region& other);
+
+		// Move the whole region by an offset.
+		Region& Translate(const Point& offset);
+
+		// Evaluates to true if a point is inside the region.
+		bool Contains(const Point& point) const;
+
+		// Evaluates to true if a non-empty rectangle is entirely inside the region.
+		bool Contains(const Rect& rect) const;
+
+		// Evaluates to true if a rectangle overlaps any part of the region.
+		bool Intersects(const Rect& rect) const;
+
+		// The number of pixels covered.
+		long long Area() const;
+
+		bool operator==(const Region& other) const;
+		inline bool operator!=(const Region& other) const { return !(*this == other); }
+
+		inline Region& operator|=(const Region& other) { return Union(other); }
+		inline Region& operator-=(const Region& other) { return Subtract(other); }
+		inline Region& operator&=(const Region& other) { return Intersect(other); }
+		inline Region& operator^=(const Region& other) { return Xor(other); }
+		inline Region& operator+=(const Point& offset) { return Translate(offset); }
+
+		inline Region operator|(const Region& other) const { Region r = *this; return r.Union(other); }
+		inline Region operator-(const Region& other) const { Region r = *this; return r.Subtract(other); }
+		inline Region operator&(const Region& other) const { Region r = *this; return r.Intersect(other); }
+		inline Region operator^(const Region& other) const { Region r = *this; return r.Xor(other); }
+		inline Region operator+(const Point& offset) const { Region r = *this; return r.Translate(offset); }
+	};
+}
+
+#endif
+#endif
@@ -1695,9 +1695,20 @@ namespace SDL
 		inline static void DontDestroyTexture(SDL_Texture* texture)
 			{}
 
+		// This is a custom destructor for smart pointers that destroys the SDL_Texture through SDL if it is owned. It
+		// also holds what is known about the texels: a smart pointer and all its copies share one destructor, so
+		// every Texture using the SDL_Texture sees the same state.
+		struct TextureState
+		{
+			bool owned = true;
+			bool premultiplied = false; // True if the texels hold colour premultiplied by alpha
+
+			inline void operator()(SDL_Texture* texture) const { if (owned) SDL_DestroyTexture(texture); }
+		};
+
 		// This creates a smart pointer to an SDL_Texture with a custom destructor
 		inline static std::shared_ptr<SDL_Texture> MakeSharedPtr(SDL_Texture* texture)
-			{ return std::shared_ptr<SDL_Texture>(texture, DestroyTexture); }
+			{ return std::shared_ptr<SDL_Texture>(texture, TextureState()); }
 
 		// This creates a Texture from a SDL_Texture pointer, taking ownership of the pointer
 		inline static Texture FromPtr(Renderer& renderer, SDL_Texture* texture)
@@ -1705,7 +1716,7 @@ namespace SDL
 
 		// This creates a Texture from a SDL_Texture pointer, but does not take ownership of the pointer
 		inline static Texture FromUnownedPtr(Renderer& renderer, SDL_Texture* texture)
-			{ return Texture(renderer.renderer, std::shared_ptr<SDL_Texture>(texture, DontDestroyTexture)); }
+			{ return Texture(renderer.renderer, std::shared_ptr<SDL_Texture>(texture, TextureState{ false })); }
 
 		std::shared_ptr<SDL_Renderer> renderer = nullptr;
 		std::shared_ptr<SDL_Texture> texture = nullptr;
@@ -1768,9 +1779,15 @@ namespace SDL
 		 *  \return   The created texture is returned, or NULL on error.
 		 *
 		 *  \note     The surface is not modified or freed by this function.
+		 *
+		 *  \note     If the surface is premultiplied, so is the texture, and its
+		 *            default blend mode is the premultiplied equivalent of BLEND.
 		 */
 		inline Texture(Renderer& renderer, Surface& surface)
-			: Texture(FromPtr(renderer, SDL_CreateTextureFromSurface(renderer.renderer.get(), surface.surface.get()))) {}
+			: Texture(FromPtr(renderer, SDL_CreateTextureFromSurface(renderer.renderer.get(), surface.surface.get())))
+		{
+			if (surface.IsPremultiplied() && SetPremultiplied(true)) SetBlendMode(BlendMode::BLEND);
+		}
 
 #pragma endregion 
 
@@ -2119,6 +2136,38 @@ namespace SDL
 		inline int GetMod(Colour& c)
 			{ return (GetColourMod(c.r, c.g, c.b) ? 0 : -1) + (GetAlphaMod(c.a) ? 0 : -2); }
 
+		// Evaluates to true if the texels hold colour premultiplied by alpha; SetBlendMode() then uses the premultiplied equivalent.
+		inline bool IsPremultiplied() const
+		{
+			const TextureState* state = std::get_deleter<TextureState>(texture);
+			return state != nullptr && state->premultiplied;
+		}
+
+		/**
+		 *  \brief    Mark the texels as premultiplied or not, without changing them.
+		 *
+		 *  \details  The mark is kept with the smart pointer's destructor, so every
+		 *            Texture sharing the pointer sees the change. The blend mode is
+		 *            not changed; call SetBlendMode() afterwards.
+		 *
+		 *  \param    premultiplied: True if the texels hold colour multiplied by alpha.
+		 *
+		 *  \return   true on success, or false if the texture was not made by
+		 *            MakeSharedPtr(), FromPtr() or FromUnownedPtr().
+		 */
+		inline bool SetPremultiplied(bool premultiplied)
+		{
+			TextureState* state = std::get_deleter<TextureState>(texture);
+			if (state == nullptr)
+			{
+				SDL_SetError("The texture's smart pointer was not made by Texture");
+				return false;
+			}
+
+			state->premultiplied = premultiplied;
+			return true;
+		}
+
 		/**
 		 *  \brief    Set the blend mode used for texture copy operations.
 		 *
@@ -2127,11 +2176,19 @@ namespace SDL
 		 *  \note     If the blend mode is not supported, the closest supported mode is
 		 *            chosen.
 		 *
+		 *  \note     If the texture is premultiplied, BLEND and ADD are replaced with
+		 *            their PremultipliedBlendMode() equivalents.
+		 *
 		 *  \return   true on success, or false if the texture is not valid or the blend mode is
 		 *            not supported.
 		 */
 		inline bool SetBlendMode(BlendMode blendMode)
-			{ return SDL_SetTextureBlendMode(texture.get(), (SDL_BlendMode)blendMode) == 0; }
+		{
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+			if (IsPremultiplied()) blendMode = PremultipliedBlendMode(blendMode);
+#endif
+			return SDL_SetTextureBlendMode(texture.get(), (SDL_BlendMode)blendMode) == 0;
+		}
 
 		/**
 		 *  \brief    Get the blend mode used for texture copy operations.
@@ -842,7 +842,7 @@ namespace SDL
 		 *          information.
 		 */
 		inline bool WriteU8(Uint8 value)
-			{ return SDL_WriteU8(*rwops, value) == 0; }
+			{ return SDL_WriteU8(*rwops, value) == 1; }
 
 		/**
 		 * Use this function to write 16 bits in native format to this RWops as
@@ -856,7 +856,7 @@ namespace SDL
 		 * \returns true on success or false on error
 		 */
 		inline bool WriteLE16(Uint16 value)
-			{ return SDL_WriteLE16(*rwops, value) == 0; }
+			{ return SDL_WriteLE16(*rwops, value) == 1; }
 
 		/**
 		 * Use this function to write 16 bits in native format to this RWops as
@@ -869,7 +869,7 @@ namespace SDL
 		 * \returns true on success or false on error
 		 */
 		inline bool WriteBE16(Uint16 value)
-			{ return SDL_WriteBE16(*rwops, value) == 0; }
+			{ return SDL_WriteBE16(*rwops, value) == 1; }
 
 		/**
 		 * Use this function to write 32 bits in native format to this RWops as
@@ -883,7 +883,7 @@ namespace SDL
 		 * \returns true on success or false on error
 		 */
 		inline bool WriteLE32(Uint32 value)
-			{ return SDL_WriteLE32(*rwops, value) == 0; }
+			{ return SDL_WriteLE32(*rwops, value) == 1; }
 
 		/**
 		 * Use this function to write 32 bits in native format to this RWops as
@@ -896,7 +896,7 @@ namespace SDL
 		 * \returns true on success or false on error
 		 */
 		inline bool WriteBE32(Uint32 value)
-			{ return SDL_WriteBE32(*rwops, value) == 0; }
+			{ return SDL_WriteBE32(*rwops, value) == 1; }
 
 		/**
 		 * Use this function to write 64 bits in native format to this RWops as
@@ -910,7 +910,7 @@ namespace SDL
 		 * \returns true on success or false on error
 		 */
 		inline bool WriteLE64(Uint64 value)
-			{ return SDL_WriteLE64(*rwops, value) == 0; }
+			{ return SDL_WriteLE64(*rwops, value) == 1; }
 
 		/**
 		 * Use this function to write 64 bits in native format to this RWops as
@@ -923,7 +923,7 @@ namespace SDL
 		 * \returns true on success or false on error
 		 */
 		inline bool WriteBE64(Uint64 value)
-			{ return SDL_WriteBE64(*rwops, value) == 0; }
+			{ return SDL_WriteBE64(*rwops, value) == 1; }
 
 #pragma endregion
 
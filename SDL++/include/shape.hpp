@@ -153,6 +153,48 @@ namespace SDL
 		 */
 		inline int GetShapedWindowMode(Window& window, Mode& shape_mode)
 			{ return SDL_GetShapedWindowMode(window.window.get(), (SDL_WindowShapeMode*)&shape_mode); }
+
+		/**
+		 *  \brief    A window shape derived from a surface, which only reshapes the window when the shape changes.
+		 *
+		 *  \details  SDL_SetWindowShape() rebuilds the window's region from every pixel of the surface it is
+		 *            given, which is too slow to call each frame. A ShapeMask binarizes the alpha channel or
+		 *            colour key of a surface into a cached mask, following the same rules as the Mode would,
+		 *            hashes it, and only passes it to the window when the hash differs from the last shape
+		 *            applied. Surfaces in a 32-bit format with 8-bit channels are read in place with SSE2 or
+		 *            NEON; other formats are converted to ARGB8888 first.
+		 */
+		struct ShapeMask
+		{
+			Surface mask = Surface::FromPtr(NULL); // The binarized shape in ARGB8888: opaque white inside the window and transparent outside
+			Uint64 hash = 0;                        // The hash of the mask last applied to a window
+			SDL_Window* applied = NULL;             // The window the mask was last applied to, or NULL to apply it on the next call
+
+			/**
+			 * Binarize a surface into the cached mask, reusing it if it has the same size.
+			 *
+			 * \param source the surface to take the shape from
+			 * \param shape_mode how to binarize source, as for SetWindowShape()
+			 * \returns true on success or false on failure; call SDL::GetError() for
+			 *          more information.
+			 */
+			bool Update(const Surface& source, const Mode& shape_mode);
+
+			/**
+			 * Binarize a surface and shape a window with it if the shape changed.
+			 *
+			 * \param window the shaped window, which must be the size of source
+			 * \param source the surface to take the shape from
+			 * \param shape_mode how to binarize source, as for SetWindowShape()
+			 * \return 0 on success, whether or not the window was reshaped,
+			 *         SDL_INVALID_SHAPE_ARGUMENT if the mask could not be built, or
+			 *         any error returned by SetWindowShape().
+			 */
+			int Apply(Window& window, const Surface& source, const Mode& shape_mode);
+
+			// Make the next call to Apply() reshape the window even if the shape has not changed.
+			inline void Invalidate() { applied = NULL; }
+		};
 	}
 }
 
@@ -0,0 +1,51 @@
+#ifndef SDL_simd_hpp_
+#define SDL_simd_hpp_
+#pragma once
+
+// Compile-time selection of the vector instruction sets used by the software pixel and geometry kernels.
+// Every kernel has a scalar fallback, so none of these are required.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SDLPP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX__)
+#define SDLPP_AVX 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define SDLPP_NEON 1
+#include <arm_neon.h>
+#endif
+
+#include <cstddef>
+#include <new>
+
+namespace SDL
+{
+	// An allocator for std::vector whose storage starts on an Align byte boundary, for arrays read by vector loads.
+	template <typename T, size_t Align = 32>
+	struct AlignedAllocator
+	{
+		typedef T value_type;
+
+		template <typename U>
+		struct rebind { typedef AlignedAllocator<U, Align> other; };
+
+		inline constexpr AlignedAllocator() noexcept = default;
+		template <typename U>
+		inline constexpr AlignedAllocator(const AlignedAllocator<U, Align>&) noexcept {}
+
+		inline T* allocate(size_t n) { return (T*)::operator new(n * sizeof(T), std::align_val_t(Align)); }
+		inline void deallocate(T* p, size_t) noexcept { ::operator delete(p, std::align_val_t(Align)); }
+
+		template <typename U>
+		inline bool operator==(const AlignedAllocator<U, Align>&) const noexcept { return true; }
+		template <typename U>
+		inline bool operator!=(const AlignedAllocator<U, Align>&) const noexcept { return false; }
+	};
+}
+
+#endif
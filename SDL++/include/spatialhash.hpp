@@ -0,0 +1,225 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+#ifndef SDL_spatialhash_hpp_
+#define SDL_spatialhash_hpp_
+#pragma once
+
+#include "aabbtree.hpp"
+#include "container.hpp"
+#include "ray.hpp"
+#include "rect.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace SDL
+{
+	/**
+	 *  \brief    A uniform grid of cells for finding many small, similarly sized moving rectangles, rebuilt every frame.
+	 *
+	 *  \details  Each entity is identified by its index in the array passed to Rebuild(), and filed under the cell
+	 *            holding its centre. Cells are hashed into a table of buckets, and the ids in each bucket are stored
+	 *            contiguously in one flat array, sorted into place with a counting sort, so a rebuild is linear and
+	 *            needs no per-cell lists. Queries widen their search by the largest half size of any entity, so they
+	 *            work best when the cell size is around the size of the entities.
+	 *
+	 *            Every buffer is kept between rebuilds, and a parallel rebuild runs on the worker threads that
+	 *            ParallelFor() keeps between calls, so once the grid has held its largest number of entities it no
+	 *            longer allocates or starts threads. Queries only read the grid and may run on several threads at once.
+	 */
+	struct SpatialHash
+	{
+		float cellSize;
+		float invCellSize;
+
+		std::vector<FRect> rects;  // Each entity's rectangle, by id
+		std::vector<Point> cells;  // Each entity's cell, by id
+		std::vector<int> entries;  // Entity ids, grouped by bucket
+		std::vector<int> starts;   // Where each bucket's ids start in entries, with the total count at the end
+		std::vector<int> keys;     // Each entity's bucket, by id
+		std::vector<int> counts;   // Each rebuild thread's running count of ids per bucket
+		std::vector<FPoint> reaches; // Each rebuild thread's largest half size
+		FPoint reach;              // The largest half width and half height of any entity
+		int buckets = 0;           // A power of two
+
+		/**
+		 *  \brief    Create an empty grid.
+		 *
+		 *  \param    cellSize: The width and height of each cell, ideally around the size of the entities.
+		 */
+		inline SpatialHash(float cellSize = 32.f) : cellSize(cellSize), invCellSize(1.f / cellSize), reach(0, 0) {}
+
+		/**
+		 * Replace the entities in the grid.
+		 *
+		 * \param rects the entities' rectangles, whose indices become their ids
+		 * \param count the number of entities
+		 * \param parallel whether to split the work across all logical CPU cores
+		 */
+		void Rebuild(const FRect* rects, int count, bool parallel = true);
+
+		template <typename T, typename = typename std::enable_if_t<ContinuousContainer_traits<FRect, T>::is_continuous_container>>
+		inline void Rebuild(const T& rects, bool parallel = true) { Rebuild(rects.data(), (int)rects.size(), parallel); }
+
+		inline int Size() const { return (int)rects.size(); }
+		inline bool Empty() const { return rects.empty(); }
+
+		inline void Clear() { Rebuild(NULL, 0, false); }
+
+		// The cell holding a point.
+		inline Point Cell(const FPoint& p) const { return Point((int)std::floor(p.x * invCellSize), (int)std::floor(p.y * invCellSize)); }
+
+		// The bucket a cell is filed under.
+		inline int Bucket(const Point& cell) const { return (int)(((Uint32)cell.x * 73856093u ^ (Uint32)cell.y * 19349663u) & (Uint32)(buckets - 1)); }
+
+		/**
+		 * Call a function for every entity filed under a cell, until it
+		 * returns false.
+		 *
+		 * \param cell the cell
+		 * \param callback called as callback(id)
+		 * \returns false if the callback stopped the walk.
+		 */
+		template <typename F>
+		inline bool VisitCell(const Point& cell, F&& callback) const
+		{
+			if (buckets == 0) return true;
+
+			const int b = Bucket(cell);
+			for (int i = starts[b]; i < starts[b + 1]; i++)
+			{
+				const int id = entries[i];
+				if (cells[id] == cell && !callback(id)) return false;
+			}
+			return true;
+		}
+
+		/**
+		 * Call a function for every entity filed under a cell in the
+		 * inclusive range [from, to], until it returns false.
+		 *
+		 * If the range holds more cells than there are entities, every
+		 * entity is visited instead.
+		 *
+		 * \returns false if the callback stopped the walk.
+		 */
+		template <typename F>
+		inline bool VisitCells(const Point& from, const Point& to, F&& callback) const
+		{
+			if ((long long)(to.x - from.x + 1) * (to.y - from.y + 1) > (long long)rects.size())
+			{
+				for (int id = 0; id < (int)rects.size(); id++)
+					if (!callback(id)) return false;
+				return true;
+			}
+
+			for (int y = from.y; y <= to.y; y++)
+				for (int x = from.x; x <= to.x; x++)
+					if (!VisitCell(Point(x, y), callback)) return false;
+			return true;
+		}
+
+		/**
+		 * Find every entity whose rectangle overlaps a rectangle.
+		 *
+		 * \param rect the rectangle to test
+		 * \param callback called as callback(id) for each entity found;
+		 *                 return false to stop the query
+		 */
+		template <typename F>
+		inline void Query(const FRect& rect, F&& callback) const
+		{
+			VisitCells(Cell(rect.pos - reach), Cell(rect.pos + rect.size + reach),
+				[&](int id) { return !RectsIntersect(rects[id], rect) || callback(id); });
+		}
+
+		/**
+		 * Find every entity whose rectangle comes within a radius of a point.
+		 *
+		 * \param centre the point to test from
+		 * \param radius the distance to search within
+		 * \param callback called as callback(id) for each entity found;
+		 *                 return false to stop the query
+		 */
+		template <typename F>
+		inline void QueryRadius(const FPoint& centre, float radius, F&& callback) const
+		{
+			const FPoint extent = FPoint(radius, radius) + reach;
+			VisitCells(Cell(centre - extent), Cell(centre + extent), [&](int id)
+			{
+				const FRect& r = rects[id];
+				const float dx = centre.x - std::clamp(centre.x, r.x, r.x + r.w);
+				const float dy = centre.y - std::clamp(centre.y, r.y, r.y + r.h);
+				return dx * dx + dy * dy > radius * radius || callback(id);
+			});
+		}
+
+		/**
+		 * Find every entity whose rectangle a ray passes through.
+		 *
+		 * The cells along the ray are walked in order from its origin with a
+		 * DDA, along with any cells close enough to hold an entity reaching
+		 * the ray, so entities are found roughly in order of distance. The ray
+		 * is the segment from origin to origin + dir, as with
+		 * Ray::IntersectAll().
+		 *
+		 * \param ray the ray to cast
+		 * \param callback called as callback(id, time) for each entity hit,
+		 *                 where time is the proportion of dir at which the ray
+		 *                 enters it; return false to stop the query
+		 */
+		template <typename F>
+		inline void RayCast(const Ray& ray, F&& callback) const
+		{
+			if (buckets == 0 || (ray.dir.x == 0 && ray.dir.y == 0)) return; // No ray
+
+			const FPoint inv = AABBTree::InverseDir(ray);
+			auto test = [&](int id)
+			{
+				float entry;
+				return !AABBTree::SlabTest(ray.origin, inv, rects[id], 1.f, entry) || callback(id, entry);
+			};
+
+			// How many cells either side of the path can hold an entity reaching into it
+			const int kx = (int)std::ceil(reach.x * invCellSize), ky = (int)std::ceil(reach.y * invCellSize);
+
+			Point cell = Cell(ray.origin);
+			const Point end = Cell(ray.origin + ray.dir);
+
+			if (!VisitCells(cell - Point(kx, ky), cell + Point(kx, ky), test)) return;
+
+			// A neighbourhood with more cells than there are entities visits every entity at once
+			if ((long long)(2 * kx + 1) * (2 * ky + 1) > (long long)rects.size()) return;
+
+			const int sx = ray.dir.x < 0 ? -1 : 1, sy = ray.dir.y < 0 ? -1 : 1;
+			const float edgeX = (cell.x + (sx > 0)) * cellSize, edgeY = (cell.y + (sy > 0)) * cellSize;
+			float nextX = ray.dir.x != 0 ? (edgeX - ray.origin.x) * inv.x : INFINITY;
+			float nextY = ray.dir.y != 0 ? (edgeY - ray.origin.y) * inv.y : INFINITY;
+			const float stepX = ray.dir.x != 0 ? cellSize * std::abs(inv.x) : INFINITY;
+			const float stepY = ray.dir.y != 0 ? cellSize * std::abs(inv.y) : INFINITY;
+
+			// The path only ever moves forwards on each axis, so only the far row or column of the neighbourhood is new
+			for (int remaining = std::abs(end.x - cell.x) + std::abs(end.y - cell.y); remaining > 0; remaining--)
+			{
+				if (cell.y == end.y || (cell.x != end.x && nextX < nextY))
+				{
+					cell.x += sx;
+					nextX += stepX;
+					const int x = cell.x + sx * kx;
+					if (!VisitCells(Point(x, cell.y - ky), Point(x, cell.y + ky), test)) return;
+				}
+				else
+				{
+					cell.y += sy;
+					nextY += stepY;
+					const int y = cell.y + sy * ky;
+					if (!VisitCells(Point(cell.x - kx, y), Point(cell.x + kx, y), test)) return;
+				}
+			}
+		}
+	};
+}
+
+#endif
+#endif
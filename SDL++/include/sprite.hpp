@@ -0,0 +1,150 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 5)
+#ifndef SDL_sprite_hpp_
+#define SDL_sprite_hpp_
+#pragma once
+
+#include "rect.hpp"
+#include "rwops.hpp"
+#include "surface.hpp"
+
+#include <string>
+#include <vector>
+
+namespace SDL
+{
+	/**
+	 *  \brief    A sprite encoded once as runs of transparent, opaque and translucent pixels on each row.
+	 *
+	 *  \details  Blitting a compiled sprite skips transparent runs without reading them, copies opaque
+	 *            runs with memcpy and only blends the translucent ones, which makes mostly transparent
+	 *            or mostly opaque sprites much cheaper to draw than a per-pixel alpha blit. The encoding
+	 *            can be saved and loaded through RWops, so it can be built with the assets rather than
+	 *            at startup.
+	 *
+	 *            Pixels are stored in a 32-bit format with 8-bit channels, and blits need a destination
+	 *            in that same format. Blits always composite like BlendMode::BLEND, using premultiplied
+	 *            alpha if the source surface was premultiplied, and ignore colour and alpha mods.
+	 */
+	struct CompiledSprite
+	{
+		// What a run does to the destination
+		enum class RunType : Uint32
+		{
+			SKIP  = 0, // Fully transparent; the destination is left untouched
+			COPY  = 1, // Fully opaque; the pixels are copied
+			BLEND = 2  // Translucent; the pixels are blended
+		};
+
+		static constexpr Uint32 RUN_TYPE_SHIFT = 30;
+		static constexpr Uint32 RUN_LENGTH_MASK = (1u << RUN_TYPE_SHIFT) - 1;
+
+		int w = 0, h = 0;
+		Uint32 format = SDL_PIXELFORMAT_UNKNOWN; // The pixel format of pixels, and of the surfaces the sprite can be blitted to
+		bool premultiplied = false;              // True if the translucent pixels have premultiplied alpha
+
+		std::vector<Uint32> runs;      // The runs of every row in order, as the RunType in the top two bits and the length below
+		std::vector<Uint32> rowRuns;   // The index of the first run of each row, followed by runs.size()
+		std::vector<Uint32> rowPixels; // The index of the first stored pixel of each row, followed by pixels.size()
+		std::vector<Uint32> pixels;    // The opaque and translucent pixels, in run order
+
+		inline static constexpr RunType GetRunType(Uint32 run) { return (RunType)(run >> RUN_TYPE_SHIFT); }
+		inline static constexpr Uint32 GetRunLength(Uint32 run) { return run & RUN_LENGTH_MASK; }
+		inline static constexpr Uint32 MakeRun(RunType type, Uint32 length) { return ((Uint32)type << RUN_TYPE_SHIFT) | length; }
+
+		inline CompiledSprite() {}
+
+		/**
+		 *  \brief    Encode a surface.
+		 *
+		 *  \details  Pixels with zero alpha (or matching the colour key) become transparent runs, and pixels with
+		 *            full alpha become opaque runs. Surfaces without alpha or a colour key are entirely opaque.
+		 *
+		 *  \param    surface: The image to encode.
+		 *  \param    format:  The 32-bit, 8-bit channel pixel format to store, which blit destinations must use.
+		 *                     SDL_PIXELFORMAT_UNKNOWN keeps the surface's format if it qualifies, and uses ARGB8888 otherwise.
+		 *
+		 *  \note     If encoding fails the sprite is left invalid; call SDL::GetError() for more information.
+		 */
+		CompiledSprite(const Surface& surface, Uint32 format = SDL_PIXELFORMAT_UNKNOWN);
+
+		// Evaluates to true if the sprite holds an encoding.
+		inline bool IsValid() const { return format != SDL_PIXELFORMAT_UNKNOWN; }
+
+		inline Point GetSize() const { return { w, h }; }
+
+		/**
+		 * Draw the sprite onto a surface.
+		 *
+		 * The sprite is clipped to the destination's clip rectangle.
+		 *
+		 * \param dst the surface to draw on, which must be in the sprite's format
+		 * \param pos the position of the sprite's top left corner on dst
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool Blit(Surface& dst, const Point& pos) const;
+
+		/**
+		 * Decode the sprite into a new surface.
+		 *
+		 * \returns a surface in the sprite's format with transparent pixels set
+		 *          to zero, or an invalid surface on failure; call SDL::GetError()
+		 *          for more information.
+		 */
+		Surface ToSurface() const;
+
+		/**
+		 * Load a compiled sprite from a seekable SDL data stream.
+		 *
+		 * \param src the data stream for the sprite
+		 * \param freesrc true to close the stream after being read
+		 * \returns the sprite, or an invalid sprite on failure; call
+		 *          SDL::GetError() for more information.
+		 */
+		static CompiledSprite Load_RW(RWops& src, bool freesrc);
+
+		/**
+		 * Load a compiled sprite from a file.
+		 *
+		 * \param file the file containing the sprite
+		 * \returns the sprite, or an invalid sprite on failure; call
+		 *          SDL::GetError() for more information.
+		 */
+		inline static CompiledSprite Load(const char* file)
+		{
+			RWops src = RWops::FromFile(file, "rb");
+			if ((SDL_RWops*)src == NULL) return CompiledSprite();
+			return Load_RW(src, true);
+		}
+		inline static CompiledSprite Load(const std::string& file) { return Load(file.c_str()); }
+
+		/**
+		 * Save the sprite to a seekable SDL data stream.
+		 *
+		 * \param dst a data stream to save to
+		 * \param freedst true to close the stream after being written
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool Save_RW(RWops& dst, bool freedst) const;
+
+		/**
+		 * Save the sprite to a file.
+		 *
+		 * \param file a file to save to
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		inline bool Save(const char* file) const
+		{
+			RWops dst = RWops::FromFile(file, "wb");
+			if ((SDL_RWops*)dst == NULL) return false;
+			return Save_RW(dst, true);
+		}
+		inline bool Save(const std::string& file) const { return Save(file.c_str()); }
+	};
+}
+
+#endif
+#endif
@@ -11,8 +11,12 @@
 #include "rwops.hpp"
 #include "blendmode.hpp"
 #include "pixels.hpp"
+#include "transform.hpp"
 
 #include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
 
 namespace SDL
 {
@@ -20,6 +24,84 @@ namespace SDL
 	// The type of function used for surface blitting functions.
 	typedef SDL_blit blit;
 
+	// The colour space pixels are averaged in when a surface is resampled in software.
+	enum class FilterSpace
+	{
+		STRAIGHT,      // Channels are averaged as stored; transparent pixels bleed their colour into edges
+		PREMULTIPLIED, // Colours are weighted by alpha, so transparent pixels do not contribute colour
+		LINEAR         // Colours are converted from sRGB to linear light, weighted by alpha and averaged
+	};
+
+	// The space colour channels are mixed in by the software blits and filters.
+	enum class ColourSpace
+	{
+		SRGB,  // Channels are mixed as stored, which is fastest but darkens gradients, edges and blurs
+		LINEAR // Colour is converted from sRGB to linear light through lookup tables, mixed, and converted back
+	};
+
+	// How pixels are read when a surface is transformed in software.
+	enum class SampleMode
+	{
+		NEAREST, // The pixel containing the sample point
+		BILINEAR // A weighted average of the four pixels around the sample point
+	};
+
+	/**
+	 *  \brief    A typed view of a block of pixel rows, which steps between rows by the pitch rather than the width.
+	 *
+	 *  \details  Iterating a PixelSpan gives each row as a std::span<T> of width pixels, so
+	 *            `for (auto row : surface.Rows<Uint32>()) for (Uint32& p : row)` visits every
+	 *            pixel without touching the padding at the end of each row.
+	 *
+	 *  \note     A PixelSpan does not own or lock the pixels. Lock the surface first if it must be locked.
+	 */
+	template <typename T>
+	struct PixelSpan
+	{
+		typedef std::conditional_t<std::is_const_v<T>, const Uint8, Uint8> Byte;
+
+		Byte* pixels = nullptr;
+		int width = 0;
+		int height = 0;
+		int pitch = 0; // The number of bytes between the start of one row and the next
+
+		struct Iterator
+		{
+			Byte* row;
+			int width;
+			int pitch;
+
+			inline std::span<T> operator*() const { return std::span<T>((T*)row, (size_t)width); }
+			inline Iterator& operator++() { row += pitch; return *this; }
+			inline Iterator operator++(int) { Iterator it = *this; row += pitch; return it; }
+			inline bool operator==(const Iterator& that) const { return row == that.row; }
+			inline bool operator!=(const Iterator& that) const { return row != that.row; }
+		};
+
+		inline constexpr PixelSpan() = default;
+		inline constexpr PixelSpan(Byte* pixels, int width, int height, int pitch)
+			: pixels(pixels), width(width), height(height), pitch(pitch) {}
+
+		inline bool empty() const { return pixels == nullptr || width <= 0 || height <= 0; }
+		inline Point size() const { return { width, height }; }
+
+		inline Iterator begin() const { return { pixels, width, pitch }; }
+		inline Iterator end() const { return { empty() ? pixels : pixels + (ptrdiff_t)height * pitch, width, pitch }; }
+
+		// Get row y.
+		inline std::span<T> operator[](int y) const { return std::span<T>((T*)(pixels + (ptrdiff_t)y * pitch), (size_t)width); }
+
+		// Get the pixel at (x, y).
+		inline T& at(int x, int y) const { return ((T*)(pixels + (ptrdiff_t)y * pitch))[x]; }
+		inline T& at(const Point& p) const { return at(p.x, p.y); }
+
+		// Get the part of this span covering a rectangle, which must lie inside it.
+		inline PixelSpan sub(const Rect& r) const
+			{ return PixelSpan(pixels + (ptrdiff_t)r.y * pitch + (ptrdiff_t)r.x * (ptrdiff_t)sizeof(T), r.w, r.h, pitch); }
+	};
+
+	struct SurfaceDiff;
+
 	/**
 	 *  \brief    A collection of pixels used in software blitting.
 	 *
@@ -32,6 +114,10 @@ namespace SDL
 
 		std::shared_ptr<Palette> palette = nullptr; // Stores a palette set with SetPalette(), if any
 
+		// A bit of SDL_Surface::flags that SDL does not use, set if the colour channels have been multiplied by
+		// alpha. It is kept with the SDL_Surface so every Surface using it agrees; see Premultiply().
+		static constexpr Uint32 PREMULTIPLIED = 0x40000000;
+
 		// This is custom destructor for smart pointers that destroys SDL_Surfaces through SDL
 		inline static void DestroySurface(SDL_Surface* surface) { SDL_FreeSurface(surface); }
 
@@ -119,7 +205,7 @@ namespace SDL
 		inline Surface() : Surface(nullptr) {};
 		inline Surface(const Surface& s) : Surface(s.surface) {};
 		inline Surface(Surface&& s) noexcept { std::swap(surface, s.surface); }
-		inline Surface& operator=(const Surface& that) { surface = that.surface; };
+		inline Surface& operator=(const Surface& that) { surface = that.surface; return *this; }
 		inline Surface& operator=(Surface&& that) noexcept { std::swap(surface, that.surface); return *this; }
 
 		inline bool operator==(const Surface& that) { return surface == that.surface; }
@@ -454,6 +540,46 @@ namespace SDL
 		 */
 		inline bool GetBlendMode(BlendMode& blendMode) { return SDL_GetSurfaceBlendMode(surface.get(), (SDL_BlendMode*)&blendMode) == 0; }
 
+		/**
+		 * Multiply the colour channels of this surface by its alpha, once.
+		 *
+		 * The pixels are changed in place, so every Surface using the same
+		 * SDL_Surface sees the change. Afterwards IsPremultiplied() is true for
+		 * all of them, BlitSurface() and BlitScaled() composite the surface with
+		 * premultiplied arithmetic, and Textures created from it use the
+		 * premultiplied equivalent of their blend mode. Calling this on a
+		 * surface that is already premultiplied does nothing.
+		 *
+		 * Surfaces without an alpha channel are already premultiplied and are only
+		 * flagged. Alpha not stored as four 8-bit channels is premultiplied through
+		 * ARGB8888 and stored back in the surface's own format. Palettes are shared
+		 * with other surfaces, so a paletted surface with translucent colours cannot
+		 * be premultiplied; convert it to a format with an alpha channel first.
+		 *
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool Premultiply();
+
+		// Evaluates to true if the colour channels have been multiplied by alpha; see Premultiply().
+		inline bool IsPremultiplied() const { return surface && (surface->flags & PREMULTIPLIED) != 0; }
+
+		/**
+		 * Mark the pixels of this surface as premultiplied or not, without changing them.
+		 *
+		 * This is for surfaces filled with premultiplied colour some other way,
+		 * such as copies of a premultiplied surface. The mark is kept with the
+		 * SDL_Surface, so every Surface using it sees the change.
+		 *
+		 * \param premultiplied true if the colour channels hold colour multiplied by alpha
+		 */
+		inline void SetPremultiplied(bool premultiplied)
+		{
+			if (!surface) return;
+			if (premultiplied) surface->flags |= PREMULTIPLIED;
+			else surface->flags &= ~PREMULTIPLIED;
+		}
+
 		/**
 		 * Set the clipping rectangle for this surface.
 		 *
@@ -505,7 +631,98 @@ namespace SDL
 		 * \returns a copy of the surface, or an invalid surface on failure; call
 		 *          SDL::GetError() for more information.
 		 */
-		inline Surface Duplicate() { return FromPtr(SDL_DuplicateSurface(surface.get())); }
+		inline Surface Duplicate()
+		{
+			Surface copy = FromPtr(SDL_DuplicateSurface(surface.get()));
+			copy.SetPremultiplied(IsPremultiplied());
+			return copy;
+		}
+
+		/**
+		 * Create a surface sharing the pixels of an area of this surface.
+		 *
+		 * Nothing is copied: drawing to the view draws to this surface, and the
+		 * view keeps this surface alive for as long as it exists. The view starts
+		 * with the palette, blend mode, colour key, colour and alpha mods and
+		 * premultiplied flag of this surface; changing them on the view afterwards
+		 * does not affect this surface.
+		 *
+		 * The area is clipped to the surface. Surfaces with RLE acceleration
+		 * enabled, or fewer than 8 bits per pixel, cannot be viewed.
+		 *
+		 * \param rect the area of this surface to view
+		 * \returns the view, or an invalid surface on failure; call
+		 *          SDL::GetError() for more information.
+		 */
+		Surface View(const Rect& rect) const;
+
+		/**
+		 * Get a typed view of the rows of pixels.
+		 *
+		 * The surface must be locked while the span is used if MustLock() is true.
+		 *
+		 * \returns a span over the pixels, or an empty span if the surface is
+		 *          invalid or sizeof(T) is not its number of bytes per pixel.
+		 */
+		template <typename T>
+		inline PixelSpan<T> Rows() const
+		{
+			if (!surface || surface->format->BytesPerPixel != sizeof(T)) return PixelSpan<T>();
+			return PixelSpan<T>((typename PixelSpan<T>::Byte*)surface->pixels, surface->w, surface->h, surface->pitch);
+		}
+
+		/**
+		 * Compute a 64-bit hash of the pixels of this surface.
+		 *
+		 * Only the visible pixels are read, not the padding at the end of each
+		 * row, and the size, pixel format and palette are hashed too. Unused
+		 * bits in formats without alpha, such as the padding byte of XRGB8888,
+		 * are left out, as Diff() and Matches() ignore them, so surfaces in one
+		 * format that match exactly hash the same. The hash is the same on
+		 * every platform and with or without SIMD, so it can be stored and
+		 * compared between runs, but it is not cryptographic.
+		 *
+		 * \returns the hash, or 0 if the surface is invalid or cannot be locked.
+		 */
+		Uint64 Hash() const;
+
+		/**
+		 * Compare the pixels of this surface with another surface of the same size.
+		 *
+		 * Surfaces in the same 32-bit format with 8-bit channels are compared
+		 * directly; otherwise both are converted to RGBA32 first. Channels are
+		 * compared as stored, so a premultiplied surface only matches another
+		 * premultiplied surface.
+		 *
+		 * A pixel counts as different if any channel differs, or if `threshold`
+		 * is above 0, if its perceptual difference exceeds the threshold. The
+		 * perceptual difference weighs the change in brightness more than the
+		 * change in hue, after blending both pixels over white by their alpha.
+		 *
+		 * \param other the surface to compare with
+		 * \param result filled in with the error in each channel, the number of
+		 *               different pixels and, if `mask` is true, the mask
+		 * \param threshold the perceptual difference allowed, from 0 (exact) to
+		 *                  1 (anything)
+		 * \param mask true to create a mask of the pixels that differ
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool Diff(const Surface& other, SurfaceDiff& result, float threshold = 0.0f, bool mask = false) const;
+
+		/**
+		 * Check whether this surface matches another, stopping at the first pixel
+		 * that differs.
+		 *
+		 * This is faster than Diff() when only a yes or no answer is needed.
+		 *
+		 * \param other the surface to compare with
+		 * \param threshold the perceptual difference allowed, as for Diff()
+		 * \returns true if the surfaces have the same size and no pixel differs
+		 *          by more than the threshold, or false otherwise or on failure;
+		 *          call SDL::GetError() for more information.
+		 */
+		bool Matches(const Surface& other, float threshold = 0.0f) const;
 
 		/**
 		 * Copy this surface to a new surface of the specified format.
@@ -704,12 +921,20 @@ namespace SDL
 		 *  You should call BlitSurface() unless you know exactly how SDL blitting works
 		 *  internally and how to use the other blit functions.
 		 */
-		inline bool BlitSurface(const Rect* srcrect, Surface& dst, Rect* dstrect) { return SDL_BlitSurface(surface.get(), (const SDL_Rect*)srcrect, dst.surface.get(), (SDL_Rect*)dstrect) == 0; }
+		inline bool BlitSurface(const Rect* srcrect, Surface& dst, Rect* dstrect)
+		{
+			if (IsPremultiplied()) return BlitPremultiplied(srcrect, dst, dstrect);
+			return SDL_BlitSurface(surface.get(), (const SDL_Rect*)srcrect, dst.surface.get(), (SDL_Rect*)dstrect) == 0;
+		}
 		inline bool BlitSurface(const Rect& srcrect, Surface& dst, Rect& dstrect) { return BlitSurface(&srcrect, dst, &dstrect); }
 		inline bool BlitSurface(                     Surface& dst, Rect& dstrect) { return BlitSurface(NULL,     dst, &dstrect); }
 		inline bool BlitSurface(const Rect& srcrect, Surface& dst               ) { return BlitSurface(&srcrect, dst, NULL    ); }
 		inline bool BlitSurface(                     Surface& dst               ) { return BlitSurface(NULL,     dst, NULL    ); }
 
+		// Perform a fast blit, mixing colour in the given space; see BlitLinear().
+		inline bool BlitSurface(const Rect* srcrect, Surface& dst, Rect* dstrect, ColourSpace space)
+			{ return space == ColourSpace::LINEAR ? BlitLinear(srcrect, dst, dstrect) : BlitSurface(srcrect, dst, dstrect); }
+
 		/**
 		 * Perform low-level surface blitting only.
 		 *
@@ -751,12 +976,20 @@ namespace SDL
 #endif
 
 		// Perform a scaled surface copy to a destination surface.
-		inline bool BlitScaled(Rect* srcrect, Surface& dst, Rect* dstrect) const { return SDL_BlitScaled(surface.get(), (SDL_Rect*)srcrect, dst.surface.get(), (SDL_Rect*)dstrect) == 0; }
+		inline bool BlitScaled(Rect* srcrect, Surface& dst, Rect* dstrect) const
+		{
+			if (IsPremultiplied()) return BlitScaledPremultiplied(srcrect, dst, dstrect);
+			return SDL_BlitScaled(surface.get(), (SDL_Rect*)srcrect, dst.surface.get(), (SDL_Rect*)dstrect) == 0;
+		}
 		inline bool BlitScaled(Rect& srcrect, Surface& dst, Rect& dstrect) const { return BlitScaled(&srcrect, dst, &dstrect); }
 		inline bool BlitScaled(               Surface& dst, Rect& dstrect) const { return BlitScaled(NULL,     dst, &dstrect); }
 		inline bool BlitScaled(Rect& srcrect, Surface& dst               ) const { return BlitScaled(&srcrect, dst, NULL    ); }
 		inline bool BlitScaled(               Surface& dst               ) const { return BlitScaled(NULL,     dst, NULL    ); }
 
+		// Perform a scaled surface copy, mixing colour in the given space; see BlitScaledLinear().
+		inline bool BlitScaled(Rect* srcrect, Surface& dst, Rect* dstrect, ColourSpace space) const
+			{ return space == ColourSpace::LINEAR ? BlitScaledLinear(srcrect, dst, dstrect) : BlitScaled(srcrect, dst, dstrect); }
+
 		/**
 		 * Perform low-level surface scaled blitting only.
 		 *
@@ -773,6 +1006,148 @@ namespace SDL
 		 */
 		inline bool LowerBlitScaled(Rect& srcrect, Surface& dst, Rect& dstrect)
 			{ return SDL_LowerBlitScaled(surface.get(), (SDL_Rect*)&srcrect, dst.surface.get(), (SDL_Rect*)&dstrect) == 0; }
+
+		/**
+		 * Build a mipmap chain from this surface.
+		 *
+		 * Each level is half the size of the previous one (rounded down, but never
+		 * smaller than 1x1), and is produced with a 2x2 box filter. The first
+		 * element is this surface, or a 32-bit copy of it if its format does not
+		 * have four 8-bit channels; every level shares that format and blend mode.
+		 *
+		 * Colour keys are not considered; convert colour keyed surfaces to a format
+		 * with an alpha channel first.
+		 *
+		 * If this surface is premultiplied, its channels are averaged as stored
+		 * whatever the requested space, and every level is flagged premultiplied.
+		 *
+		 * \param space the colour space the box filter averages pixels in
+		 * \param max_levels the maximum number of levels to return, including the
+		 *                   first, or 0 to halve all the way down to 1x1
+		 * \returns the levels of the chain, or an empty vector on failure; call
+		 *          SDL::GetError() for more information.
+		 */
+		std::vector<Surface> BuildMipChain(FilterSpace space = FilterSpace::PREMULTIPLIED, int max_levels = 0) const;
+
+		/**
+		 * Blit this surface as premultiplied colour, regardless of IsPremultiplied().
+		 *
+		 * BlendMode::BLEND computes dst = src + dst * (1 - srcA) on every channel,
+		 * and BlendMode::ADD computes dstRGB = srcRGB + dstRGB. Other blend modes,
+		 * and sources without an alpha channel, are passed on to SDL unchanged.
+		 * Colour and alpha modulation are applied; colour keys are ignored.
+		 *
+		 * Both surfaces must store their channels as 8-bit components of a 32-bit
+		 * pixel. Clipping follows BlitSurface(), and dstrect is filled in with the
+		 * final blit rectangle.
+		 *
+		 * \param srcrect the rectangle to be copied, or NULL to copy the entire
+		 *                surface
+		 * \param dst the blit target
+		 * \param dstrect the position to copy to, or NULL to copy to (0, 0)
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool BlitPremultiplied(const Rect* srcrect, Surface& dst, Rect* dstrect) const;
+
+		/**
+		 * Perform a scaled blit of this surface as premultiplied colour.
+		 *
+		 * The source is stretched into a temporary surface with SDL's scaler, then
+		 * composited with BlitPremultiplied().
+		 *
+		 * \param srcrect the rectangle to be copied, or NULL to copy the entire
+		 *                surface
+		 * \param dst the blit target
+		 * \param dstrect the rectangle to stretch into, or NULL to fill dst
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool BlitScaledPremultiplied(const Rect* srcrect, Surface& dst, Rect* dstrect) const;
+
+		/**
+		 * Blit this surface, blending its colour with the destination in linear light.
+		 *
+		 * This behaves like BlitSurface(), but BlendMode::BLEND and ADD convert
+		 * the colour channels of both surfaces from sRGB to linear light before
+		 * mixing them, so translucent edges and overlapping glows keep their
+		 * brightness instead of darkening. Alpha is mixed as usual. Other blend
+		 * modes, sources without an alpha channel and premultiplied surfaces
+		 * (see BlitPremultiplied()) are blitted as stored. Colour and alpha
+		 * modulation are applied; colour keys are ignored.
+		 *
+		 * Both surfaces must store their channels as 8-bit components of a 32-bit
+		 * pixel. Clipping follows BlitSurface(), and dstrect is filled in with the
+		 * final blit rectangle.
+		 *
+		 * \param srcrect the rectangle to be copied, or NULL to copy the entire
+		 *                surface
+		 * \param dst the blit target
+		 * \param dstrect the position to copy to, or NULL to copy to (0, 0)
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool BlitLinear(const Rect* srcrect, Surface& dst, Rect* dstrect) const;
+
+		/**
+		 * Perform a scaled blit of this surface, blending in linear light.
+		 *
+		 * The source is stretched into a temporary surface with SDL's scaler, then
+		 * composited with BlitLinear().
+		 *
+		 * \param srcrect the rectangle to be copied, or NULL to copy the entire
+		 *                surface
+		 * \param dst the blit target
+		 * \param dstrect the rectangle to stretch into, or NULL to fill dst
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool BlitScaledLinear(const Rect* srcrect, Surface& dst, Rect* dstrect) const;
+
+		/**
+		 * Blit this surface through an affine transform.
+		 *
+		 * The transform maps coordinates relative to the top left corner of srcrect
+		 * onto the destination, so Transform2D::around() the centre of srcrect
+		 * rotates it in place. Each destination pixel in the transformed bounding
+		 * box is sampled at its centre. Transforms that only turn by multiples of 90
+		 * degrees, flip, and move by whole pixels copy pixels exactly, without
+		 * any resampling.
+		 *
+		 * The destination must store its channels as 8-bit components of a 32-bit
+		 * pixel; the source is converted to its channel order if needed, keeping
+		 * its alpha in the unused byte when the destination has none. The source
+		 * blend mode may be BlendMode::NONE, BLEND or ADD, and premultiplied
+		 * surfaces composite as such. Colour keys and colour and alpha modulation
+		 * are not applied, and the destination clip rectangle is respected.
+		 *
+		 * With ColourSpace::LINEAR, bilinear samples and blending mix colour in
+		 * linear light. Premultiplied surfaces are always mixed as stored.
+		 *
+		 * \param srcrect the rectangle to be transformed, or NULL for the entire
+		 *                surface
+		 * \param dst the blit target
+		 * \param transform the mapping from source to destination coordinates
+		 * \param sampling how source pixels are read
+		 * \param space the space colour is mixed in
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool BlitTransformed(const Rect* srcrect, Surface& dst, const Transform2D& transform, SampleMode sampling = SampleMode::NEAREST, ColourSpace space = ColourSpace::SRGB) const;
+		inline bool BlitTransformed(const Rect& srcrect, Surface& dst, const Transform2D& transform, SampleMode sampling = SampleMode::NEAREST, ColourSpace space = ColourSpace::SRGB) const { return BlitTransformed(&srcrect, dst, transform, sampling, space); }
+		inline bool BlitTransformed(                     Surface& dst, const Transform2D& transform, SampleMode sampling = SampleMode::NEAREST, ColourSpace space = ColourSpace::SRGB) const { return BlitTransformed(NULL,     dst, transform, sampling, space); }
+	};
+
+	// The result of Surface::Diff(). Channel errors are given in the order red, green, blue, alpha.
+	struct SurfaceDiff
+	{
+		Uint8 maxError[4] = { 0, 0, 0, 0 };           // The largest absolute difference in each channel
+		double meanError[4] = { 0.0, 0.0, 0.0, 0.0 }; // The mean absolute difference in each channel
+		Uint64 differing = 0;                         // The number of pixels that differ
+		Surface mask = Surface::FromPtr(NULL);        // If requested, an INDEX8 surface with greyscale colours, 255 where pixels differ and 0 elsewhere
+
+		// Evaluates to true if no pixel differs.
+		inline bool Identical() const { return differing == 0; }
 	};
 
 	/**
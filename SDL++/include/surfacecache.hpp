@@ -0,0 +1,192 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 5)
+#ifndef SDL_surfacecache_hpp_
+#define SDL_surfacecache_hpp_
+#pragma once
+
+#include "surface.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SDL
+{
+	/**
+	 *  \brief    A lossless compressed copy of a surface, kept in memory.
+	 *
+	 *  \details  Surfaces in a 32-bit format with 8-bit channels are encoded with the operations of the QOI image
+	 *            format (runs, a table of recent colours, and small channel differences), which shrinks typical
+	 *            sprites and UI art several times over. Other formats, including paletted ones, store each row
+	 *            as its difference from the row above, with runs of zero bytes collapsed.
+	 *
+	 *            The image is split into bands of BAND_ROWS rows that are encoded independently, so both
+	 *            compression and decompression can be split across CPU cores. The blend mode, colour and alpha
+	 *            mods, colour key, palette and premultiplied flag are kept and restored on decompression.
+	 */
+	struct CompressedSurface
+	{
+		// How the pixels are encoded
+		enum class Codec : Uint8
+		{
+			QOI,  // QOI operations on 32-bit pixels with 8-bit channels
+			ROWS  // Byte differences from the row above, with zero runs, for every other format
+		};
+
+		static constexpr int BAND_ROWS = 32;
+
+		int w = 0, h = 0;
+		Uint32 format = SDL_PIXELFORMAT_UNKNOWN;
+		Codec codec = Codec::QOI;
+		bool premultiplied = false;
+		Uint64 hash = 0; // Surface::Hash() of the original surface
+
+		SDL_BlendMode blendMode = SDL_BLENDMODE_NONE;
+		Uint8 colourMod[3] = { 255, 255, 255 };
+		Uint8 alphaMod = 255;
+		bool keyed = false;
+		Uint32 colourKey = 0;
+		std::vector<SDL_Colour> palette;
+
+		std::vector<Uint32> bands; // The offset of each band into data, followed by data.size()
+		std::vector<Uint8> data;
+
+		inline CompressedSurface() {}
+
+		/**
+		 *  \brief    Compress a surface.
+		 *
+		 *  \param    surface:  The surface to compress.
+		 *  \param    parallel: Whether to split the bands across CPU cores.
+		 *
+		 *  \note     If compression fails the copy is left invalid; call SDL::GetError() for more information.
+		 */
+		CompressedSurface(const Surface& surface, bool parallel = true);
+
+		// Evaluates to true if the copy holds an image.
+		inline bool IsValid() const { return format != SDL_PIXELFORMAT_UNKNOWN; }
+
+		inline Point GetSize() const { return { w, h }; }
+
+		// The number of bytes the encoded pixels take up.
+		inline size_t CompressedSize() const { return data.size() + bands.size() * sizeof(Uint32) + palette.size() * sizeof(SDL_Colour); }
+
+		// The number of bytes in a row of pixels, without padding. Formats under 8 bits per pixel pack several pixels to a byte.
+		inline size_t RowSize() const { return ((size_t)w * SDL_BITSPERPIXEL(format) + 7) / 8; }
+
+		// The number of bytes the pixels take up once decompressed, without row padding.
+		inline size_t DecompressedSize() const { return RowSize() * h; }
+
+		/**
+		 * Decompress the pixels into an existing surface.
+		 *
+		 * Only the pixels are written; the blend mode, mods and colour key of dst
+		 * are left as they are.
+		 *
+		 * \param dst a surface with the same size and format as the original
+		 * \param parallel whether to split the bands across CPU cores
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool Decompress(Surface& dst, bool parallel = true) const;
+
+		/**
+		 * Decompress the image into a new surface.
+		 *
+		 * \param parallel whether to split the bands across CPU cores
+		 * \returns the surface, or an invalid surface on failure; call
+		 *          SDL::GetError() for more information.
+		 */
+		Surface Decompress(bool parallel = true) const;
+
+		/**
+		 * Copy the blend mode, mods, colour key, palette and premultiplied flag
+		 * of the original surface onto a surface holding the decompressed pixels.
+		 *
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool RestoreState(Surface& dst) const;
+	};
+
+	/**
+	 *  \brief    A store of surfaces kept compressed while they are not in use.
+	 *
+	 *  \details  Surfaces that have been evicted from memory, but may need to be uploaded again (for instance after
+	 *            a RENDER_TARGETS_RESET or RENDER_DEVICE_RESET event), are stored as CompressedSurfaces under a key.
+	 *            Get() decompresses one into a buffer taken from a pool, and the buffer goes back to the pool once
+	 *            the last copy of the returned surface is destroyed, so re-uploading a whole asset set allocates
+	 *            little more than its largest images.
+	 *
+	 *            The cache itself is not thread safe, but surfaces it returns may be released on any thread.
+	 */
+	struct SurfaceCache
+	{
+		struct BufferPool;
+
+		std::unordered_map<std::string, CompressedSurface> entries;
+		std::shared_ptr<BufferPool> pool;
+
+		/**
+		 *  \brief    Create an empty cache.
+		 *
+		 *  \param    pool_limit: The most bytes of idle buffers the pool keeps for reuse. Buffers released beyond this are freed.
+		 */
+		SurfaceCache(size_t pool_limit = 64 << 20);
+
+		/**
+		 * Compress a surface and store it under a key, replacing any surface
+		 * already stored under it.
+		 *
+		 * If the stored surface has the same hash as the new one it is kept as
+		 * it is, so surfaces that are evicted again without changing are not
+		 * compressed twice.
+		 *
+		 * \param key the name to store the surface under
+		 * \param surface the surface to compress
+		 * \param parallel whether to split compression across CPU cores
+		 * \returns true on success or false on failure; call SDL::GetError() for
+		 *          more information.
+		 */
+		bool Store(const std::string& key, const Surface& surface, bool parallel = true);
+
+		/**
+		 * Decompress a stored surface into a pooled buffer.
+		 *
+		 * The surface stays in the cache. Its pixels are owned by the pool, and are
+		 * returned to it when the last copy of the surface is destroyed.
+		 *
+		 * \param key the name the surface was stored under
+		 * \param parallel whether to split decompression across CPU cores
+		 * \returns the surface, or an invalid surface if there is none under key
+		 *          or decompression fails; call SDL::GetError() for more
+		 *          information.
+		 */
+		Surface Get(const std::string& key, bool parallel = true) const;
+
+		// Evaluates to true if a surface is stored under key.
+		inline bool Contains(const std::string& key) const { return entries.find(key) != entries.end(); }
+
+		// Remove the surface stored under key. Returns false if there was none.
+		inline bool Remove(const std::string& key) { return entries.erase(key) != 0; }
+
+		// Remove every stored surface. Pooled buffers are kept.
+		inline void Clear() { entries.clear(); }
+
+		// The number of bytes taken up by every stored surface.
+		size_t CompressedBytes() const;
+
+		// The number of bytes the stored surfaces would take up decompressed.
+		size_t DecompressedBytes() const;
+
+		// The number of bytes of idle buffers held by the pool.
+		size_t PooledBytes() const;
+
+		// Free idle pooled buffers until no more than max_bytes are held.
+		void TrimPool(size_t max_bytes = 0);
+	};
+}
+
+#endif
+#endif
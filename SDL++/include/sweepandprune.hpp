@@ -0,0 +1,82 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+#ifndef SDL_sweepandprune_hpp_
+#define SDL_sweepandprune_hpp_
+#pragma once
+
+#include <SDL_stdinc.h>
+
+#include "container.hpp"
+#include "rect.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace SDL
+{
+	/**
+	 *  \brief    A sort and sweep broadphase, finding every pair of overlapping rectangles in a set updated each frame.
+	 *
+	 *  \details  Rectangles are kept in a list sorted by their left (or top) edges, which is re-sorted each frame with
+	 *            an insertion sort. Rectangles move little between frames, so the list is nearly sorted already and
+	 *            this is close to linear. A sweep along the list then only tests rectangles whose spans on that axis
+	 *            overlap, with RectsIntersect(). The axis is switched to whichever the rectangles are spread out
+	 *            along more when it clearly pays off.
+	 *
+	 *            The pairs found are kept from one frame to the next, so Update() also reports which pairs began and
+	 *            ended overlapping, and collision responses need only run when something changes.
+	 */
+	struct SweepAndPrune
+	{
+		struct Pair
+		{
+			int a, b; // a < b
+
+			inline constexpr bool operator==(const Pair& p) const { return a == p.a && b == p.b; }
+		};
+
+		std::vector<FRect> rects;   // Each rectangle, by id
+		std::vector<int> order;     // Ids, sorted by the rectangles' near edges on the axis
+		std::vector<Uint64> pairs;  // Every overlapping pair, as sorted keys
+		std::vector<Uint64> previous;
+		std::vector<Pair> begun;    // Pairs that started overlapping in the last Update()
+		std::vector<Pair> ended;    // Pairs that stopped overlapping in the last Update()
+		int axis = 0;               // 0 to sweep along x, 1 along y
+
+		/**
+		 * Replace the rectangles and find the pairs that overlap.
+		 *
+		 * Rectangles keep their ids from one update to the next, so a pair of
+		 * ids is only reported as begun or ended when it changes. If count
+		 * shrinks, pairs with the removed ids are reported as ended.
+		 *
+		 * \param rects the rectangles, whose indices are their ids
+		 * \param count the number of rectangles
+		 */
+		void Update(const FRect* rects, int count);
+
+		template <typename T, typename = typename std::enable_if_t<ContinuousContainer_traits<FRect, T>::is_continuous_container>>
+		inline void Update(const T& rects) { Update(rects.data(), (int)rects.size()); }
+
+		// Remove every rectangle and pair, without reporting them as ended.
+		void Clear();
+
+		inline int Size() const { return (int)rects.size(); }
+
+		inline int PairCount() const { return (int)pairs.size(); }
+		inline Pair GetPair(int i) const { return Unkey(pairs[i]); }
+
+		// Evaluates to true if two rectangles overlapped at the last Update().
+		inline bool Overlapping(int a, int b) const { return std::binary_search(pairs.begin(), pairs.end(), Key(a, b)); }
+
+		// Call callback(a, b) for every overlapping pair, with a < b, in order.
+		template <typename F>
+		inline void ForEachPair(F&& callback) const { for (Uint64 key : pairs) { const Pair p = Unkey(key); callback(p.a, p.b); } }
+
+		inline static Uint64 Key(int a, int b) { return a < b ? (Uint64)a << 32 | (Uint32)b : (Uint64)b << 32 | (Uint32)a; }
+		inline static Pair Unkey(Uint64 key) { return { (int)(key >> 32), (int)(Uint32)key }; }
+	};
+}
+
+#endif
+#endif
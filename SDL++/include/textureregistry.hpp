@@ -0,0 +1,242 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 5)
+#ifndef SDL_textureregistry_hpp_
+#define SDL_textureregistry_hpp_
+#pragma once
+
+#include "observer.hpp"
+
+#include "events.hpp"
+#include "render.hpp"
+#include "rwops.hpp"
+#include "surface.hpp"
+#include "surfacecache.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SDL
+{
+	/**
+	 *  \brief    Textures that remember where they came from, so they can be recreated when the render device is lost.
+	 *
+	 *  \details  Each texture is registered with its source: a file, a block of memory, a Surface, a callback that
+	 *            generates a surface, or, for render targets, a callback that paints the target. Textures are handed
+	 *            out as shared pointers, and are replaced in place when recreated, so every holder sees the new one.
+	 *
+	 *            When the registry is notified of Event::Type::RENDER_DEVICE_RESET every texture is marked for
+	 *            recreation, and on RENDER_TARGETS_RESET every render target is marked for repainting. Update() then
+	 *            restores them a few at a time within a time budget, so recovery is spread over several frames. Textures
+	 *            marked visible with MarkVisible() since the last Update() go first, then higher priorities, then those
+	 *            seen most recently. Surfaces are decoded across CPU cores; uploading and painting stay on the
+	 *            calling thread.
+	 *
+	 *            Register the registry with Input::RegisterEventType() for both event types, or pass it events through
+	 *            Notify() directly.
+	 */
+	struct TextureRegistry : public Observer<const Event&>
+	{
+		// Where a texture's contents come from
+		enum class SourceType
+		{
+			FILE,      // An image file, read with decoder
+			MEMORY,    // An image file held in memory, read with decoder
+			SURFACE,   // A surface, kept compressed in cache or as it is
+			GENERATOR, // A callback returning a surface
+			TARGET     // A render target filled by a callback
+		};
+
+		// Returns the surface to create a texture from. Called on worker threads, so it must not use the renderer.
+		typedef std::function<Surface()> Generator;
+
+		// Draws the contents of a render target, which is already set as the renderer's target when called.
+		typedef std::function<bool(Renderer&, Texture&)> Painter;
+
+		// Reads an image from a data stream. Called on worker threads.
+		typedef std::function<Surface(RWops&)> Decoder;
+
+		struct Entry
+		{
+			std::shared_ptr<Texture> texture;
+			SourceType type = SourceType::SURFACE;
+
+			std::string file;                          // FILE: the path
+			std::shared_ptr<std::vector<Uint8>> data;  // MEMORY: the file contents
+			Surface surface = Surface::FromPtr(NULL);  // SURFACE: the surface, if it is not kept in cache
+			std::string cacheKey;                      // SURFACE: the key it is stored under in cache, if it is
+			Generator generate;                        // GENERATOR
+			Painter paint;                             // TARGET
+			Point size;                                // TARGET: the size of the target
+			Uint32 format = SDL_PIXELFORMAT_UNKNOWN;   // TARGET: the format of the target
+
+			int priority = 0;       // Higher priorities are restored first
+			Uint64 seenFrame = 0;   // The frame MarkVisible() was last called in
+			bool pending = false;   // True if the texture is waiting to be recreated or repainted
+			bool lost = false;      // True if the texture itself must be recreated, not just repainted
+		};
+
+		Renderer renderer;
+		Decoder decoder;    // Reads FILE and MEMORY sources; loads BMP files unless replaced, for instance with IMG::Load_RW
+		SurfaceCache cache; // Holds SURFACE sources that were added compressed
+
+		std::unordered_map<const Texture*, Entry> entries;
+		Uint64 frame = 1;   // Advanced by each Update()
+		Uint32 nextKey = 0; // Used to name surfaces stored in cache
+
+		/**
+		 *  \brief    Create an empty registry.
+		 *
+		 *  \param    renderer: The renderer the textures are created for.
+		 */
+		TextureRegistry(Renderer& renderer);
+
+		/**
+		 * Create a texture from an image file.
+		 *
+		 * \param file the file to read with decoder
+		 * \param priority the order to restore the texture in, higher first
+		 * \returns the texture, or NULL on failure; call SDL::GetError() for more
+		 *          information.
+		 */
+		std::shared_ptr<Texture> Load(const std::string& file, int priority = 0);
+
+		/**
+		 * Create a texture from an image file held in memory.
+		 *
+		 * The data is kept, and read again when the texture is recreated.
+		 *
+		 * \param data the file contents
+		 * \param priority the order to restore the texture in, higher first
+		 * \returns the texture, or NULL on failure; call SDL::GetError() for more
+		 *          information.
+		 */
+		std::shared_ptr<Texture> LoadMemory(std::vector<Uint8> data, int priority = 0);
+
+		/**
+		 * Create a texture from an image in a data stream.
+		 *
+		 * The rest of the stream is read into memory and kept, as with
+		 * LoadMemory().
+		 *
+		 * \param src the data stream for the image
+		 * \param freesrc true to close the stream after being read
+		 * \param priority the order to restore the texture in, higher first
+		 * \returns the texture, or NULL on failure; call SDL::GetError() for more
+		 *          information.
+		 */
+		std::shared_ptr<Texture> Load_RW(RWops& src, bool freesrc, int priority = 0);
+
+		/**
+		 * Create a texture from a surface.
+		 *
+		 * \param surface the surface to create the texture from
+		 * \param compress true to keep a compressed copy in cache, or false to
+		 *                 keep a reference to the surface itself
+		 * \param priority the order to restore the texture in, higher first
+		 * \returns the texture, or NULL on failure; call SDL::GetError() for more
+		 *          information.
+		 */
+		std::shared_ptr<Texture> Add(const Surface& surface, bool compress = true, int priority = 0);
+
+		/**
+		 * Create a texture from a surface returned by a callback.
+		 *
+		 * \param generate returns the surface; it is called again, possibly on
+		 *                 another thread, whenever the texture is recreated
+		 * \param priority the order to restore the texture in, higher first
+		 * \returns the texture, or NULL on failure; call SDL::GetError() for more
+		 *          information.
+		 */
+		std::shared_ptr<Texture> Generate(Generator generate, int priority = 0);
+
+		/**
+		 * Create a render target whose contents are drawn by a callback.
+		 *
+		 * The callback is called now, and again whenever the target is
+		 * recreated or its contents are lost.
+		 *
+		 * \param size the size of the target
+		 * \param paint draws the contents of the target
+		 * \param format the pixel format of the target
+		 * \param priority the order to restore the texture in, higher first
+		 * \returns the texture, or NULL on failure; call SDL::GetError() for more
+		 *          information.
+		 */
+		std::shared_ptr<Texture> CreateTarget(const Point& size, Painter paint, Uint32 format = (Uint32)PixelFormatEnum::RGBA32, int priority = 0);
+
+		/**
+		 * Forget a texture. Holders of it can keep using it, but it will not be
+		 * restored after a reset.
+		 *
+		 * \returns false if the texture was not registered.
+		 */
+		bool Remove(const std::shared_ptr<Texture>& texture);
+
+		// Mark a texture as drawn this frame, so it is restored before textures that are not.
+		inline void MarkVisible(const std::shared_ptr<Texture>& texture)
+		{
+			auto it = entries.find(texture.get());
+			if (it != entries.end()) it->second.seenFrame = frame;
+		}
+
+		// Set the order a texture is restored in, higher first.
+		inline void SetPriority(const std::shared_ptr<Texture>& texture, int priority)
+		{
+			auto it = entries.find(texture.get());
+			if (it != entries.end()) it->second.priority = priority;
+		}
+
+		// Evaluates to true if a texture is waiting to be recreated or repainted, and should not be drawn yet.
+		inline bool IsPending(const std::shared_ptr<Texture>& texture) const
+		{
+			auto it = entries.find(texture.get());
+			return it != entries.end() && it->second.pending;
+		}
+
+		// The number of textures waiting to be recreated or repainted.
+		size_t Pending() const;
+
+		/**
+		 * Mark the textures affected by a render event for restoring.
+		 *
+		 * Other events are ignored.
+		 */
+		void Notify(const Event& e);
+
+		/**
+		 * Restore pending textures, most important first, until the time budget
+		 * runs out. Call this once per frame.
+		 *
+		 * Surfaces are decoded in batches of one per CPU core, and at least one
+		 * batch is restored per call, so a small budget still makes progress.
+		 * Textures that fail to restore stay pending and are retried on the next
+		 * call.
+		 *
+		 * \param budget_ms the time to spend, in milliseconds
+		 * \returns the number of textures still pending.
+		 */
+		size_t Update(double budget_ms = 4.0);
+
+		/**
+		 * Restore every pending texture now.
+		 *
+		 * \returns true if every texture was restored, or false on failure; call
+		 *          SDL::GetError() for more information.
+		 */
+		inline bool RestoreAll()
+		{
+			while (Pending() > 0)
+			{
+				const size_t before = Pending();
+				if (Update(1e9) == before) return false;
+			}
+			return true;
+		}
+	};
+}
+
+#endif
+#endif
@@ -0,0 +1,92 @@
+#ifndef SDL_transform_hpp_
+#define SDL_transform_hpp_
+#pragma once
+
+#include "rect.hpp"
+
+#include <cmath>
+#include <string>
+
+namespace SDL
+{
+	// A 2D affine transform, mapping (x, y) to (a*x + c*y + tx, b*x + d*y + ty).
+	// Angles are in radians; with y pointing down, positive angles turn clockwise on screen.
+	struct Transform2D
+	{
+		float a, b, c, d, tx, ty;
+
+		inline constexpr Transform2D() : a(1), b(0), c(0), d(1), tx(0), ty(0) {}
+		inline constexpr Transform2D(float a, float b, float c, float d, float tx, float ty) : a(a), b(b), c(c), d(d), tx(tx), ty(ty) {}
+
+		inline static constexpr Transform2D translate(const FPoint& t) { return { 1, 0, 0, 1, t.x, t.y }; }
+		inline static constexpr Transform2D scale(const FPoint& s) { return { s.x, 0, 0, s.y, 0, 0 }; }
+		inline static constexpr Transform2D scale(float s) { return { s, 0, 0, s, 0, 0 }; }
+		inline static Transform2D rotate(float angle) { const float cs = std::cos(angle), sn = std::sin(angle); return { cs, sn, -sn, cs, 0, 0 }; }
+
+		// A rotation by a whole number of quarter turns, with exact 0 and +-1 coefficients.
+		inline static constexpr Transform2D quarterTurns(int turns)
+		{
+			switch (((turns % 4) + 4) % 4)
+			{
+			case 1:  return {  0,  1, -1,  0, 0, 0 };
+			case 2:  return { -1,  0,  0, -1, 0, 0 };
+			case 3:  return {  0, -1,  1,  0, 0, 0 };
+			default: return {  1,  0,  0,  1, 0, 0 };
+			}
+		}
+
+		// Apply t around a point instead of the origin.
+		inline static constexpr Transform2D around(const FPoint& center, const Transform2D& t) { return translate(center) * t * translate(-center); }
+
+		inline constexpr FPoint apply(const FPoint& p) const { return { a * p.x + c * p.y + tx, b * p.x + d * p.y + ty }; }
+		inline constexpr FPoint applyVector(const FPoint& v) const { return { a * v.x + c * v.y, b * v.x + d * v.y }; }
+		inline constexpr FPoint operator()(const FPoint& p) const { return apply(p); }
+
+		inline constexpr float determinant() const { return a * d - b * c; }
+
+		// The transform undoing this one. A singular transform has no inverse, and gives all zeroes.
+		inline constexpr Transform2D inverse() const
+		{
+			const float det = determinant();
+			if (det == 0) return { 0, 0, 0, 0, 0, 0 };
+
+			const float inv = 1.0f / det;
+			return { d * inv, -b * inv, -c * inv, a * inv, (c * ty - d * tx) * inv, (b * tx - a * ty) * inv };
+		}
+
+		// The bounding box of a rectangle after it is transformed.
+		inline constexpr FRect bounds(const FRect& r) const
+		{
+			const FPoint p1 = apply(r.pos);
+			const FPoint p2 = apply(r.pos + FPoint(r.w, 0));
+			const FPoint p3 = apply(r.pos + FPoint(0, r.h));
+			const FPoint p4 = apply(r.pos + r.size);
+			const FPoint lo = FPoint::min(FPoint::min(p1, p2), FPoint::min(p3, p4));
+			const FPoint hi = FPoint::max(FPoint::max(p1, p2), FPoint::max(p3, p4));
+			return { lo, hi - lo };
+		}
+
+		inline operator std::string() const
+			{ return "[" + std::to_string(a) + ", " + std::to_string(c) + ", " + std::to_string(tx) + "; " + std::to_string(b) + ", " + std::to_string(d) + ", " + std::to_string(ty) + "]"; }
+
+		// Combine two transforms; (A * B).apply(p) == A.apply(B.apply(p)).
+		inline constexpr Transform2D operator*(const Transform2D& t) const
+		{
+			return {
+				a * t.a + c * t.b,
+				b * t.a + d * t.b,
+				a * t.c + c * t.d,
+				b * t.c + d * t.d,
+				a * t.tx + c * t.ty + tx,
+				b * t.tx + d * t.ty + ty
+			};
+		}
+
+		inline Transform2D& operator*=(const Transform2D& t) { return *this = *this * t; }
+
+		inline constexpr bool operator==(const Transform2D& t) const { return a == t.a && b == t.b && c == t.c && d == t.d && tx == t.tx && ty == t.ty; }
+		inline constexpr bool operator!=(const Transform2D& t) const { return !(*this == t); }
+	};
+}
+
+#endif
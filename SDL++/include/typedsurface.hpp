@@ -0,0 +1,295 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+#ifndef SDL_typedsurface_hpp_
+#define SDL_typedsurface_hpp_
+#pragma once
+
+#include "pixels.hpp"
+#include "rect.hpp"
+#include "surface.hpp"
+
+#include <algorithm>
+#include <span>
+#include <type_traits>
+
+namespace SDL
+{
+	// Where a channel sits in a packed pixel: `(value >> shift) & ((1 << bits) - 1)`. Channels a format lacks have 0 bits.
+	struct PixelChannel
+	{
+		int shift = 0;
+		int bits = 0;
+
+		inline constexpr Uint32 Mask() const { return bits == 0 ? 0 : (Uint32)(((Uint64)1 << bits) - 1) << shift; }
+	};
+
+	/**
+	 *  \brief    The layout of a pixel format, worked out at compile time from its PixelFormatEnum.
+	 *
+	 *  \details  Packed formats of 8, 16 and 32 bits are read as one integer of type Word. The 24-bit array formats
+	 *            RGB24 and BGR24 are read byte by byte, with channel shifts counting bytes in memory order, so they do
+	 *            not depend on the platform's byte order. Indexed, YUV and 10-bit array formats have no channels and
+	 *            cannot be used.
+	 */
+	template <PixelFormatEnum F>
+	struct PixelFormatTraits
+	{
+		static constexpr Uint32 format = (Uint32)F;
+		static constexpr int bytes = SDL_BYTESPERPIXEL(format);
+
+		static constexpr bool packed =
+			!SDL_ISPIXELFORMAT_FOURCC(format) &&
+			(SDL_PIXELTYPE(format) == SDL_PIXELTYPE_PACKED8 ||
+			 SDL_PIXELTYPE(format) == SDL_PIXELTYPE_PACKED16 ||
+			 SDL_PIXELTYPE(format) == SDL_PIXELTYPE_PACKED32);
+
+		static constexpr bool array =
+			!SDL_ISPIXELFORMAT_FOURCC(format) &&
+			SDL_PIXELTYPE(format) == SDL_PIXELTYPE_ARRAYU8 && bytes == 3;
+
+		static_assert(packed || array, "Only packed RGB formats and RGB24 or BGR24 can be accessed as typed pixels");
+
+		typedef std::conditional_t<bytes == 1, Uint8, std::conditional_t<bytes == 2, Uint16, Uint32>> Word;
+
+		// Find a channel ('R', 'G', 'B' or 'A') in the format
+		static constexpr PixelChannel Find(char channel)
+		{
+			if constexpr (array)
+			{
+				// The bytes in memory order
+				const char* order = SDL_PIXELORDER(format) == SDL_ARRAYORDER_RGB ? "RGB" : "BGR";
+				for (int i = 0; i < 3; i++)
+					if (order[i] == channel) return { i * 8, 8 };
+				return { 0, 0 };
+			}
+			else
+			{
+				// The channels from most to least significant, and their sizes for each layout
+				const char* orders[] = { "XRGB", "XRGB", "RGBX", "ARGB", "RGBA", "XBGR", "BGRX", "ABGR", "BGRA" };
+				const int layouts[][4] = {
+					{ 0, 0, 0, 0 },
+					{ 0, 3, 3, 2 },     // 332
+					{ 4, 4, 4, 4 },     // 4444
+					{ 1, 5, 5, 5 },     // 1555
+					{ 5, 5, 5, 1 },     // 5551
+					{ 0, 5, 6, 5 },     // 565
+					{ 8, 8, 8, 8 },     // 8888
+					{ 2, 10, 10, 10 },  // 2101010
+					{ 10, 10, 10, 2 }   // 1010102
+				};
+
+				const char* order = orders[SDL_PIXELORDER(format)];
+				const int* bits = layouts[SDL_PIXELLAYOUT(format)];
+
+				int shift = 0;
+				for (int i = 3; i >= 0; i--)
+				{
+					if (order[i] == channel) return { bits[i] == 0 ? 0 : shift, bits[i] };
+					shift += bits[i];
+				}
+				return { 0, 0 };
+			}
+		}
+
+		static constexpr PixelChannel R = Find('R');
+		static constexpr PixelChannel G = Find('G');
+		static constexpr PixelChannel B = Find('B');
+		static constexpr PixelChannel A = Find('A');
+
+		static constexpr bool hasAlpha = A.bits > 0;
+
+		// Widen a channel value to 8 bits, scaling and rounding down as SDL_GetRGBA() does
+		static constexpr Uint8 Expand(Uint32 v, int bits)
+		{
+			if (bits == 0) return 0;
+			if (bits >= 8) return (Uint8)(v >> (bits - 8));
+			return (Uint8)(v * 255 / ((1u << bits) - 1));
+		}
+
+		// Narrow an 8-bit value to a channel, truncating as SDL_MapRGBA() does
+		static constexpr Uint32 Narrow(Uint8 v, int bits)
+		{
+			if (bits >= 8) return ((Uint32)v << (bits - 8)) | ((Uint32)v >> (16 - bits));
+			return (Uint32)v >> (8 - bits);
+		}
+	};
+
+	/**
+	 *  \brief    A pixel of a known format, with its channels packed and unpacked by shifts fixed at compile time.
+	 *
+	 *  \details  A Pixel is exactly as large as a pixel of its format, so a row of a TypedSurface is a row of Pixels.
+	 *            Loops written against them compile to plain shifts and masks, with no lookup of the surface's
+	 *            SDL_PixelFormat per pixel. Packing and unpacking give the same results as SDL_MapRGBA() and
+	 *            SDL_GetRGBA() for channels of up to 8 bits; 10-bit channels unpack to their top 8 bits. Formats
+	 *            without alpha unpack as opaque.
+	 */
+	template <PixelFormatEnum F>
+	struct Pixel
+	{
+		typedef PixelFormatTraits<F> Traits;
+		typedef std::conditional_t<Traits::array, Uint8[3], typename Traits::Word> Storage;
+
+		Storage raw{};
+
+		inline constexpr Pixel() = default;
+
+		// Create a pixel from its packed value, or for 24-bit formats the bytes read as a little endian number.
+		inline constexpr explicit Pixel(Uint32 value) { SetValue(value); }
+
+		inline constexpr Pixel(Uint8 r, Uint8 g, Uint8 b, Uint8 a = 255) { Pack(r, g, b, a); }
+		inline constexpr Pixel(const Colour& colour) { Pack(colour.r, colour.g, colour.b, colour.a); }
+
+		// The packed value of the pixel, or for 24-bit formats its bytes read as a little endian number.
+		inline constexpr Uint32 Value() const
+		{
+			if constexpr (Traits::array) return (Uint32)raw[0] | ((Uint32)raw[1] << 8) | ((Uint32)raw[2] << 16);
+			else return raw;
+		}
+
+		inline constexpr void SetValue(Uint32 value)
+		{
+			if constexpr (Traits::array)
+			{
+				raw[0] = (Uint8)value;
+				raw[1] = (Uint8)(value >> 8);
+				raw[2] = (Uint8)(value >> 16);
+			}
+			else raw = (typename Traits::Word)value;
+		}
+
+		// Set every channel at once. Alpha is ignored if the format has none.
+		inline constexpr void Pack(Uint8 r, Uint8 g, Uint8 b, Uint8 a = 255)
+		{
+			SetValue(
+				(Traits::Narrow(r, Traits::R.bits) << Traits::R.shift) |
+				(Traits::Narrow(g, Traits::G.bits) << Traits::G.shift) |
+				(Traits::Narrow(b, Traits::B.bits) << Traits::B.shift) |
+				(Traits::hasAlpha ? Traits::Narrow(a, Traits::A.bits) << Traits::A.shift : 0));
+		}
+
+		inline constexpr Colour Unpack() const { return { GetR(), GetG(), GetB(), GetA() }; }
+		inline constexpr operator Colour() const { return Unpack(); }
+
+		inline constexpr Uint8 GetR() const { return GetChannel(Traits::R); }
+		inline constexpr Uint8 GetG() const { return GetChannel(Traits::G); }
+		inline constexpr Uint8 GetB() const { return GetChannel(Traits::B); }
+		inline constexpr Uint8 GetA() const { return Traits::hasAlpha ? GetChannel(Traits::A) : 255; }
+
+		inline constexpr void SetR(Uint8 v) { SetChannel(Traits::R, v); }
+		inline constexpr void SetG(Uint8 v) { SetChannel(Traits::G, v); }
+		inline constexpr void SetB(Uint8 v) { SetChannel(Traits::B, v); }
+		inline constexpr void SetA(Uint8 v) { if constexpr (Traits::hasAlpha) SetChannel(Traits::A, v); }
+
+		inline constexpr bool operator==(const Pixel& that) const { return Value() == that.Value(); }
+		inline constexpr bool operator!=(const Pixel& that) const { return Value() != that.Value(); }
+
+		// Get or set one channel, such as Traits::R, as an 8-bit value.
+		inline constexpr Uint8 GetChannel(const PixelChannel& c) const
+			{ return Traits::Expand((Value() & c.Mask()) >> c.shift, c.bits); }
+
+		inline constexpr void SetChannel(const PixelChannel& c, Uint8 v)
+			{ SetValue((Value() & ~c.Mask()) | (Traits::Narrow(v, c.bits) << c.shift)); }
+	};
+
+	/**
+	 *  \brief    A surface whose pixel format is part of its type, giving access to its pixels as Pixel<F>.
+	 *
+	 *  \details  A TypedSurface shares its SDL_Surface with a Surface, so the two can be used side by side: the
+	 *            surface member is an ordinary Surface for blitting and the rest of the API, and a Surface in the
+	 *            right format can be viewed as a TypedSurface after its format is checked.
+	 *
+	 *  \note     Lock the surface while accessing its pixels if MustLock() is true.
+	 */
+	template <PixelFormatEnum F>
+	struct TypedSurface
+	{
+		typedef SDL::Pixel<F> Pixel;
+
+		static constexpr Uint32 format = (Uint32)F;
+
+		Surface surface = Surface::FromPtr(NULL);
+
+		/**
+		 *  \brief    Allocate a surface in format F.
+		 *
+		 *  \param    width:  The width in pixels of the surface to create.
+		 *  \param    height: The height in pixels of the surface to create.
+		 *
+		 *  \return   If the function runs out of memory, surface will be invalid.
+		 */
+		inline TypedSurface(int width, int height) : surface(width, height, format) {}
+		inline TypedSurface(const Point& size) : surface(size.x, size.y, format) {}
+
+		/**
+		 *  \brief    View a surface as a TypedSurface, sharing its pixels.
+		 *
+		 *  \details  The surface must already be in format F. If it is not, or is invalid, the result is invalid
+		 *            and SDL::GetError() says why; use Convert() to copy a surface into format F instead.
+		 */
+		inline explicit TypedSurface(const Surface& s)
+		{
+			if (!s.surface) SDL_SetError("Parameter 's' is invalid");
+			else if (s.surface->format->format != format)
+				SDL_SetError("Surface is %s, not %s", SDL_GetPixelFormatName(s.surface->format->format), SDL_GetPixelFormatName(format));
+			else surface = s;
+		}
+
+		// Evaluates to true if a surface is in format F and can be viewed as a TypedSurface.
+		inline static bool Matches(const Surface& s) { return s.surface && s.surface->format->format == format; }
+
+		/**
+		 * Get a surface in format F with the contents of another surface.
+		 *
+		 * A surface already in format F is shared rather than copied.
+		 *
+		 * \returns the surface, or an invalid surface on failure; call
+		 *          SDL::GetError() for more information.
+		 */
+		inline static TypedSurface Convert(const Surface& s)
+		{
+			if (Matches(s) || !s.surface) return TypedSurface(s);
+			Surface converted = Surface::FromPtr(SDL_ConvertSurfaceFormat(s.surface.get(), format, 0));
+			converted.SetPremultiplied(s.IsPremultiplied());
+			return TypedSurface(converted);
+		}
+
+		inline bool IsValid() const { return (bool)surface.surface; }
+
+		inline operator Surface&() { return surface; }
+		inline operator const Surface&() const { return surface; }
+
+		inline int Width() const { return surface.surface ? surface.surface->w : 0; }
+		inline int Height() const { return surface.surface ? surface.surface->h : 0; }
+		inline Point Size() const { return { Width(), Height() }; }
+
+		inline bool MustLock() const { return surface.MustLock(); }
+		inline bool Lock() { return surface.Lock(); }
+		inline void Unlock() { surface.Unlock(); }
+
+		// Get a view of every row of pixels.
+		inline PixelSpan<Pixel> Rows() const { return surface.Rows<Pixel>(); }
+
+		// Get row y.
+		inline std::span<Pixel> operator[](int y) const
+			{ return std::span<Pixel>((Pixel*)((Uint8*)surface.surface->pixels + (ptrdiff_t)y * surface.surface->pitch), (size_t)surface.surface->w); }
+
+		// Get the pixel at (x, y).
+		inline Pixel& At(int x, int y) const { return (*this)[y][x]; }
+		inline Pixel& At(const Point& p) const { return At(p.x, p.y); }
+
+		// Set every pixel inside the clip rectangle to one value.
+		inline void Fill(const Pixel& pixel)
+		{
+			const Rect clip = surface.GetClipRect();
+			for (auto row : Rows().sub(clip)) std::fill(row.begin(), row.end(), pixel);
+		}
+	};
+
+	typedef TypedSurface<PixelFormatEnum::RGBA32> SurfaceRGBA32;
+	typedef TypedSurface<PixelFormatEnum::ARGB8888> SurfaceARGB8888;
+	typedef TypedSurface<PixelFormatEnum::RGB565> SurfaceRGB565;
+	typedef TypedSurface<PixelFormatEnum::RGB24> SurfaceRGB24;
+}
+
+#endif
+#endif
@@ -0,0 +1,132 @@
+#include <SDL_version.h>
+#if SDL_VERSION_ATLEAST(2, 0, 5)
+#ifndef SDL_yuv_hpp_
+#define SDL_yuv_hpp_
+#pragma once
+
+#include "render.hpp"
+#include "surface.hpp"
+
+namespace SDL
+{
+	// The colour matrix a YUV frame was encoded with.
+	enum class YUVMatrix
+	{
+		BT601, // Standard definition video and JPEG
+		BT709  // High definition video
+	};
+
+	// The range of values a YUV frame uses.
+	enum class YUVRange
+	{
+		LIMITED, // Y from 16 to 235 and chroma from 16 to 240, as in most video
+		FULL     // All of 0 to 255, as in JPEG
+	};
+
+	// Conversion of YUV video frames to 32-bit RGB on the CPU.
+	//
+	// These kernels read IYUV, YV12, NV12, NV21, YUY2, UYVY and YVYU frames, and write
+	// any 32-bit format with 8-bit channels (ARGB8888, ABGR8888, RGBA8888, BGRA8888 and
+	// their X variants), setting alpha to opaque. Subsampled chroma is replicated rather
+	// than interpolated, as SDL does. Rows are converted with SSE2 or NEON where
+	// available, and passing parallel = true splits the rows across all CPU cores.
+
+	/**
+	 * Convert a YUV frame stored in one buffer to RGB pixels.
+	 *
+	 * The planes are laid out as SDL::ConvertPixels() expects: the Y plane of
+	 * `height` rows of `yuv_pitch` bytes, followed for planar formats by the
+	 * chroma planes, whose rows are (yuv_pitch + 1) / 2 bytes for IYUV and YV12
+	 * and twice that for NV12 and NV21.
+	 *
+	 * \param width the width of the frame, in pixels
+	 * \param height the height of the frame, in pixels
+	 * \param yuv_format the FOURCC format of the frame
+	 * \param yuv the frame data
+	 * \param yuv_pitch the length of a row of the Y plane (or of the frame, for packed formats), in bytes
+	 * \param dst_format a 32-bit pixel format with 8-bit channels
+	 * \param dst the pixels to write
+	 * \param dst_pitch the length of a row of dst, in bytes
+	 * \param matrix the colour matrix the frame was encoded with
+	 * \param range the range of values the frame uses
+	 * \param parallel whether to split the rows across CPU cores
+	 * \returns true on success or false on failure; call SDL::GetError() for
+	 *          more information.
+	 */
+	bool ConvertYUV(int width, int height, Uint32 yuv_format, const void* yuv, int yuv_pitch, Uint32 dst_format, void* dst, int dst_pitch,
+		YUVMatrix matrix = YUVMatrix::BT601, YUVRange range = YUVRange::LIMITED, bool parallel = true);
+
+	/**
+	 * Convert a frame with separate Y, U and V planes to RGB pixels.
+	 *
+	 * The chroma planes have half the width and height of the Y plane, as in
+	 * IYUV and YV12. The planes are given as for Texture::UpdateYUV().
+	 *
+	 * \returns true on success or false on failure; call SDL::GetError() for
+	 *          more information.
+	 */
+	bool ConvertYUVPlanes(int width, int height, const Uint8* Yplane, int Ypitch, const Uint8* Uplane, int Upitch, const Uint8* Vplane, int Vpitch,
+		Uint32 dst_format, void* dst, int dst_pitch, YUVMatrix matrix = YUVMatrix::BT601, YUVRange range = YUVRange::LIMITED, bool parallel = true);
+
+	/**
+	 * Convert a frame with a Y plane and an interleaved chroma plane to RGB pixels.
+	 *
+	 * The planes are given as for Texture::UpdateNV().
+	 *
+	 * \param nv_format SDL_PIXELFORMAT_NV12 if chroma is stored U first, or
+	 *                  SDL_PIXELFORMAT_NV21 if it is stored V first
+	 * \returns true on success or false on failure; call SDL::GetError() for
+	 *          more information.
+	 */
+	bool ConvertNVPlanes(int width, int height, const Uint8* Yplane, int Ypitch, const Uint8* UVplane, int UVpitch, Uint32 nv_format,
+		Uint32 dst_format, void* dst, int dst_pitch, YUVMatrix matrix = YUVMatrix::BT601, YUVRange range = YUVRange::LIMITED, bool parallel = true);
+
+	/**
+	 * Convert a YUV frame stored in one buffer to a new surface.
+	 *
+	 * \param format the format of the surface to create; a 32-bit format with
+	 *               8-bit channels
+	 * \returns the new surface, or an invalid surface on failure; call
+	 *          SDL::GetError() for more information.
+	 */
+	inline Surface ConvertYUVToSurface(int width, int height, Uint32 yuv_format, const void* yuv, int yuv_pitch, Uint32 format = SDL_PIXELFORMAT_ARGB8888,
+		YUVMatrix matrix = YUVMatrix::BT601, YUVRange range = YUVRange::LIMITED, bool parallel = true)
+	{
+		Surface surface(width, height, format);
+		if (!surface.surface) return surface;
+		if (SDL_LockSurface(surface.surface.get()) != 0) return Surface::FromPtr(NULL);
+
+		const bool success = ConvertYUV(width, height, yuv_format, yuv, yuv_pitch, format, surface.surface->pixels, surface.surface->pitch, matrix, range, parallel);
+		SDL_UnlockSurface(surface.surface.get());
+		return success ? surface : Surface::FromPtr(NULL);
+	}
+
+	/**
+	 * Convert a YUV frame stored in one buffer straight into a streaming texture.
+	 *
+	 * The texture is locked for the conversion, so no intermediate surface is
+	 * needed. It must have Texture::Access::STREAMING, the size of the frame and
+	 * a 32-bit format with 8-bit channels.
+	 *
+	 * \returns true on success or false on failure; call SDL::GetError() for
+	 *          more information.
+	 */
+	inline bool ConvertYUVToTexture(Texture& texture, Uint32 yuv_format, const void* yuv, int yuv_pitch,
+		YUVMatrix matrix = YUVMatrix::BT601, YUVRange range = YUVRange::LIMITED, bool parallel = true)
+	{
+		Uint32 format;
+		Point size;
+		if (!texture.QueryFormat(format) || !texture.QuerySize(size)) return false;
+
+		void* pixels;
+		int pitch;
+		if (!texture.Lock(pixels, pitch)) return false;
+
+		const bool success = ConvertYUV(size.w, size.h, yuv_format, yuv, yuv_pitch, format, pixels, pitch, matrix, range, parallel);
+		texture.Unlock();
+		return success;
+	}
+}
+
+#endif
+#endif
@@ -0,0 +1,484 @@
+#include "aabbtree.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace SDL
+{
+#pragma region Helpers
+
+	typedef AABBTree::Node Node;
+	static constexpr int NONE = AABBTree::NONE;
+
+	static inline float Perimeter(const FPoint& min, const FPoint& max) { return 2 * (max.x - min.x + max.y - min.y); }
+	static inline float Perimeter(const Node& n) { return Perimeter(n.min, n.max); }
+	static inline float UnionPerimeter(const Node& a, const Node& b) { return Perimeter(FPoint::min(a.min, b.min), FPoint::max(a.max, b.max)); }
+
+	static inline bool Contains(const FPoint& outerMin, const FPoint& outerMax, const FPoint& min, const FPoint& max)
+		{ return outerMin.x <= min.x && outerMin.y <= min.y && max.x <= outerMax.x && max.y <= outerMax.y; }
+
+	// Set a branch's bounds and height from its children
+	static inline void Refit(AABBTree& tree, int i)
+	{
+		Node& n = tree.nodes[i];
+		const Node& a = tree.nodes[n.child1];
+		const Node& b = tree.nodes[n.child2];
+		n.min = FPoint::min(a.min, b.min);
+		n.max = FPoint::max(a.max, b.max);
+		n.height = 1 + std::max(a.height, b.height);
+	}
+
+	// Point whichever child of parent (or the root, if there is no parent) referred to from at to instead
+	static inline void Replace(AABBTree& tree, int parent, int from, int to)
+	{
+		if (parent == NONE) tree.root = to;
+		else if (tree.nodes[parent].child1 == from) tree.nodes[parent].child1 = to;
+		else tree.nodes[parent].child2 = to;
+	}
+
+	static int AllocateNode(AABBTree& tree)
+	{
+		if (tree.freeList == NONE)
+		{
+			tree.nodes.emplace_back();
+			return (int)tree.nodes.size() - 1;
+		}
+
+		const int i = tree.freeList;
+		tree.freeList = tree.nodes[i].parent;
+		tree.nodes[i] = Node();
+		return i;
+	}
+
+	static void FreeNode(AABBTree& tree, int i)
+	{
+		tree.nodes[i] = Node();
+		tree.nodes[i].parent = tree.freeList;
+		tree.freeList = i;
+	}
+
+	// If one child of a branch is more than one level taller than the other, rotate it up to take the branch's place.
+	// Returns the node now in the branch's place
+	static int Balance(AABBTree& tree, int iA)
+	{
+		Node& A = tree.nodes[iA];
+		if (A.IsLeaf() || A.height < 2) return iA;
+
+		const int iB = A.child1, iC = A.child2;
+		Node& B = tree.nodes[iB];
+		Node& C = tree.nodes[iC];
+		const int balance = C.height - B.height;
+
+		if (balance > 1)
+		{
+			// C takes A's place, keeping its taller child and giving A the other
+			const int iF = C.child1, iG = C.child2;
+			const bool keepF = tree.nodes[iF].height > tree.nodes[iG].height;
+			const int kept = keepF ? iF : iG, given = keepF ? iG : iF;
+
+			C.child1 = iA;
+			C.parent = A.parent;
+			A.parent = iC;
+			Replace(tree, C.parent, iA, iC);
+
+			C.child2 = kept;
+			A.child2 = given;
+			tree.nodes[given].parent = iA;
+
+			Refit(tree, iA);
+			Refit(tree, iC);
+			return iC;
+		}
+
+		if (balance < -1)
+		{
+			// B takes A's place, keeping its taller child and giving A the other
+			const int iD = B.child1, iE = B.child2;
+			const bool keepD = tree.nodes[iD].height > tree.nodes[iE].height;
+			const int kept = keepD ? iD : iE, given = keepD ? iE : iD;
+
+			B.child1 = iA;
+			B.parent = A.parent;
+			A.parent = iB;
+			Replace(tree, B.parent, iA, iB);
+
+			B.child2 = kept;
+			A.child1 = given;
+			tree.nodes[given].parent = iA;
+
+			Refit(tree, iA);
+			Refit(tree, iB);
+			return iB;
+		}
+
+		return iA;
+	}
+
+	// Refit and rebalance every branch from i up to the root
+	static void FixUpwards(AABBTree& tree, int i)
+	{
+		while (i != NONE)
+		{
+			i = Balance(tree, i);
+			Refit(tree, i);
+			i = tree.nodes[i].parent;
+		}
+	}
+
+	static void InsertLeaf(AABBTree& tree, int leaf)
+	{
+		if (tree.root == NONE)
+		{
+			tree.root = leaf;
+			tree.nodes[leaf].parent = NONE;
+			return;
+		}
+
+		// Walk down to the sibling where the leaf adds the least perimeter, counting what it adds to every branch above
+		int index = tree.root;
+		while (!tree.nodes[index].IsLeaf())
+		{
+			const Node& n = tree.nodes[index];
+			const Node& l = tree.nodes[leaf];
+			const Node& c1 = tree.nodes[n.child1];
+			const Node& c2 = tree.nodes[n.child2];
+
+			const float combined = UnionPerimeter(n, l);
+			const float cost = 2 * combined;                             // Making a new parent for this node and the leaf
+			const float inheritance = 2 * (combined - Perimeter(n));     // Growing this node to fit the leaf
+
+			const float cost1 = UnionPerimeter(l, c1) - (c1.IsLeaf() ? 0 : Perimeter(c1)) + inheritance;
+			const float cost2 = UnionPerimeter(l, c2) - (c2.IsLeaf() ? 0 : Perimeter(c2)) + inheritance;
+
+			if (cost < cost1 && cost < cost2) break;
+			index = cost1 < cost2 ? n.child1 : n.child2;
+		}
+
+		const int sibling = index;
+		const int oldParent = tree.nodes[sibling].parent;
+		const int newParent = AllocateNode(tree);
+
+		Node& p = tree.nodes[newParent];
+		p.parent = oldParent;
+		p.child1 = sibling;
+		p.child2 = leaf;
+		tree.nodes[sibling].parent = newParent;
+		tree.nodes[leaf].parent = newParent;
+		Replace(tree, oldParent, sibling, newParent);
+
+		FixUpwards(tree, newParent);
+	}
+
+	static void RemoveLeaf(AABBTree& tree, int leaf)
+	{
+		if (leaf == tree.root)
+		{
+			tree.root = NONE;
+			return;
+		}
+
+		const int parent = tree.nodes[leaf].parent;
+		const int grandParent = tree.nodes[parent].parent;
+		const int sibling = tree.nodes[parent].child1 == leaf ? tree.nodes[parent].child2 : tree.nodes[parent].child1;
+
+		Replace(tree, grandParent, parent, sibling);
+		tree.nodes[sibling].parent = grandParent;
+		FreeNode(tree, parent);
+
+		FixUpwards(tree, grandParent);
+	}
+
+	// Build a subtree over some leaves, splitting them along the longer axis of their centres where the sum of each
+	// side's perimeter times its number of leaves is smallest. Returns the subtree's root
+	static int Build(AABBTree& tree, int* leaves, int count)
+	{
+		if (count == 1) return leaves[0];
+
+		auto centre = [&](int i) { return (tree.nodes[i].min + tree.nodes[i].max) / 2.f; };
+
+		FPoint cmin = centre(leaves[0]), cmax = cmin;
+		for (int i = 1; i < count; i++)
+		{
+			cmin = FPoint::min(cmin, centre(leaves[i]));
+			cmax = FPoint::max(cmax, centre(leaves[i]));
+		}
+
+		const int axis = cmax.x - cmin.x >= cmax.y - cmin.y ? 0 : 1;
+		const float lo = axis == 0 ? cmin.x : cmin.y;
+		const float extent = axis == 0 ? cmax.x - cmin.x : cmax.y - cmin.y;
+		int mid = count / 2;
+
+		if (extent > 0)
+		{
+			constexpr int BINS = 16;
+			struct Bin { FPoint min, max; int count = 0; } bins[BINS];
+
+			auto binOf = [&](int i)
+			{
+				const FPoint c = centre(i);
+				return std::min(BINS - 1, (int)(((axis == 0 ? c.x : c.y) - lo) / extent * BINS));
+			};
+
+			for (int i = 0; i < count; i++)
+			{
+				Bin& b = bins[binOf(leaves[i])];
+				const Node& n = tree.nodes[leaves[i]];
+				b.min = b.count ? FPoint::min(b.min, n.min) : n.min;
+				b.max = b.count ? FPoint::max(b.max, n.max) : n.max;
+				b.count++;
+			}
+
+			// The cost of everything right of each split, then sweep from the left to find the cheapest split
+			float rightCost[BINS];
+			FPoint rmin, rmax;
+			int rcount = 0;
+			for (int i = BINS - 1; i > 0; i--)
+			{
+				if (bins[i].count)
+				{
+					rmin = rcount ? FPoint::min(rmin, bins[i].min) : bins[i].min;
+					rmax = rcount ? FPoint::max(rmax, bins[i].max) : bins[i].max;
+					rcount += bins[i].count;
+				}
+				rightCost[i] = rcount ? rcount * Perimeter(rmin, rmax) : 0;
+			}
+
+			FPoint lmin, lmax;
+			int lcount = 0, best = -1;
+			float bestCost = 0;
+			for (int i = 0; i < BINS - 1; i++)
+			{
+				if (bins[i].count)
+				{
+					lmin = lcount ? FPoint::min(lmin, bins[i].min) : bins[i].min;
+					lmax = lcount ? FPoint::max(lmax, bins[i].max) : bins[i].max;
+					lcount += bins[i].count;
+				}
+				if (lcount == 0 || lcount == count) continue;
+
+				const float cost = lcount * Perimeter(lmin, lmax) + rightCost[i + 1];
+				if (best < 0 || cost < bestCost)
+				{
+					best = i;
+					bestCost = cost;
+				}
+			}
+
+			if (best >= 0) mid = (int)(std::partition(leaves, leaves + count, [&](int i) { return binOf(i) <= best; }) - leaves);
+		}
+
+		const int child1 = Build(tree, leaves, mid);
+		const int child2 = Build(tree, leaves + mid, count - mid);
+		const int node = AllocateNode(tree);
+
+		tree.nodes[node].child1 = child1;
+		tree.nodes[node].child2 = child2;
+		tree.nodes[child1].parent = node;
+		tree.nodes[child2].parent = node;
+		Refit(tree, node);
+
+		return node;
+	}
+
+	// Check a subtree, returning the number of leaves in it, or -1 if it is inconsistent
+	static int ValidateNode(const AABBTree& tree, int i, int parent)
+	{
+		const Node& n = tree.nodes[i];
+		if (n.parent != parent || n.height < 0) return -1;
+
+		if (n.IsLeaf())
+		{
+			const bool fits = n.height == 0 && n.child2 == NONE && Contains(n.min, n.max, n.rect.pos, n.rect.pos + n.rect.size);
+			return fits ? 1 : -1;
+		}
+
+		const Node& a = tree.nodes[n.child1];
+		const Node& b = tree.nodes[n.child2];
+		if (n.height != 1 + std::max(a.height, b.height)) return -1;
+		if (!Contains(n.min, n.max, a.min, a.max) || !Contains(n.min, n.max, b.min, b.max)) return -1;
+
+		const int left = ValidateNode(tree, n.child1, i);
+		const int right = ValidateNode(tree, n.child2, i);
+		return left < 0 || right < 0 ? -1 : left + right;
+	}
+
+#pragma endregion
+
+#pragma region Proxies
+
+	int AABBTree::Insert(const FRect& rect, void* data)
+	{
+		const int i = AllocateNode(*this);
+		Node& n = nodes[i];
+		n.rect = rect;
+		n.data = data;
+		n.min = rect.pos - FPoint(margin, margin);
+		n.max = rect.pos + rect.size + FPoint(margin, margin);
+		n.height = 0;
+
+		InsertLeaf(*this, i);
+		proxyCount++;
+		return i;
+	}
+
+	void AABBTree::Remove(int proxy)
+	{
+		RemoveLeaf(*this, proxy);
+		FreeNode(*this, proxy);
+		proxyCount--;
+	}
+
+	bool AABBTree::Move(int proxy, const FRect& rect, const FPoint& displacement)
+	{
+		Node& n = nodes[proxy];
+		const FPoint min = rect.pos, max = rect.pos + rect.size;
+
+		FPoint fatMin = min - FPoint(margin, margin);
+		FPoint fatMax = max + FPoint(margin, margin);
+		const FPoint d = displacement * prediction;
+		(d.x < 0 ? fatMin.x : fatMax.x) += d.x;
+		(d.y < 0 ? fatMin.y : fatMax.y) += d.y;
+
+		// Keep the bounds if the rectangle still fits, unless they have grown far larger than needed, as they do when
+		// a proxy that was moving fast slows down
+		if (Contains(n.min, n.max, min, max))
+		{
+			const FPoint slack(4 * margin, 4 * margin);
+			if (Contains(fatMin - slack, fatMax + slack, n.min, n.max))
+			{
+				n.rect = rect;
+				return false;
+			}
+		}
+
+		RemoveLeaf(*this, proxy);
+		n.rect = rect;
+		n.min = fatMin;
+		n.max = fatMax;
+		InsertLeaf(*this, proxy);
+		return true;
+	}
+
+	void AABBTree::Clear()
+	{
+		nodes.clear();
+		root = NONE;
+		freeList = NONE;
+		proxyCount = 0;
+	}
+
+#pragma endregion
+
+#pragma region Structure
+
+	float AABBTree::Cost() const
+	{
+		if (root == NONE) return 0;
+
+		const float rootPerimeter = Perimeter(nodes[root]);
+		if (rootPerimeter <= 0) return 0;
+
+		float total = 0;
+		for (const Node& n : nodes)
+			if (n.height >= 0) total += Perimeter(n);
+
+		return total / rootPerimeter;
+	}
+
+	void AABBTree::Rebuild()
+	{
+		if (proxyCount < 2) return;
+
+		std::vector<int> leaves;
+		leaves.reserve(proxyCount);
+
+		for (int i = 0; i < (int)nodes.size(); i++)
+		{
+			if (nodes[i].height == 0) leaves.push_back(i);
+			else if (nodes[i].height > 0) FreeNode(*this, i);
+		}
+
+		root = Build(*this, leaves.data(), (int)leaves.size());
+		nodes[root].parent = NONE;
+	}
+
+	bool AABBTree::Validate() const
+	{
+		if (root == NONE) return proxyCount == 0;
+		if (ValidateNode(*this, root, NONE) != proxyCount) return false;
+
+		int used = 0;
+		for (const Node& n : nodes) used += n.height >= 0;
+
+		int free = 0;
+		for (int i = freeList; i != NONE; i = nodes[i].parent) free++;
+
+		return used + free == (int)nodes.size();
+	}
+
+#pragma endregion
+
+#pragma region Queries
+
+	int AABBTree::FirstHit(const Ray& ray, Ray::Contact& contact) const
+	{
+		contact = { false };
+		if (root == NONE || (ray.dir.x == 0 && ray.dir.y == 0)) return NONE;
+
+		const FPoint inv = InverseDir(ray);
+		float limit = 1.f, entry;
+		int hit = NONE;
+
+		Stack stack;
+		if (SlabTest(ray.origin, inv, nodes[root].min, nodes[root].max, limit, entry)) stack.Push(root);
+
+		while (stack.count > 0)
+		{
+			const int i = stack.Pop();
+			const Node& n = nodes[i];
+
+			// Branches entered after the best hit so far cannot hold a better one
+			if (!SlabTest(ray.origin, inv, n.min, n.max, limit, entry)) continue;
+
+			if (n.IsLeaf())
+			{
+				if (SlabTest(ray.origin, inv, n.rect, limit, entry) && (hit == NONE || entry < limit || i < hit))
+				{
+					hit = i;
+					limit = entry;
+				}
+				continue;
+			}
+
+			// Visit the child the ray enters first next, so a near hit can cut off the other
+			float e1, e2;
+			const bool h1 = SlabTest(ray.origin, inv, nodes[n.child1].min, nodes[n.child1].max, limit, e1);
+			const bool h2 = SlabTest(ray.origin, inv, nodes[n.child2].min, nodes[n.child2].max, limit, e2);
+
+			if (h1 && h2)
+			{
+				stack.Push(e1 <= e2 ? n.child2 : n.child1);
+				stack.Push(e1 <= e2 ? n.child1 : n.child2);
+			}
+			else if (h1) stack.Push(n.child1);
+			else if (h2) stack.Push(n.child2);
+		}
+
+		if (hit == NONE) return NONE;
+
+		// Work out the normal of the side entered, as Ray::IntersectRect() does
+		const FRect& r = nodes[hit].rect;
+		const float nearX = std::min((r.x - ray.origin.x) * inv.x, (r.x + r.w - ray.origin.x) * inv.x);
+		const float nearY = std::min((r.y - ray.origin.y) * inv.y, (r.y + r.h - ray.origin.y) * inv.y);
+
+		contact.contact = true;
+		contact.time = limit;
+		contact.point = ray.origin + limit * ray.dir;
+		if (nearX >= nearY) contact.normal.x = ray.dir.x < 0 ? 1.f : -1.f;
+		if (nearX <= nearY) contact.normal.y = ray.dir.y < 0 ? 1.f : -1.f;
+
+		return hit;
+	}
+
+#pragma endregion
+}
@@ -0,0 +1,511 @@
+#include "filter.hpp"
+#include "parallel.hpp"
+#include "pixelops.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace SDL
+{
+namespace SurfaceFilter
+{
+#pragma region Vector Helpers
+
+	// The four channels of one pixel as floats, in memory order
+#if defined(SDLPP_SSE2)
+	typedef __m128 Vec4;
+
+	static inline Vec4 Splat(float v) { return _mm_set1_ps(v); }
+	static inline Vec4 Load(const float* p) { return _mm_loadu_ps(p); }
+	static inline void Store(float* p, Vec4 v) { _mm_storeu_ps(p, v); }
+	static inline Vec4 Add(Vec4 a, Vec4 b) { return _mm_add_ps(a, b); }
+	static inline Vec4 Sub(Vec4 a, Vec4 b) { return _mm_sub_ps(a, b); }
+	static inline Vec4 Mul(Vec4 a, Vec4 b) { return _mm_mul_ps(a, b); }
+
+	static inline Vec4 Unpack(Uint32 p)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)p), zero), zero));
+	}
+
+	static inline Uint32 Pack(Vec4 v)
+	{
+		const __m128i i = _mm_cvtps_epi32(v);
+		const __m128i s = _mm_packs_epi32(i, i);
+		return (Uint32)_mm_cvtsi128_si32(_mm_packus_epi16(s, s));
+	}
+#elif defined(SDLPP_NEON)
+	typedef float32x4_t Vec4;
+
+	static inline Vec4 Splat(float v) { return vdupq_n_f32(v); }
+	static inline Vec4 Load(const float* p) { return vld1q_f32(p); }
+	static inline void Store(float* p, Vec4 v) { vst1q_f32(p, v); }
+	static inline Vec4 Add(Vec4 a, Vec4 b) { return vaddq_f32(a, b); }
+	static inline Vec4 Sub(Vec4 a, Vec4 b) { return vsubq_f32(a, b); }
+	static inline Vec4 Mul(Vec4 a, Vec4 b) { return vmulq_f32(a, b); }
+
+	static inline Vec4 Unpack(Uint32 p)
+		{ return vcvtq_f32_u32(vmovl_u16(vget_low_u16(vmovl_u8(vcreate_u8(p))))); }
+
+	static inline Uint32 Pack(Vec4 v)
+	{
+		const uint32x4_t i = vcvtq_u32_f32(vaddq_f32(vmaxq_f32(v, vdupq_n_f32(0.0f)), vdupq_n_f32(0.5f)));
+		const uint16x4_t s = vqmovn_u32(i);
+		return vget_lane_u32(vreinterpret_u32_u8(vqmovn_u16(vcombine_u16(s, s))), 0);
+	}
+#else
+	struct Vec4 { float v[4]; };
+
+	static inline Vec4 Splat(float v) { return { { v, v, v, v } }; }
+	static inline Vec4 Load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+	static inline void Store(float* p, Vec4 v) { for (int c = 0; c < 4; c++) p[c] = v.v[c]; }
+	static inline Vec4 Add(Vec4 a, Vec4 b) { for (int c = 0; c < 4; c++) a.v[c] += b.v[c]; return a; }
+	static inline Vec4 Sub(Vec4 a, Vec4 b) { for (int c = 0; c < 4; c++) a.v[c] -= b.v[c]; return a; }
+	static inline Vec4 Mul(Vec4 a, Vec4 b) { for (int c = 0; c < 4; c++) a.v[c] *= b.v[c]; return a; }
+
+	static inline Vec4 Unpack(Uint32 p)
+		{ return { { float(p & 0xFF), float((p >> 8) & 0xFF), float((p >> 16) & 0xFF), float(p >> 24) } }; }
+
+	static inline Uint32 Pack(Vec4 v)
+	{
+		Uint32 p = 0;
+		for (int c = 0; c < 4; c++) p |= (Uint32)std::clamp((int)std::lround(v.v[c]), 0, 255) << (c * 8);
+		return p;
+	}
+#endif
+
+	// Converts pixels to and from Vec4s in the space they are mixed in. Linear light is still scaled to 0-255, so the
+	// kernels do not change; only the colour channels go through the tables, and alpha stays as stored
+	struct Codec
+	{
+		const LinearLUT* lut = NULL; // NULL to mix channels as stored
+		int alpha = -1;
+
+		Codec(const SDL_Surface* s, ColourSpace space)
+			: lut(space == ColourSpace::LINEAR ? &GetLinearLUT() : NULL), alpha(AlphaChannel(s->format)) {}
+
+		inline Vec4 In(Uint32 p) const
+		{
+			if (lut == NULL) return Unpack(p);
+
+			float v[4];
+			for (int c = 0; c < 4; c++)
+			{
+				const Uint32 b = (p >> (c * 8)) & 0xFF;
+				v[c] = c == alpha ? (float)b : lut->toLinear16[b] * (255.0f / 65535.0f);
+			}
+			return Load(v);
+		}
+
+		inline Uint32 Out(Vec4 v) const
+		{
+			if (lut == NULL) return Pack(v);
+
+			float f[4];
+			Store(f, v);
+			Uint32 p = 0;
+			for (int c = 0; c < 4; c++)
+			{
+				const float x = std::clamp(f[c], 0.0f, 255.0f);
+				p |= (c == alpha ? (Uint32)(x + 0.5f) : FromLinear16(*lut, (Uint32)(x * 257.0f + 0.5f))) << (c * 8);
+			}
+			return p;
+		}
+	};
+
+	// Take the per-byte maximum (dilate) or minimum (erode) of two buffers into acc
+	static void CombineBytes(Uint8* acc, const Uint8* in, size_t n, bool dilate)
+	{
+		size_t i = 0;
+
+#if defined(SDLPP_SSE2)
+		for (; i + 16 <= n; i += 16)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i*)(acc + i));
+			const __m128i b = _mm_loadu_si128((const __m128i*)(in + i));
+			_mm_storeu_si128((__m128i*)(acc + i), dilate ? _mm_max_epu8(a, b) : _mm_min_epu8(a, b));
+		}
+#elif defined(SDLPP_NEON)
+		for (; i + 16 <= n; i += 16)
+		{
+			const uint8x16_t a = vld1q_u8(acc + i);
+			const uint8x16_t b = vld1q_u8(in + i);
+			vst1q_u8(acc + i, dilate ? vmaxq_u8(a, b) : vminq_u8(a, b));
+		}
+#endif
+
+		for (; i < n; i++) acc[i] = dilate ? std::max(acc[i], in[i]) : std::min(acc[i], in[i]);
+	}
+
+#pragma endregion
+
+#pragma region Helpers
+
+	// Check a surface can be filtered in place
+	static bool Check(const Surface& surface)
+	{
+		if (!surface.surface)
+		{
+			SDL_SetError("Parameter 'surface' is invalid");
+			return false;
+		}
+
+		if (!Is8888(surface.surface->format))
+		{
+			SDL_SetError("Surface filters need 32-bit surfaces with 8-bit channels");
+			return false;
+		}
+
+		return true;
+	}
+
+	// Check a surface can be filtered in place and lock it
+	static bool Begin(Surface& surface)
+		{ return Check(surface) && SDL_LockSurface(surface.surface.get()) == 0; }
+
+	// Copy the pixels of a surface into a tightly packed buffer
+	static void CopyPixels(SDL_Surface* s, std::vector<Uint32>& out)
+	{
+		out.resize((size_t)s->w * s->h);
+		for (int y = 0; y < s->h; y++) std::copy_n(Row<const Uint32>(s, y), s->w, out.data() + (size_t)y * s->w);
+	}
+
+	// Copy a row into a buffer with radius copies of the edge pixels on either side
+	static void PadRow(const Uint32* row, int w, int radius, Uint32* out)
+	{
+		std::fill_n(out, radius, row[0]);
+		std::copy_n(row, w, out + radius);
+		std::fill_n(out + radius + w, radius, row[w - 1]);
+	}
+
+	// Normalised Gaussian weights for the offsets -radius to radius
+	static std::vector<float> GaussianKernel(float sigma, int radius)
+	{
+		std::vector<float> k((size_t)radius * 2 + 1);
+		float sum = 0.0f;
+
+		for (int i = -radius; i <= radius; i++) sum += k[i + radius] = std::exp(-(float)(i * i) / (2.0f * sigma * sigma));
+		for (float& v : k) v /= sum;
+
+		return k;
+	}
+
+	// Radii of three box blurs whose combination best approximates a Gaussian of the given sigma
+	static void BoxRadii(float sigma, int radii[3])
+	{
+		const float ideal = std::sqrt(4.0f * sigma * sigma + 1.0f);
+		int wl = (int)std::floor(ideal);
+		if (wl % 2 == 0) wl--;
+		const int wu = wl + 2;
+		const int m = (int)std::lround((12.0f * sigma * sigma - 3.0f * wl * wl - 12.0f * wl - 9.0f) / (-4.0f * wl - 4.0f));
+
+		for (int i = 0; i < 3; i++) radii[i] = ((i < m ? wl : wu) - 1) / 2;
+	}
+
+#pragma endregion
+
+#pragma region Blurs
+
+	// Convolve the rows, then the columns, of a locked surface with a symmetric kernel
+	static void Convolve(SDL_Surface* s, const std::vector<float>& k, const Codec& codec, bool parallel)
+	{
+		const int w = s->w;
+		const int h = s->h;
+		const int taps = (int)k.size();
+		const int radius = taps / 2;
+		std::vector<float> rows((size_t)w * h * 4);
+
+		MaybeParallelFor(parallel, h, [&](int begin, int end)
+		{
+			std::vector<Uint32> padded((size_t)w + radius * 2);
+			std::vector<float> expanded(padded.size() * 4);
+
+			for (int y = begin; y < end; y++)
+			{
+				PadRow(Row<const Uint32>(s, y), w, radius, padded.data());
+				for (size_t x = 0; x < padded.size(); x++) Store(&expanded[x * 4], codec.In(padded[x]));
+
+				float* out = &rows[(size_t)y * w * 4];
+				for (int x = 0; x < w; x++)
+				{
+					Vec4 acc = Splat(0.0f);
+					for (int i = 0; i < taps; i++) acc = Add(acc, Mul(Splat(k[i]), Load(&expanded[((size_t)x + i) * 4])));
+					Store(out + (size_t)x * 4, acc);
+				}
+			}
+		});
+
+		MaybeParallelFor(parallel, h, [&](int begin, int end)
+		{
+			std::vector<float> acc((size_t)w * 4);
+
+			for (int y = begin; y < end; y++)
+			{
+				std::fill(acc.begin(), acc.end(), 0.0f);
+
+				for (int i = 0; i < taps; i++)
+				{
+					const float* in = &rows[(size_t)std::clamp(y + i - radius, 0, h - 1) * w * 4];
+					const Vec4 weight = Splat(k[i]);
+					for (int x = 0; x < w * 4; x += 4) Store(&acc[x], Add(Load(&acc[x]), Mul(weight, Load(in + x))));
+				}
+
+				Uint32* out = Row<Uint32>(s, y);
+				for (int x = 0; x < w; x++) out[x] = codec.Out(Load(&acc[(size_t)x * 4]));
+			}
+		});
+	}
+
+	// One horizontal and one vertical box blur of a locked surface, using running sums
+	static void BoxPass(SDL_Surface* s, int radius, const Codec& codec, bool parallel)
+	{
+		const int w = s->w;
+		const int h = s->h;
+		const Vec4 scale = Splat(1.0f / (radius * 2 + 1));
+
+		MaybeParallelFor(parallel, h, [&](int begin, int end)
+		{
+			std::vector<Uint32> padded((size_t)w + radius * 2 + 1);
+
+			for (int y = begin; y < end; y++)
+			{
+				Uint32* row = Row<Uint32>(s, y);
+				PadRow(row, w, radius, padded.data());
+				padded.back() = row[w - 1];
+
+				Vec4 sum = Splat(0.0f);
+				for (int i = 0; i <= radius * 2; i++) sum = Add(sum, codec.In(padded[i]));
+
+				for (int x = 0; x < w; x++)
+				{
+					row[x] = codec.Out(Mul(sum, scale));
+					sum = Add(sum, Sub(codec.In(padded[(size_t)x + radius * 2 + 1]), codec.In(padded[x])));
+				}
+			}
+		});
+
+		std::vector<Uint32> pixels;
+		CopyPixels(s, pixels);
+
+		MaybeParallelFor(parallel, h, [&](int begin, int end)
+		{
+			std::vector<float> sums((size_t)w * 4, 0.0f);
+			const auto source = [&](int y) { return &pixels[(size_t)std::clamp(y, 0, h - 1) * w]; };
+
+			for (int i = -radius; i <= radius; i++)
+			{
+				const Uint32* in = source(begin + i);
+				for (int x = 0; x < w; x++) Store(&sums[(size_t)x * 4], Add(Load(&sums[(size_t)x * 4]), codec.In(in[x])));
+			}
+
+			for (int y = begin; y < end; y++)
+			{
+				Uint32* out = Row<Uint32>(s, y);
+				const Uint32* enter = source(y + radius + 1);
+				const Uint32* leave = source(y - radius);
+
+				for (int x = 0; x < w; x++)
+				{
+					const Vec4 sum = Load(&sums[(size_t)x * 4]);
+					out[x] = codec.Out(Mul(sum, scale));
+					Store(&sums[(size_t)x * 4], Add(sum, Sub(codec.In(enter[x]), codec.In(leave[x]))));
+				}
+			}
+		});
+	}
+
+	bool Blur(Surface& surface, float sigma, BlurMode mode, bool parallel, ColourSpace space)
+	{
+		if (!Begin(surface)) return false;
+
+		SDL_Surface* s = surface.surface.get();
+		const Codec codec(s, space);
+		if (sigma > 0.0f && s->w > 0 && s->h > 0)
+		{
+			if (mode == BlurMode::GAUSSIAN)
+			{
+				const int radius = std::max(1, (int)std::ceil(sigma * 3.0f));
+				Convolve(s, GaussianKernel(sigma, radius), codec, parallel);
+			}
+			else
+			{
+				int radii[3];
+				BoxRadii(sigma, radii);
+				for (int radius : radii) if (radius > 0) BoxPass(s, radius, codec, parallel);
+			}
+		}
+
+		SDL_UnlockSurface(s);
+		return true;
+	}
+
+	bool BoxBlur(Surface& surface, int radius, int passes, bool parallel, ColourSpace space)
+	{
+		if (!Begin(surface)) return false;
+
+		SDL_Surface* s = surface.surface.get();
+		const Codec codec(s, space);
+		if (radius > 0 && s->w > 0 && s->h > 0)
+			for (int i = 0; i < passes; i++) BoxPass(s, radius, codec, parallel);
+
+		SDL_UnlockSurface(s);
+		return true;
+	}
+
+	bool Sharpen(Surface& surface, float amount, float sigma, bool parallel, ColourSpace space)
+	{
+		if (!Check(surface)) return false;
+
+		Surface blurred = Surface::FromPtr(SDL_ConvertSurface(surface.surface.get(), surface.surface->format, 0));
+		if (!blurred.surface || !Blur(blurred, sigma, BlurMode::GAUSSIAN, parallel, space)) return false;
+		if (!Begin(surface)) return false;
+		if (SDL_LockSurface(blurred.surface.get()) != 0)
+		{
+			SDL_UnlockSurface(surface.surface.get());
+			return false;
+		}
+
+		SDL_Surface* s = surface.surface.get();
+		SDL_Surface* b = blurred.surface.get();
+		const Uint32 amask = s->format->Amask;
+		const Vec4 gain = Splat(amount);
+		const Codec codec(s, space);
+
+		MaybeParallelFor(parallel, s->h, [&](int begin, int end)
+		{
+			for (int y = begin; y < end; y++)
+			{
+				Uint32* out = Row<Uint32>(s, y);
+				const Uint32* blur = Row<const Uint32>(b, y);
+
+				for (int x = 0; x < s->w; x++)
+				{
+					const Vec4 p = codec.In(out[x]);
+					const Uint32 sharp = codec.Out(Add(p, Mul(gain, Sub(p, codec.In(blur[x])))));
+					out[x] = (sharp & ~amask) | (out[x] & amask);
+				}
+			}
+		});
+
+		SDL_UnlockSurface(b);
+		SDL_UnlockSurface(s);
+		return true;
+	}
+
+#pragma endregion
+
+#pragma region Morphology
+
+	// Separable square maximum or minimum filter, applied to alpha only when there is an alpha channel
+	static bool Morphology(Surface& surface, int radius, bool dilate, bool parallel)
+	{
+		if (!Begin(surface)) return false;
+
+		SDL_Surface* s = surface.surface.get();
+		const int w = s->w;
+		const int h = s->h;
+		const Uint32 keep = s->format->Amask ? ~s->format->Amask : 0;
+
+		if (radius > 0 && w > 0 && h > 0)
+		{
+			MaybeParallelFor(parallel, h, [&](int begin, int end)
+			{
+				std::vector<Uint32> padded((size_t)w + radius * 2);
+				std::vector<Uint32> acc(w);
+
+				for (int y = begin; y < end; y++)
+				{
+					Uint32* row = Row<Uint32>(s, y);
+					PadRow(row, w, radius, padded.data());
+					std::copy_n(padded.data(), w, acc.data());
+
+					for (int i = 1; i <= radius * 2; i++)
+						CombineBytes((Uint8*)acc.data(), (const Uint8*)(padded.data() + i), (size_t)w * 4, dilate);
+
+					for (int x = 0; x < w; x++) row[x] = (row[x] & keep) | (acc[x] & ~keep);
+				}
+			});
+
+			std::vector<Uint32> pixels;
+			CopyPixels(s, pixels);
+
+			MaybeParallelFor(parallel, h, [&](int begin, int end)
+			{
+				std::vector<Uint32> acc(w);
+
+				for (int y = begin; y < end; y++)
+				{
+					const Uint32* first = &pixels[(size_t)std::max(y - radius, 0) * w];
+					std::copy_n(first, w, acc.data());
+
+					for (int i = y - radius + 1; i <= y + radius; i++)
+						CombineBytes((Uint8*)acc.data(), (const Uint8*)&pixels[(size_t)std::clamp(i, 0, h - 1) * w], (size_t)w * 4, dilate);
+
+					Uint32* row = Row<Uint32>(s, y);
+					for (int x = 0; x < w; x++) row[x] = (row[x] & keep) | (acc[x] & ~keep);
+				}
+			});
+		}
+
+		SDL_UnlockSurface(s);
+		return true;
+	}
+
+	bool Dilate(Surface& surface, int radius, bool parallel) { return Morphology(surface, radius, true, parallel); }
+	bool Erode(Surface& surface, int radius, bool parallel) { return Morphology(surface, radius, false, parallel); }
+
+#pragma endregion
+
+#pragma region Shadows
+
+	int ShadowPadding(float sigma, int spread)
+		{ return std::max(spread, 0) + (sigma > 0.0f ? (int)std::ceil(sigma * 3.0f) : 0); }
+
+	Surface DropShadow(const Surface& surface, float sigma, const Colour& colour, int spread, BlurMode mode, bool parallel)
+	{
+		if (!surface.surface)
+		{
+			SDL_SetError("Parameter 'surface' is invalid");
+			return Surface::FromPtr(NULL);
+		}
+
+		// Formats without an 8-bit alpha channel are converted, which also turns a colour key into transparency
+		Surface source = surface;
+		if (!Is8888(surface.surface->format) || AlphaChannel(surface.surface->format) < 0)
+		{
+			source = Surface::FromPtr(SDL_ConvertSurfaceFormat(surface.surface.get(), SDL_PIXELFORMAT_ARGB8888, 0));
+			if (!source.surface) return source;
+		}
+
+		SDL_Surface* src = source.surface.get();
+		const int pad = ShadowPadding(sigma, spread);
+
+		Surface shadow = Surface::FromPtr(SDL_CreateRGBSurfaceWithFormat(0, src->w + pad * 2, src->h + pad * 2, 32, SDL_PIXELFORMAT_ARGB8888));
+		if (!shadow.surface) return shadow;
+
+		const Uint32 rgb = ((Uint32)colour.r << 16) | ((Uint32)colour.g << 8) | colour.b;
+		SDL_FillRect(shadow.surface.get(), NULL, rgb);
+
+		if (SDL_LockSurface(src) != 0) return Surface::FromPtr(NULL);
+
+		const int alpha = AlphaChannel(src->format);
+		for (int y = 0; y < src->h; y++)
+		{
+			const Uint32* in = Row<const Uint32>(src, y);
+			Uint32* out = Row<Uint32>(shadow.surface.get(), y + pad) + pad;
+			for (int x = 0; x < src->w; x++) out[x] = rgb | (Div255(((in[x] >> (alpha * 8)) & 0xFF) * colour.a) << 24);
+		}
+
+		SDL_UnlockSurface(src);
+
+		if (spread > 0 && !Dilate(shadow, spread, parallel)) return Surface::FromPtr(NULL);
+		if (!Blur(shadow, sigma, mode, parallel)) return Surface::FromPtr(NULL);
+
+		SDL_SetSurfaceBlendMode(shadow.surface.get(), SDL_BLENDMODE_BLEND);
+		return shadow;
+	}
+
+#pragma endregion
+}
+}
@@ -0,0 +1,391 @@
+#include "glyphcache.hpp"
+#include "pixelops.hpp"
+
+#ifdef SDL_glyphcache_hpp_
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace SDL::TTF
+{
+#pragma region Helpers
+
+	// Decode the next character of a UTF-8 string, advancing past it. Malformed sequences decode as U+FFFD
+	static Uint32 NextUTF8(const char*& text)
+	{
+		const Uint8* p = (const Uint8*)text;
+		Uint32 ch = *p++;
+		int extra = 0;
+
+		if      (ch < 0x80)           extra = 0;
+		else if ((ch & 0xE0) == 0xC0) { ch &= 0x1F; extra = 1; }
+		else if ((ch & 0xF0) == 0xE0) { ch &= 0x0F; extra = 2; }
+		else if ((ch & 0xF8) == 0xF0) { ch &= 0x07; extra = 3; }
+		else ch = 0xFFFD;
+
+		for (; extra > 0; extra--)
+		{
+			if ((*p & 0xC0) != 0x80)
+			{
+				ch = 0xFFFD;
+				break;
+			}
+			ch = (ch << 6) | (*p++ & 0x3F);
+		}
+
+		text = (const char*)p;
+		return ch;
+	}
+
+	// Reserve a w x h area of the atlas on the current shelf, starting a new shelf or doubling the atlas's height as needed
+	static bool Pack(GlyphCache& cache, int w, int h, Point& at)
+	{
+		SDL_Surface* a = cache.atlas.surface.get();
+		if (w > a->w)
+		{
+			SDL_SetError("Glyph is wider than the glyph atlas (%d > %d)", w, a->w);
+			return false;
+		}
+
+		if (cache.cursor.x + w > a->w)
+		{
+			cache.cursor = { 0, cache.cursor.y + cache.shelfHeight };
+			cache.shelfHeight = 0;
+		}
+
+		if (cache.cursor.y + h > a->h)
+		{
+			Surface grown(a->w, std::max(a->h * 2, cache.cursor.y + h), SDL_PIXELFORMAT_INDEX8);
+			if (!grown.surface) return false;
+
+			SDL_Surface* g = grown.surface.get();
+			SDL_SetPaletteColors(g->format->palette, a->format->palette->colors, 0, 256);
+			SDL_FillRect(g, NULL, 0);
+			for (int y = 0; y < a->h; y++) std::memcpy(Row<Uint8>(g, y), Row<Uint8>(a, y), (size_t)a->w);
+
+			cache.atlas = grown;
+		}
+
+		at = cache.cursor;
+		cache.cursor.x += w;
+		cache.shelfHeight = std::max(cache.shelfHeight, h);
+		return true;
+	}
+
+	// Merge the coverage of a glyph drawn with the pen at (x, y) into a strip of coverage covering area
+	static void MergeGlyph(const SDL_Surface* atlas, const GlyphCache::Glyph& glyph, int x, int y, Uint8* strip, const SDL_Rect& area)
+	{
+		const SDL_Rect bounds = { x + glyph.offset.x, y + glyph.offset.y, glyph.area.w, glyph.area.h };
+		SDL_Rect part;
+		if (!SDL_IntersectRect(&bounds, &area, &part)) return;
+
+		for (int row = part.y; row < part.y + part.h; row++)
+		{
+			const Uint8* in = (const Uint8*)atlas->pixels + (size_t)(glyph.area.y + row - bounds.y) * atlas->pitch + glyph.area.x + (part.x - bounds.x);
+			Uint8* out = strip + (size_t)(row - area.y) * area.w + (part.x - area.x);
+
+			// Kerning can make neighbouring glyphs overlap, so the stronger coverage wins
+			for (int i = 0; i < part.w; i++) out[i] = std::max(out[i], in[i]);
+		}
+	}
+
+	// Blend a row of coverage over a row of pixels with alpha in channel A, in a colour given as a pixel of the same
+	// format with 255 in channel A. Fusing the tint into the blend saves building a row of source pixels first, and
+	// blocks with no coverage, the gaps between glyphs, are skipped
+	template <int A>
+	static void BlendCoverage(const Uint8* coverage, Uint32* dst, int w, Uint32 colour, Uint8 opacity, bool premultiplied)
+	{
+		int x = 0;
+
+#if defined(SDLPP_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i full = _mm_set1_epi16(255);
+		const __m128i op = _mm_set1_epi16(opacity);
+		const __m128i s16 = _mm_unpacklo_epi8(_mm_set1_epi32((int)colour), zero);
+		const __m128i amask8 = _mm_set1_epi32((int)(0xFFu << (A * 8)));
+		const __m128i amask = _mm_unpacklo_epi8(amask8, amask8);
+		for (; x + 4 <= w; x += 4)
+		{
+			Uint32 c4;
+			std::memcpy(&c4, coverage + x, 4);
+			if (c4 == 0) continue;
+
+			// Spread each pixel's coverage over its four channels
+			__m128i c = _mm_cvtsi32_si128((int)c4);
+			c = _mm_unpacklo_epi8(c, c);
+			c = _mm_unpacklo_epi16(c, c);
+
+			const __m128i d = _mm_loadu_si128((const __m128i*)(dst + x));
+			__m128i half[2];
+
+			for (int i = 0; i < 2; i++)
+			{
+				const __m128i a = Div255(_mm_mullo_epi16(i ? _mm_unpackhi_epi8(c, zero) : _mm_unpacklo_epi8(c, zero), op));
+				const __m128i d16 = i ? _mm_unpackhi_epi8(d, zero) : _mm_unpacklo_epi8(d, zero);
+				const __m128i dinv = _mm_mullo_epi16(d16, _mm_sub_epi16(full, a));
+
+				if (premultiplied) half[i] = _mm_add_epi16(Div255(_mm_mullo_epi16(s16, a)), Div255(dinv));
+				else
+				{
+					const __m128i col = Div255(_mm_add_epi16(_mm_mullo_epi16(s16, a), dinv));
+					half[i] = _mm_or_si128(_mm_and_si128(amask, _mm_add_epi16(a, Div255(dinv))), _mm_andnot_si128(amask, col));
+				}
+			}
+
+			_mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(half[0], half[1]));
+		}
+#elif defined(SDLPP_NEON)
+		const uint8x8_t op = vdup_n_u8(opacity);
+		for (; x + 8 <= w; x += 8)
+		{
+			const uint8x8_t cov = vld1_u8(coverage + x);
+			if (vget_lane_u64(vreinterpret_u64_u8(cov), 0) == 0) continue;
+
+			const uint8x8_t a = Div255(vmull_u8(cov, op));
+			const uint8x8_t inv = vmvn_u8(a);
+			uint8x8x4_t d = vld4_u8((const uint8_t*)(dst + x));
+			for (int c = 0; c < 4; c++)
+			{
+				const uint8x8_t sc = vdup_n_u8((Uint8)(colour >> (c * 8)));
+				if (premultiplied) d.val[c] = vqadd_u8(Div255(vmull_u8(sc, a)), Div255(vmull_u8(d.val[c], inv)));
+				else if (c == A) d.val[c] = vqadd_u8(a, Div255(vmull_u8(d.val[c], inv)));
+				else d.val[c] = Div255(vmlal_u8(vmull_u8(sc, a), d.val[c], inv));
+			}
+			vst4_u8((uint8_t*)(dst + x), d);
+		}
+#endif
+
+		for (; x < w; x++)
+		{
+			if (coverage[x] == 0) continue;
+
+			const Uint32 a = Div255(coverage[x] * (Uint32)opacity);
+			const Uint32 d = dst[x];
+			Uint32 r = 0;
+			for (int c = 0; c < 4; c++)
+			{
+				const Uint32 sc = (colour >> (c * 8)) & 0xFF;
+				const Uint32 dc = (d >> (c * 8)) & 0xFF;
+				Uint32 v;
+				if (premultiplied) v = std::min(255u, Div255(sc * a) + Div255(dc * (255 - a)));
+				else if (c == A) v = std::min(255u, a + Div255(dc * (255 - a)));
+				else v = Div255(sc * a + dc * (255 - a));
+				r |= v << (c * 8);
+			}
+			dst[x] = r;
+		}
+	}
+
+#pragma endregion
+
+#pragma region GlyphCache
+
+	GlyphCache::GlyphCache(const Font& font, int atlas_width)
+		: font(font), atlas(Surface(atlas_width, 64, SDL_PIXELFORMAT_INDEX8)), glyphs(), cursor(0, 0)
+	{
+		if (!atlas.surface) return;
+
+		SDL_Colour ramp[256];
+		for (int i = 0; i < 256; i++) ramp[i] = { (Uint8)i, (Uint8)i, (Uint8)i, 255 };
+		SDL_SetPaletteColors(atlas.surface->format->palette, ramp, 0, 256);
+		SDL_FillRect(atlas.surface.get(), NULL, 0);
+	}
+
+	const GlyphCache::Glyph* GlyphCache::GetGlyph(Uint32 ch)
+	{
+		auto it = glyphs.find(ch);
+		if (it != glyphs.end()) return &it->second;
+
+		if (!atlas.surface || !font.font)
+		{
+			SDL_SetError("Parameter '%s' is invalid", atlas.surface ? "font" : "atlas");
+			return NULL;
+		}
+
+		int minx, maxx, miny, maxy, advance;
+		if (!font.GlyphMetrics32(ch, &minx, &maxx, &miny, &maxy, &advance)) return NULL;
+
+		Glyph glyph = { Rect(0, 0, 0, 0), Point(0, 0), advance };
+
+		// Glyphs that draw nothing, such as spaces, have no surface to render and only advance the pen
+		Surface cell = font.RenderGlyph32_Blended(ch, { 255, 255, 255, 255 });
+		SDL_Surface* c = cell.surface.get();
+
+		if (c != NULL && SDL_LockSurface(c) == 0)
+		{
+			// Trim the cell to the pixels the glyph covers
+			const int shift = c->format->Ashift;
+			int left = c->w, right = 0, top = c->h, bottom = 0;
+
+			for (int y = 0; y < c->h; y++)
+			{
+				const Uint32* px = Row<const Uint32>(c, y);
+				for (int x = 0; x < c->w; x++)
+				{
+					if (((px[x] >> shift) & 0xFF) == 0) continue;
+					left = std::min(left, x);
+					right = std::max(right, x + 1);
+					top = std::min(top, y);
+					bottom = std::max(bottom, y + 1);
+				}
+			}
+
+			Point at;
+			if (left < right && Pack(*this, right - left, bottom - top, at))
+			{
+				SDL_Surface* a = atlas.surface.get();
+				for (int y = top; y < bottom; y++)
+				{
+					const Uint32* px = Row<const Uint32>(c, y);
+					Uint8* out = Row<Uint8>(a, at.y + y - top) + at.x;
+					for (int x = left; x < right; x++) out[x - left] = (Uint8)(px[x] >> shift);
+				}
+
+				// The cell starts at the pen unless the glyph reaches left of it or above the ascent, which widens the cell
+				glyph.area = Rect(at.x, at.y, right - left, bottom - top);
+				glyph.offset = Point(left + std::min(0, minx), top - std::max(0, maxy - font.Ascent()));
+			}
+
+			SDL_UnlockSurface(c);
+		}
+
+		return &glyphs.emplace(ch, glyph).first->second;
+	}
+
+	bool GlyphCache::Preload(const char* text)
+	{
+		bool success = true;
+		while (*text) success &= GetGlyph(NextUTF8(text)) != NULL;
+		return success;
+	}
+
+	Point GlyphCache::MeasureUTF8(const char* text)
+	{
+		const bool kerning = font.GetKerning();
+		Point size(0, *text ? font.Height() : 0);
+		int x = 0;
+		Uint32 prev = 0;
+
+		while (*text)
+		{
+			const Uint32 ch = NextUTF8(text);
+			if (ch == '\n')
+			{
+				size.y += font.LineSkip();
+				x = 0;
+				prev = 0;
+				continue;
+			}
+
+			const Glyph* glyph = GetGlyph(ch);
+			if (glyph == NULL) continue;
+
+			if (kerning && prev != 0) x += font.GetKerningSizeGlyphs32(prev, ch);
+			x += glyph->advance;
+			size.x = std::max(size.x, x);
+			prev = ch;
+		}
+
+		return size;
+	}
+
+	bool GlyphCache::DrawUTF8(Surface& dst, const char* text, const Point& pos, Colour colour)
+	{
+		if (!dst.surface || text == NULL)
+		{
+			SDL_SetError("Parameter '%s' is invalid", dst.surface ? "text" : "dst");
+			return false;
+		}
+
+		SDL_Surface* d = dst.surface.get();
+		const SDL_PixelFormat* f = d->format;
+		if (!Is8888(f))
+		{
+			SDL_SetError("Text can only be drawn onto surfaces in a 32-bit format with 8-bit channels");
+			return false;
+		}
+
+		if (colour.a == 0) return true;
+
+		// Formats without alpha blend through their padding byte, whose value does not matter
+		const int alpha = f->Amask ? f->Ashift / 8 : (48 - f->Rshift - f->Gshift - f->Bshift) / 8;
+
+		// The text colour as a pixel of dst's format, with full alpha so premultiplying by coverage gives the alpha too
+		const Uint32 pixel = ((Uint32)colour.r << f->Rshift) | ((Uint32)colour.g << f->Gshift) | ((Uint32)colour.b << f->Bshift) | (0xFFu << (alpha * 8));
+
+		if (SDL_LockSurface(d) != 0) return false;
+
+		const bool kerning = font.GetKerning();
+		int y = pos.y;
+
+		// Each line is laid out, merged into one strip of coverage and then blended a whole row at a time, which keeps
+		// the blending kernels on long rows rather than a few pixels of each glyph
+		for (;;)
+		{
+			placed.clear();
+			int left = INT_MAX, right = INT_MIN, top = INT_MAX, bottom = INT_MIN;
+			int x = pos.x;
+			Uint32 prev = 0;
+
+			while (*text != '\0' && *text != '\n')
+			{
+				const Uint32 ch = NextUTF8(text);
+				const Glyph* glyph = GetGlyph(ch);
+				if (glyph == NULL) continue;
+
+				if (kerning && prev != 0) x += font.GetKerningSizeGlyphs32(prev, ch);
+
+				if (glyph->area.w > 0)
+				{
+					placed.emplace_back(glyph, x);
+					left = std::min(left, x + glyph->offset.x);
+					right = std::max(right, x + glyph->offset.x + glyph->area.w);
+					top = std::min(top, glyph->offset.y);
+					bottom = std::max(bottom, glyph->offset.y + glyph->area.h);
+				}
+
+				x += glyph->advance;
+				prev = ch;
+			}
+
+			const SDL_Rect bounds = { left, y + top, right - left, bottom - top };
+			SDL_Rect area;
+
+			if (!placed.empty() && SDL_IntersectRect(&bounds, &d->clip_rect, &area))
+			{
+				const size_t size = (size_t)area.w * area.h;
+				if (strip.size() < size) strip.resize(size);
+				std::memset(strip.data(), 0, size);
+
+				for (const auto& glyph : placed) MergeGlyph(atlas.surface.get(), *glyph.first, glyph.second, y, strip.data(), area);
+
+				void (*blend)(const Uint8*, Uint32*, int, Uint32, Uint8, bool) =
+					alpha == 0 ? BlendCoverage<0> : alpha == 1 ? BlendCoverage<1> : alpha == 2 ? BlendCoverage<2> : BlendCoverage<3>;
+
+				for (int r = 0; r < area.h; r++)
+					blend(strip.data() + (size_t)r * area.w, Row<Uint32>(d, area.y + r) + area.x, area.w, pixel, colour.a, dst.IsPremultiplied());
+			}
+
+			if (*text == '\0') break;
+			text++;
+			y += font.LineSkip();
+		}
+
+		SDL_UnlockSurface(d);
+
+		return true;
+	}
+
+	void GlyphCache::Clear()
+	{
+		glyphs.clear();
+		cursor = { 0, 0 };
+		shelfHeight = 0;
+		if (atlas.surface) SDL_FillRect(atlas.surface.get(), NULL, 0);
+	}
+
+#pragma endregion
+}
+
+#endif
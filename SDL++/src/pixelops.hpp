@@ -0,0 +1,309 @@
+#ifndef SDL_pixelops_hpp_
+#define SDL_pixelops_hpp_
+#pragma once
+
+// Helpers shared by the software pixel kernels in src/. Not part of the public headers.
+
+#include <SDL_pixels.h>
+#include <SDL_surface.h>
+
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace SDL
+{
+	// True if every channel of the format is a whole byte of a 32-bit pixel, which the software kernels work on directly
+	inline bool Is8888(const SDL_PixelFormat* fmt)
+	{
+		if (fmt->BytesPerPixel != 4) return false;
+		if (fmt->Rmask != 0xFFu << fmt->Rshift || fmt->Rshift % 8 != 0) return false;
+		if (fmt->Gmask != 0xFFu << fmt->Gshift || fmt->Gshift % 8 != 0) return false;
+		if (fmt->Bmask != 0xFFu << fmt->Bshift || fmt->Bshift % 8 != 0) return false;
+		return fmt->Amask == 0 || (fmt->Amask == 0xFFu << fmt->Ashift && fmt->Ashift % 8 == 0);
+	}
+
+	// The channel index (shift / 8) of alpha in an 8888 pixel, or -1 if there is none
+	inline int AlphaChannel(const SDL_PixelFormat* fmt) { return fmt->Amask ? fmt->Ashift / 8 : -1; }
+
+	// Pointer to the first pixel of a row
+	template <typename T>
+	inline T* Row(SDL_Surface* s, int y) { return (T*)((Uint8*)s->pixels + (size_t)y * s->pitch); }
+
+	// The sRGB <-> linear tables, built on first use. Mipmapping uses 14-bit linear values, so four of them sum into
+	// a Uint16, while blending and filtering use the full 16 bits
+	struct LinearLUT
+	{
+		Uint16 toLinear[256];
+		Uint16 toLinear16[256];
+		Uint8 toSRGB[1 << 14];
+
+		LinearLUT()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				const double c = i / 255.0;
+				const double l = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+				toLinear[i] = (Uint16)std::lround(l * 16383.0);
+				toLinear16[i] = (Uint16)std::lround(l * 65535.0);
+			}
+			for (int i = 0; i < (1 << 14); i++)
+			{
+				const double l = i / 16383.0;
+				const double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+				toSRGB[i] = (Uint8)std::clamp(std::lround(c * 255.0), 0L, 255L);
+			}
+		}
+	};
+
+	inline const LinearLUT& GetLinearLUT()
+	{
+		static const LinearLUT lut;
+		return lut;
+	}
+
+	// Convert a 16-bit linear value back to 8-bit sRGB
+	inline Uint8 FromLinear16(const LinearLUT& lut, Uint32 l) { return lut.toSRGB[(std::min(l, 65535u) * 16383 + 32767) / 65535]; }
+
+	// Divide a product of two 8-bit values by 255, rounded to nearest
+	inline Uint32 Div255(Uint32 v)
+	{
+		v += 128;
+		return (v + (v >> 8)) >> 8;
+	}
+
+#if defined(SDLPP_SSE2)
+	// Divide 16-bit lanes holding products of two 8-bit values by 255, rounded to nearest
+	inline __m128i Div255(__m128i v)
+	{
+		v = _mm_add_epi16(v, _mm_set1_epi16(128));
+		return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+	}
+
+	// Copy channel A of each of the two 16-bit expanded pixels in v across that pixel's four lanes
+	template <int A>
+	inline __m128i BroadcastChannel(__m128i v)
+	{
+		v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(A, A, A, A));
+		return _mm_shufflehi_epi16(v, _MM_SHUFFLE(A, A, A, A));
+	}
+#elif defined(SDLPP_NEON)
+	// Divide 16-bit lanes holding products of two 8-bit values by 255, rounded to nearest
+	inline uint8x8_t Div255(uint16x8_t v) { return vraddhn_u16(v, vrshrq_n_u16(v, 8)); }
+#endif
+
+	// Composite a row of premultiplied pixels over a row of the same format, with alpha in channel A and no modulation
+	template <int A>
+	inline void BlendRowPremultiplied(const Uint32* src, Uint32* dst, int w, bool add)
+	{
+		int x = 0;
+
+#if defined(SDLPP_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i full = _mm_set1_epi16(255);
+		const __m128i amask = _mm_set1_epi32((int)(0xFFu << (A * 8)));
+		for (; x + 4 <= w; x += 4)
+		{
+			const __m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+			const __m128i d = _mm_loadu_si128((const __m128i*)(dst + x));
+
+			if (add)
+			{
+				const __m128i r = _mm_adds_epu8(s, d);
+				_mm_storeu_si128((__m128i*)(dst + x), _mm_or_si128(_mm_and_si128(d, amask), _mm_andnot_si128(amask, r)));
+				continue;
+			}
+
+			const __m128i ilo = _mm_sub_epi16(full, BroadcastChannel<A>(_mm_unpacklo_epi8(s, zero)));
+			const __m128i ihi = _mm_sub_epi16(full, BroadcastChannel<A>(_mm_unpackhi_epi8(s, zero)));
+			const __m128i dlo = Div255(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), ilo));
+			const __m128i dhi = Div255(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), ihi));
+			_mm_storeu_si128((__m128i*)(dst + x), _mm_adds_epu8(s, _mm_packus_epi16(dlo, dhi)));
+		}
+#elif defined(SDLPP_NEON)
+		for (; x + 8 <= w; x += 8)
+		{
+			const uint8x8x4_t s = vld4_u8((const uint8_t*)(src + x));
+			uint8x8x4_t d = vld4_u8((const uint8_t*)(dst + x));
+			const uint8x8_t inv = vmvn_u8(s.val[A]);
+			for (int c = 0; c < 4; c++)
+			{
+				if (add) { if (c != A) d.val[c] = vqadd_u8(s.val[c], d.val[c]); }
+				else d.val[c] = vqadd_u8(s.val[c], Div255(vmull_u8(d.val[c], inv)));
+			}
+			vst4_u8((uint8_t*)(dst + x), d);
+		}
+#endif
+
+		for (; x < w; x++)
+		{
+			const Uint32 s = src[x];
+			const Uint32 d = dst[x];
+			const Uint32 inv = 255 - ((s >> (A * 8)) & 0xFF);
+			Uint32 r = 0;
+			for (int c = 0; c < 4; c++)
+			{
+				const Uint32 sc = (s >> (c * 8)) & 0xFF;
+				const Uint32 dc = (d >> (c * 8)) & 0xFF;
+				Uint32 v;
+				if (add) v = c == A ? dc : std::min(255u, sc + dc);
+				else v = std::min(255u, sc + Div255(dc * inv));
+				r |= v << (c * 8);
+			}
+			dst[x] = r;
+		}
+	}
+
+	// Composite a row of straight alpha pixels over a row of the same format, with alpha in channel A
+	template <int A>
+	inline void BlendRowStraight(const Uint32* src, Uint32* dst, int w, bool add)
+	{
+		int x = 0;
+
+#if defined(SDLPP_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i full = _mm_set1_epi16(255);
+		const __m128i amask8 = _mm_set1_epi32((int)(0xFFu << (A * 8)));
+		const __m128i amask = _mm_unpacklo_epi8(amask8, amask8);
+		for (; x + 4 <= w; x += 4)
+		{
+			const __m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+			const __m128i d = _mm_loadu_si128((const __m128i*)(dst + x));
+			__m128i half[2];
+
+			for (int i = 0; i < 2; i++)
+			{
+				const __m128i s16 = i ? _mm_unpackhi_epi8(s, zero) : _mm_unpacklo_epi8(s, zero);
+				const __m128i d16 = i ? _mm_unpackhi_epi8(d, zero) : _mm_unpacklo_epi8(d, zero);
+				const __m128i a = BroadcastChannel<A>(s16);
+
+				if (add)
+				{
+					const __m128i sum = _mm_add_epi16(d16, Div255(_mm_mullo_epi16(s16, a)));
+					half[i] = _mm_or_si128(_mm_and_si128(amask, d16), _mm_andnot_si128(amask, sum));
+				}
+				else
+				{
+					const __m128i inv = _mm_sub_epi16(full, a);
+					const __m128i dinv = _mm_mullo_epi16(d16, inv);
+					const __m128i colour = Div255(_mm_add_epi16(_mm_mullo_epi16(s16, a), dinv));
+					const __m128i alpha = _mm_add_epi16(a, Div255(dinv));
+					half[i] = _mm_or_si128(_mm_and_si128(amask, alpha), _mm_andnot_si128(amask, colour));
+				}
+			}
+
+			_mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(half[0], half[1]));
+		}
+#elif defined(SDLPP_NEON)
+		for (; x + 8 <= w; x += 8)
+		{
+			const uint8x8x4_t s = vld4_u8((const uint8_t*)(src + x));
+			uint8x8x4_t d = vld4_u8((const uint8_t*)(dst + x));
+			const uint8x8_t a = s.val[A];
+			const uint8x8_t inv = vmvn_u8(a);
+			for (int c = 0; c < 4; c++)
+			{
+				if (add) { if (c != A) d.val[c] = vqadd_u8(d.val[c], Div255(vmull_u8(s.val[c], a))); }
+				else if (c == A) d.val[c] = vqadd_u8(a, Div255(vmull_u8(d.val[c], inv)));
+				else d.val[c] = Div255(vmlal_u8(vmull_u8(s.val[c], a), d.val[c], inv));
+			}
+			vst4_u8((uint8_t*)(dst + x), d);
+		}
+#endif
+
+		for (; x < w; x++)
+		{
+			const Uint32 s = src[x];
+			const Uint32 d = dst[x];
+			const Uint32 a = (s >> (A * 8)) & 0xFF;
+			Uint32 r = 0;
+			for (int c = 0; c < 4; c++)
+			{
+				const Uint32 sc = (s >> (c * 8)) & 0xFF;
+				const Uint32 dc = (d >> (c * 8)) & 0xFF;
+				Uint32 v;
+				if (add) v = c == A ? dc : std::min(255u, dc + Div255(sc * a));
+				else if (c == A) v = std::min(255u, a + Div255(dc * (255 - a)));
+				else v = Div255(sc * a + dc * (255 - a));
+				r |= v << (c * 8);
+			}
+			dst[x] = r;
+		}
+	}
+
+	// Composite a row of straight alpha pixels over a row of the same format in linear light, with alpha in channel A.
+	// Every colour channel goes through the tables, which SSE2 and NEON cannot gather from, so this stays scalar
+	template <int A>
+	inline void BlendRowLinear(const Uint32* src, Uint32* dst, int w, bool add)
+	{
+		const LinearLUT& lut = GetLinearLUT();
+
+		for (int x = 0; x < w; x++)
+		{
+			const Uint32 s = src[x];
+			const Uint32 d = dst[x];
+			const Uint32 a = (s >> (A * 8)) & 0xFF;
+			if (a == 0) continue;
+
+			Uint32 r = 0;
+			for (int c = 0; c < 4; c++)
+			{
+				const Uint32 sc = (s >> (c * 8)) & 0xFF;
+				const Uint32 dc = (d >> (c * 8)) & 0xFF;
+				Uint32 v;
+				if (c == A) v = add ? dc : std::min(255u, a + Div255(dc * (255 - a)));
+				else if (add) v = FromLinear16(lut, lut.toLinear16[dc] + (lut.toLinear16[sc] * a + 127) / 255);
+				else v = FromLinear16(lut, (lut.toLinear16[sc] * a + lut.toLinear16[dc] * (255 - a) + 127) / 255);
+				r |= v << (c * 8);
+			}
+			dst[x] = r;
+		}
+	}
+
+	// Composite a row of samples into a row of the same format with a blit blend mode. Straight alpha is blended in
+	// linear light if linear is true; premultiplied colour is always blended as stored
+	inline void CompositeRow(const Uint32* src, Uint32* dst, int w, SDL_BlendMode blendMode, int alpha, bool premultiplied, bool linear = false)
+	{
+		const bool add = blendMode == SDL_BLENDMODE_ADD;
+
+		if (blendMode == SDL_BLENDMODE_NONE || (alpha < 0 && !add))
+		{
+			if (src != dst) std::copy_n(src, w, dst);
+			return;
+		}
+
+		if (alpha < 0)
+		{
+			for (int x = 0; x < w; x++)
+			{
+				Uint32 r = 0;
+				for (int c = 0; c < 32; c += 8) r |= std::min(255u, ((src[x] >> c) & 0xFF) + ((dst[x] >> c) & 0xFF)) << c;
+				dst[x] = r;
+			}
+			return;
+		}
+
+		if (linear && !premultiplied)
+		{
+			switch (alpha)
+			{
+			case 0: BlendRowLinear<0>(src, dst, w, add); break;
+			case 1: BlendRowLinear<1>(src, dst, w, add); break;
+			case 2: BlendRowLinear<2>(src, dst, w, add); break;
+			case 3: BlendRowLinear<3>(src, dst, w, add); break;
+			}
+			return;
+		}
+
+		switch (alpha)
+		{
+		case 0: premultiplied ? BlendRowPremultiplied<0>(src, dst, w, add) : BlendRowStraight<0>(src, dst, w, add); break;
+		case 1: premultiplied ? BlendRowPremultiplied<1>(src, dst, w, add) : BlendRowStraight<1>(src, dst, w, add); break;
+		case 2: premultiplied ? BlendRowPremultiplied<2>(src, dst, w, add) : BlendRowStraight<2>(src, dst, w, add); break;
+		case 3: premultiplied ? BlendRowPremultiplied<3>(src, dst, w, add) : BlendRowStraight<3>(src, dst, w, add); break;
+		}
+	}
+}
+
+#endif
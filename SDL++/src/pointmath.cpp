@@ -0,0 +1,422 @@
+#include "pointmath.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace SDL
+{
+namespace PointMath
+{
+#pragma region Vector Helpers
+
+	// A lane of floats for each of LANES points, and the result of comparing them
+#if defined(SDLPP_SSE2)
+	static constexpr int LANES = 4;
+	typedef __m128 Vec;
+	typedef __m128 Mask;
+
+	static inline Vec Splat(float v) { return _mm_set1_ps(v); }
+	static inline Vec Load(const float* p) { return _mm_loadu_ps(p); }
+	static inline void Store(float* p, Vec v) { _mm_storeu_ps(p, v); }
+	static inline Vec Add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+	static inline Vec Sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+	static inline Vec Mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+	static inline Vec Div(Vec a, Vec b) { return _mm_div_ps(a, b); }
+	static inline Vec Sqrt(Vec a) { return _mm_sqrt_ps(a); }
+	static inline Vec Min(Vec a, Vec b) { return _mm_min_ps(a, b); }
+	static inline Vec Max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+	static inline Mask Greater(Vec a, Vec b) { return _mm_cmpgt_ps(a, b); }
+	static inline Vec And(Mask m, Vec v) { return _mm_and_ps(m, v); }
+
+	static inline Vec FastRsqrt(Vec x)
+	{
+		const Vec y = _mm_rsqrt_ps(x);
+		return Mul(y, Sub(Splat(1.5f), Mul(Mul(Splat(0.5f), x), Mul(y, y))));
+	}
+
+	// Split 4 points into their x and y, and put them back together
+	static inline void LoadPoints(const FPoint* p, Vec& x, Vec& y)
+	{
+		const __m128 a = _mm_loadu_ps(&p[0].x), b = _mm_loadu_ps(&p[2].x);
+		x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+	}
+
+	static inline void StorePoints(FPoint* p, Vec x, Vec y)
+	{
+		_mm_storeu_ps(&p[0].x, _mm_unpacklo_ps(x, y));
+		_mm_storeu_ps(&p[2].x, _mm_unpackhi_ps(x, y));
+	}
+#elif defined(SDLPP_NEON)
+	static constexpr int LANES = 4;
+	typedef float32x4_t Vec;
+	typedef uint32x4_t Mask;
+
+	static inline Vec Splat(float v) { return vdupq_n_f32(v); }
+	static inline Vec Load(const float* p) { return vld1q_f32(p); }
+	static inline void Store(float* p, Vec v) { vst1q_f32(p, v); }
+	static inline Vec Add(Vec a, Vec b) { return vaddq_f32(a, b); }
+	static inline Vec Sub(Vec a, Vec b) { return vsubq_f32(a, b); }
+	static inline Vec Mul(Vec a, Vec b) { return vmulq_f32(a, b); }
+	static inline Vec Min(Vec a, Vec b) { return vminq_f32(a, b); }
+	static inline Vec Max(Vec a, Vec b) { return vmaxq_f32(a, b); }
+	static inline Mask Greater(Vec a, Vec b) { return vcgtq_f32(a, b); }
+	static inline Vec And(Mask m, Vec v) { return vreinterpretq_f32_u32(vandq_u32(m, vreinterpretq_u32_f32(v))); }
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+	static inline Vec Div(Vec a, Vec b) { return vdivq_f32(a, b); }
+	static inline Vec Sqrt(Vec a) { return vsqrtq_f32(a); }
+#else
+	// 32-bit NEON has no division or square root, so do them a lane at a time to stay exact
+	static inline Vec Div(Vec a, Vec b)
+	{
+		float x[4], y[4];
+		vst1q_f32(x, a); vst1q_f32(y, b);
+		for (int i = 0; i < 4; i++) x[i] /= y[i];
+		return vld1q_f32(x);
+	}
+
+	static inline Vec Sqrt(Vec a)
+	{
+		float x[4];
+		vst1q_f32(x, a);
+		for (int i = 0; i < 4; i++) x[i] = std::sqrt(x[i]);
+		return vld1q_f32(x);
+	}
+#endif
+
+	static inline Vec FastRsqrt(Vec x)
+	{
+		Vec y = vrsqrteq_f32(x);
+		y = vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(x, y), y));
+		return vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(x, y), y));
+	}
+
+	static inline void LoadPoints(const FPoint* p, Vec& x, Vec& y)
+	{
+		const float32x4x2_t v = vld2q_f32(&p[0].x);
+		x = v.val[0];
+		y = v.val[1];
+	}
+
+	static inline void StorePoints(FPoint* p, Vec x, Vec y)
+	{
+		float32x4x2_t v;
+		v.val[0] = x;
+		v.val[1] = y;
+		vst2q_f32(&p[0].x, v);
+	}
+#else
+	// Without vector instructions, kernels run a point at a time
+	static constexpr int LANES = 1;
+	typedef float Vec;
+	typedef bool Mask;
+
+	static inline Vec Splat(float v) { return v; }
+	static inline Vec Load(const float* p) { return *p; }
+	static inline void Store(float* p, Vec v) { *p = v; }
+	static inline Vec Add(Vec a, Vec b) { return a + b; }
+	static inline Vec Sub(Vec a, Vec b) { return a - b; }
+	static inline Vec Mul(Vec a, Vec b) { return a * b; }
+	static inline Vec Div(Vec a, Vec b) { return a / b; }
+	static inline Vec Sqrt(Vec a) { return std::sqrt(a); }
+	static inline Vec Min(Vec a, Vec b) { return std::min(a, b); }
+	static inline Vec Max(Vec a, Vec b) { return std::max(a, b); }
+	static inline Mask Greater(Vec a, Vec b) { return a > b; }
+	static inline Vec And(Mask m, Vec v) { return m ? v : 0.f; }
+
+	static inline void LoadPoints(const FPoint* p, Vec& x, Vec& y) { x = p->x; y = p->y; }
+	static inline void StorePoints(FPoint* p, Vec x, Vec y) { p->x = x; p->y = y; }
+#endif
+
+	// The same steps as the scalar ReduceAngle(), FastSin() and FastCos(), so every path gives the same results
+	static inline Vec ReduceLanes(Vec angle)
+	{
+		const Vec k = Sub(Add(Mul(angle, Splat(0.159154943f)), Splat(12582912.f)), Splat(12582912.f));
+		return Sub(Sub(angle, Mul(k, Splat(6.28125f))), Mul(k, Splat(1.93530717e-3f)));
+	}
+
+	static inline Vec SinLanes(Vec angle)
+	{
+		Vec x = ReduceLanes(angle);
+		x = Min(x, Sub(Splat(3.14159265f), x));
+		x = Max(x, Sub(Splat(-3.14159265f), x));
+
+		const Vec x2 = Mul(x, x);
+		Vec p = Add(Splat(2.75573192e-6f), Mul(x2, Splat(-2.50521084e-8f)));
+		p = Add(Splat(-1.98412698e-4f), Mul(x2, p));
+		p = Add(Splat(8.33333333e-3f), Mul(x2, p));
+		p = Add(Splat(-1.66666667e-1f), Mul(x2, p));
+		p = Add(Splat(1.f), Mul(x2, p));
+		return Mul(x, p);
+	}
+
+	// Read and write n <= LANES items at a time, going through a padded copy for the last few
+	static inline Vec LoadFloats(const float* p, int n)
+	{
+		if (n == LANES) return Load(p);
+		float tmp[LANES] = {};
+		std::copy(p, p + n, tmp);
+		return Load(tmp);
+	}
+
+	static inline void StoreFloats(float* p, int n, Vec v)
+	{
+		if (n == LANES) return Store(p, v);
+		float tmp[LANES];
+		Store(tmp, v);
+		std::copy(tmp, tmp + n, p);
+	}
+
+	// Where a kernel reads points from and writes them to
+	struct AoSIn
+	{
+		const FPoint* p;
+
+		inline void Load(int i, int n, Vec& x, Vec& y) const
+		{
+			if (n == LANES) return LoadPoints(p + i, x, y);
+			FPoint tmp[LANES] = {};
+			std::copy(p + i, p + i + n, tmp);
+			LoadPoints(tmp, x, y);
+		}
+	};
+
+	struct AoSOut
+	{
+		FPoint* p;
+
+		inline void Store(int i, int n, Vec x, Vec y) const
+		{
+			if (n == LANES) return StorePoints(p + i, x, y);
+			FPoint tmp[LANES];
+			StorePoints(tmp, x, y);
+			std::copy(tmp, tmp + n, p + i);
+		}
+	};
+
+	struct SoAIn
+	{
+		const float* x;
+		const float* y;
+
+		inline SoAIn(const PointSoA& points) : x(points.x.data()), y(points.y.data()) {}
+		inline void Load(int i, int n, Vec& vx, Vec& vy) const { vx = LoadFloats(x + i, n); vy = LoadFloats(y + i, n); }
+	};
+
+	struct SoAOut
+	{
+		float* x;
+		float* y;
+
+		inline SoAOut(PointSoA& points, int size) { points.Resize(size); x = points.x.data(); y = points.y.data(); }
+		inline void Store(int i, int n, Vec vx, Vec vy) const { StoreFloats(x + i, n, vx); StoreFloats(y + i, n, vy); }
+	};
+
+#pragma endregion
+
+#pragma region Kernels
+
+	// Call f(i, n, x, y) on each group of up to LANES points, which changes them in place
+	template <typename In, typename Out, typename F>
+	static void Map(const In& in, const Out& out, int count, F&& f)
+	{
+		for (int i = 0; i < count; i += LANES)
+		{
+			const int n = std::min(LANES, count - i);
+			Vec x, y;
+			in.Load(i, n, x, y);
+			f(i, n, x, y);
+			out.Store(i, n, x, y);
+		}
+	}
+
+	// Call f(ax, ay, bx, by) on each group of up to LANES pairs of points, which leaves the result in ax and ay
+	template <typename A, typename B, typename Out, typename F>
+	static void Map2(const A& a, const B& b, const Out& out, int count, F&& f)
+	{
+		for (int i = 0; i < count; i += LANES)
+		{
+			const int n = std::min(LANES, count - i);
+			Vec ax, ay, bx, by;
+			a.Load(i, n, ax, ay);
+			b.Load(i, n, bx, by);
+			f(ax, ay, bx, by);
+			out.Store(i, n, ax, ay);
+		}
+	}
+
+	// Write f(x, y) for each group of up to LANES points to out
+	template <typename In, typename F>
+	static void Reduce(const In& in, float* out, int count, F&& f)
+	{
+		for (int i = 0; i < count; i += LANES)
+		{
+			const int n = std::min(LANES, count - i);
+			Vec x, y;
+			in.Load(i, n, x, y);
+			StoreFloats(out + i, n, f(x, y));
+		}
+	}
+
+	template <typename In, typename Out>
+	static void AddOffset(const In& in, const Out& out, int count, const FPoint& offset)
+	{
+		const Vec ox = Splat(offset.x), oy = Splat(offset.y);
+		Map(in, out, count, [&](int, int, Vec& x, Vec& y) { x = Add(x, ox); y = Add(y, oy); });
+	}
+
+	template <typename A, typename B, typename Out>
+	static void AddPoints(const A& a, const B& b, const Out& out, int count)
+		{ Map2(a, b, out, count, [](Vec& ax, Vec& ay, Vec bx, Vec by) { ax = Add(ax, bx); ay = Add(ay, by); }); }
+
+	template <typename In, typename Out>
+	static void ScalePoints(const In& in, const Out& out, int count, const FPoint& factor)
+	{
+		const Vec fx = Splat(factor.x), fy = Splat(factor.y);
+		Map(in, out, count, [&](int, int, Vec& x, Vec& y) { x = Mul(x, fx); y = Mul(y, fy); });
+	}
+
+	template <typename In, typename Out>
+	static void RotateAll(const In& in, const Out& out, int count, float angle, const FPoint& centre)
+	{
+		const Vec cs = Splat(cosf(angle)), sn = Splat(sinf(angle));
+		const Vec cx = Splat(centre.x), cy = Splat(centre.y);
+		Map(in, out, count, [&](int, int, Vec& x, Vec& y)
+		{
+			const Vec dx = Sub(x, cx), dy = Sub(y, cy);
+			x = Add(Sub(Mul(dx, cs), Mul(dy, sn)), cx);
+			y = Add(Add(Mul(dx, sn), Mul(dy, cs)), cy);
+		});
+	}
+
+	template <typename In, typename Out>
+	static void RotateEach(const In& in, const Out& out, int count, const float* angles, Precision precision)
+	{
+		Map(in, out, count, [&](int i, int n, Vec& x, Vec& y)
+		{
+			const Vec a = LoadFloats(angles + i, n);
+			Vec cs, sn;
+			if (precision == Precision::FAST)
+			{
+				sn = SinLanes(a);
+				cs = SinLanes(Add(ReduceLanes(a), Splat(1.57079633f)));
+			}
+			else
+			{
+				float c[LANES], s[LANES], t[LANES];
+				Store(t, a);
+				for (int k = 0; k < LANES; k++) { c[k] = cosf(t[k]); s[k] = sinf(t[k]); }
+				cs = Load(c);
+				sn = Load(s);
+			}
+
+			const Vec rx = Sub(Mul(x, cs), Mul(y, sn));
+			y = Add(Mul(x, sn), Mul(y, cs));
+			x = rx;
+		});
+	}
+
+	template <typename In, typename Out>
+	static void NormalizePoints(const In& in, const Out& out, int count, Precision precision)
+	{
+		const Vec zero = Splat(0.f);
+		Map(in, out, count, [&](int, int, Vec& x, Vec& y)
+		{
+			const Vec sq = Add(Mul(x, x), Mul(y, y));
+			const Mask nonzero = Greater(sq, zero);
+			if (precision == Precision::FAST)
+			{
+				const Vec inv = FastRsqrt(sq);
+				x = And(nonzero, Mul(x, inv));
+				y = And(nonzero, Mul(y, inv));
+			}
+			else
+			{
+				const Vec size = Sqrt(sq);
+				x = And(nonzero, Div(x, size));
+				y = And(nonzero, Div(y, size));
+			}
+		});
+	}
+
+	template <typename A, typename B>
+	static void DotPoints(const A& a, const B& b, float* out, int count)
+	{
+		for (int i = 0; i < count; i += LANES)
+		{
+			const int n = std::min(LANES, count - i);
+			Vec ax, ay, bx, by;
+			a.Load(i, n, ax, ay);
+			b.Load(i, n, bx, by);
+			StoreFloats(out + i, n, Add(Mul(ax, bx), Mul(ay, by)));
+		}
+	}
+
+	template <typename In>
+	static void LengthPoints(const In& in, float* out, int count, Precision precision)
+	{
+		const Vec zero = Splat(0.f);
+		Reduce(in, out, count, [&](Vec x, Vec y)
+		{
+			const Vec sq = Add(Mul(x, x), Mul(y, y));
+			return precision == Precision::FAST ? And(Greater(sq, zero), Mul(sq, FastRsqrt(sq))) : Sqrt(sq);
+		});
+	}
+
+	template <typename A, typename B, typename Out>
+	static void LerpPoints(const A& a, const B& b, const Out& out, int count, float t)
+	{
+		const Vec vt = Splat(t);
+		Map2(a, b, out, count, [&](Vec& ax, Vec& ay, Vec bx, Vec by)
+		{
+			ax = Add(ax, Mul(Sub(bx, ax), vt));
+			ay = Add(ay, Mul(Sub(by, ay), vt));
+		});
+	}
+
+	template <typename In, typename Out>
+	static void TransformPoints(const In& in, const Out& out, int count, const Transform2D& t)
+	{
+		const Vec a = Splat(t.a), b = Splat(t.b), c = Splat(t.c), d = Splat(t.d), tx = Splat(t.tx), ty = Splat(t.ty);
+		Map(in, out, count, [&](int, int, Vec& x, Vec& y)
+		{
+			const Vec rx = Add(Add(Mul(a, x), Mul(c, y)), tx);
+			y = Add(Add(Mul(b, x), Mul(d, y)), ty);
+			x = rx;
+		});
+	}
+
+#pragma endregion
+
+#pragma region Arrays of FPoint
+
+	void Add(FPoint* points, int count, const FPoint& offset) { AddOffset(AoSIn{ points }, AoSOut{ points }, count, offset); }
+	void Add(FPoint* dst, const FPoint* a, const FPoint* b, int count) { AddPoints(AoSIn{ a }, AoSIn{ b }, AoSOut{ dst }, count); }
+	void Scale(FPoint* points, int count, const FPoint& factor) { ScalePoints(AoSIn{ points }, AoSOut{ points }, count, factor); }
+	void Rotate(FPoint* points, int count, float angle, const FPoint& centre) { RotateAll(AoSIn{ points }, AoSOut{ points }, count, angle, centre); }
+	void Rotate(FPoint* points, const float* angles, int count, Precision precision) { RotateEach(AoSIn{ points }, AoSOut{ points }, count, angles, precision); }
+	void Normalize(FPoint* points, int count, Precision precision) { NormalizePoints(AoSIn{ points }, AoSOut{ points }, count, precision); }
+	void Dot(const FPoint* a, const FPoint* b, float* out, int count) { DotPoints(AoSIn{ a }, AoSIn{ b }, out, count); }
+	void Length(const FPoint* points, float* out, int count, Precision precision) { LengthPoints(AoSIn{ points }, out, count, precision); }
+	void Lerp(FPoint* dst, const FPoint* a, const FPoint* b, float t, int count) { LerpPoints(AoSIn{ a }, AoSIn{ b }, AoSOut{ dst }, count, t); }
+	void Transform(FPoint* dst, const FPoint* src, int count, const Transform2D& transform) { TransformPoints(AoSIn{ src }, AoSOut{ dst }, count, transform); }
+
+#pragma endregion
+
+#pragma region PointSoA
+
+	void Add(PointSoA& points, const FPoint& offset) { AddOffset(SoAIn(points), SoAOut(points, points.Size()), points.Size(), offset); }
+	void Add(PointSoA& dst, const PointSoA& a, const PointSoA& b) { AddPoints(SoAIn(a), SoAIn(b), SoAOut(dst, a.Size()), a.Size()); }
+	void Scale(PointSoA& points, const FPoint& factor) { ScalePoints(SoAIn(points), SoAOut(points, points.Size()), points.Size(), factor); }
+	void Rotate(PointSoA& points, float angle, const FPoint& centre) { RotateAll(SoAIn(points), SoAOut(points, points.Size()), points.Size(), angle, centre); }
+	void Rotate(PointSoA& points, const float* angles, Precision precision) { RotateEach(SoAIn(points), SoAOut(points, points.Size()), points.Size(), angles, precision); }
+	void Normalize(PointSoA& points, Precision precision) { NormalizePoints(SoAIn(points), SoAOut(points, points.Size()), points.Size(), precision); }
+	void Dot(const PointSoA& a, const PointSoA& b, float* out) { DotPoints(SoAIn(a), SoAIn(b), out, a.Size()); }
+	void Length(const PointSoA& points, float* out, Precision precision) { LengthPoints(SoAIn(points), out, points.Size(), precision); }
+	void Lerp(PointSoA& dst, const PointSoA& a, const PointSoA& b, float t) { LerpPoints(SoAIn(a), SoAIn(b), SoAOut(dst, a.Size()), a.Size(), t); }
+	void Transform(PointSoA& dst, const PointSoA& src, const Transform2D& transform) { TransformPoints(SoAIn(src), SoAOut(dst, src.Size()), src.Size(), transform); }
+
+#pragma endregion
+}
+}
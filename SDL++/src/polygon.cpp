@@ -0,0 +1,369 @@
+#include "polygon.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace SDL
+{
+#pragma region Helpers
+
+	// Positive if b is clockwise of a on screen (with y pointing down)
+	static inline float Cross(const FPoint& a, const FPoint& b) { return a.x * b.y - a.y * b.x; }
+
+	// The unit normal facing out of an edge of a polygon going clockwise on screen
+	static inline FPoint EdgeNormal(const FPoint& from, const FPoint& to)
+	{
+		const FPoint e = to - from;
+		const float len = std::sqrt(e.x * e.x + e.y * e.y);
+		return len > 0 ? FPoint(e.y / len, -e.x / len) : FPoint(0, 0);
+	}
+
+	static float SignedArea(const FPoint* points, int count)
+	{
+		float sum = 0;
+		for (int i = 0, j = count - 1; i < count; j = i++) sum += Cross(points[j], points[i]);
+		return sum * 0.5f;
+	}
+
+	static FRect Bounds(const FPoint* points, int count)
+	{
+		if (count == 0) return FRect(0, 0, 0, 0);
+
+		FPoint lo = points[0], hi = points[0];
+		for (int i = 1; i < count; i++)
+		{
+			lo = FPoint::min(lo, points[i]);
+			hi = FPoint::max(hi, points[i]);
+		}
+		return FRect(lo, hi - lo);
+	}
+
+	// Add the hull points strictly right of the line from a to b (outside the hull found so far), between a and b
+	static void QuickHull(const FPoint* points, const std::vector<int>& candidates, const FPoint& a, const FPoint& b, std::vector<FPoint>& hull)
+	{
+		if (candidates.empty()) return;
+
+		const FPoint ab = b - a;
+
+		// The furthest point from the line must be on the hull. Of several equally far, take the one furthest towards
+		// b, so the others end up on a line with it and are left out further down.
+		int furthest = candidates[0];
+		float best = 0, along = 0;
+		for (int i : candidates)
+		{
+			const float d = Cross(points[i] - a, ab);
+			const float t = FPoint::dot(points[i] - a, ab);
+			if (d > best || (d == best && t > along))
+			{
+				best = d;
+				along = t;
+				furthest = i;
+			}
+		}
+
+		const FPoint c = points[furthest];
+
+		// Anything inside the triangle abc is not, leaving what is beyond ac and beyond cb
+		std::vector<int> left, right;
+		for (int i : candidates)
+		{
+			if (Cross(points[i] - a, c - a) > 0) left.push_back(i);
+			else if (Cross(points[i] - c, b - c) > 0) right.push_back(i);
+		}
+
+		QuickHull(points, left, a, c, hull);
+		hull.push_back(c);
+		QuickHull(points, right, c, b, hull);
+	}
+
+#pragma endregion
+
+#pragma region Polygon
+
+	float Polygon::SignedArea() const { return SDL::SignedArea(points.data(), Size()); }
+
+	FRect Polygon::Bounds() const { return SDL::Bounds(points.data(), Size()); }
+
+	bool Polygon::Contains(const FPoint& point) const
+	{
+		// Count the edges crossed by a line from the point out to the right
+		bool inside = false;
+		for (int i = 0, j = Size() - 1; i < Size(); j = i++)
+		{
+			const FPoint& a = points[i];
+			const FPoint& b = points[j];
+			if ((a.y > point.y) != (b.y > point.y) && point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x) inside = !inside;
+		}
+		return inside;
+	}
+
+	Ray::Contact Polygon::Intersect(const Ray& ray) const
+	{
+		Ray::Contact hit;
+		if (Size() < 2 || !ray.dir.nonZero()) return hit;
+
+		const float turn = SignedArea() < 0 ? -1.f : 1.f;
+		float best = std::numeric_limits<float>::infinity();
+
+		for (int i = 0, j = Size() - 1; i < Size(); j = i++)
+		{
+			const FPoint& a = points[j];
+			const FPoint e = points[i] - a;
+
+			const float denom = Cross(ray.dir, e);
+			if (denom == 0) continue; // Parallel
+
+			const FPoint ao = a - ray.origin;
+			const float t = Cross(ao, e) / denom;
+			const float u = Cross(ao, ray.dir) / denom;
+			if (t < 0 || t > 1 || u < 0 || u > 1 || t >= best) continue;
+
+			best = t;
+			hit.normal = EdgeNormal(a, points[i]) * turn;
+		}
+
+		if (best > 1) return hit;
+
+		if (FPoint::dot(hit.normal, ray.dir) > 0) hit.normal = -hit.normal;
+		hit.contact = true;
+		hit.time = best;
+		hit.point = ray.origin + ray.dir * best;
+		return hit;
+	}
+
+	ConvexPolygon Polygon::Hull() const { return ConvexPolygon::Hull(points.data(), Size()); }
+
+#pragma endregion
+
+#pragma region ConvexPolygon
+
+	ConvexPolygon::ConvexPolygon(const FPoint* points, int count) { Set(points, count); }
+
+	ConvexPolygon::ConvexPolygon(const FRect& rect)
+	{
+		const FPoint corners[4] = { rect.pos, rect.pos + FPoint(rect.w, 0), rect.pos + rect.size, rect.pos + FPoint(0, rect.h) };
+		Set(corners, 4);
+	}
+
+	ConvexPolygon ConvexPolygon::Hull(const FPoint* points, int count)
+	{
+		if (count <= 0) return ConvexPolygon();
+
+		// The leftmost and rightmost points are always on the hull
+		int lo = 0, hi = 0;
+		for (int i = 1; i < count; i++)
+		{
+			if (points[i].x < points[lo].x || (points[i].x == points[lo].x && points[i].y < points[lo].y)) lo = i;
+			if (points[i].x > points[hi].x || (points[i].x == points[hi].x && points[i].y > points[hi].y)) hi = i;
+		}
+
+		const FPoint a = points[lo], b = points[hi];
+		if (a == b) return ConvexPolygon(&a, 1);
+
+		std::vector<int> above, below;
+		for (int i = 0; i < count; i++)
+		{
+			const float side = Cross(points[i] - a, b - a);
+			if (side > 0) above.push_back(i);
+			else if (side < 0) below.push_back(i);
+		}
+
+		// Going clockwise on screen: along the top from a to b, then back along the bottom
+		std::vector<FPoint> hull;
+		hull.push_back(a);
+		QuickHull(points, above, a, b, hull);
+		hull.push_back(b);
+		QuickHull(points, below, b, a, hull);
+
+		return ConvexPolygon(hull);
+	}
+
+	ConvexPolygon ConvexPolygon::Box(const FPoint& centre, const FPoint& size, float angle)
+	{
+		const float c = std::cos(angle), s = std::sin(angle);
+		const FPoint half = size * 0.5f;
+
+		const FPoint corners[4] =
+		{
+			centre + FPoint(-half.x, -half.y).rotate(c, s),
+			centre + FPoint( half.x, -half.y).rotate(c, s),
+			centre + FPoint( half.x,  half.y).rotate(c, s),
+			centre + FPoint(-half.x,  half.y).rotate(c, s),
+		};
+		return ConvexPolygon(corners, 4);
+	}
+
+	void ConvexPolygon::Set(const FPoint* src, int count)
+	{
+		points.clear();
+		for (int i = 0; i < count; i++)
+			if (points.empty() || src[i] != points.back()) points.push_back(src[i]);
+
+		while (points.size() > 1 && points.back() == points.front()) points.pop_back();
+
+		if (SDL::SignedArea(points.data(), Size()) < 0) std::reverse(points.begin(), points.end());
+
+		normals.resize(points.size());
+		for (int i = 0; i < Size(); i++) normals[i] = EdgeNormal(points[i], points[(i + 1) % Size()]);
+
+		bounds = SDL::Bounds(points.data(), Size());
+	}
+
+	ConvexPolygon& ConvexPolygon::Transform(const Transform2D& transform)
+	{
+		std::vector<FPoint> moved(points.size());
+		for (size_t i = 0; i < points.size(); i++) moved[i] = transform.apply(points[i]);
+
+		// Normals do not follow scaling or shearing, so work them out again
+		Set(moved.data(), (int)moved.size());
+		return *this;
+	}
+
+	ConvexPolygon& ConvexPolygon::Translate(const FPoint& offset)
+	{
+		for (FPoint& p : points) p += offset;
+		bounds.pos += offset;
+		return *this;
+	}
+
+	float ConvexPolygon::Area() const { return SDL::SignedArea(points.data(), Size()); }
+
+	FPoint ConvexPolygon::Centroid() const
+	{
+		if (points.empty()) return FPoint(0, 0);
+
+		FPoint sum(0, 0);
+		float area = 0;
+		for (int i = 0, j = Size() - 1; i < Size(); j = i++)
+		{
+			const float c = Cross(points[j], points[i]);
+			sum += (points[j] + points[i]) * c;
+			area += c;
+		}
+
+		if (area != 0) return sum / (area * 3);
+
+		// No area, so just average the vertices
+		sum = FPoint(0, 0);
+		for (const FPoint& p : points) sum += p;
+		return sum / (float)Size();
+	}
+
+	FPoint ConvexPolygon::Support(const FPoint& dir) const
+	{
+		int best = 0;
+		float most = -std::numeric_limits<float>::infinity();
+		for (int i = 0; i < Size(); i++)
+		{
+			const float d = FPoint::dot(points[i], dir);
+			if (d > most)
+			{
+				most = d;
+				best = i;
+			}
+		}
+		return points.empty() ? FPoint(0, 0) : points[best];
+	}
+
+	bool ConvexPolygon::Contains(const FPoint& point) const
+	{
+		if (Size() < 3) return false;
+
+		for (int i = 0; i < Size(); i++)
+			if (FPoint::dot(normals[i], point - points[i]) >= 0) return false;
+
+		return true;
+	}
+
+	Ray::Contact ConvexPolygon::Intersect(const Ray& ray) const
+	{
+		Ray::Contact hit;
+		if (Size() < 3 || !ray.dir.nonZero()) return hit;
+
+		// Clip the ray against each edge's half plane in turn (Cyrus-Beck)
+		float enter = -std::numeric_limits<float>::infinity(), exit = std::numeric_limits<float>::infinity();
+		int enterEdge = -1, exitEdge = -1;
+
+		for (int i = 0; i < Size(); i++)
+		{
+			const float num = FPoint::dot(normals[i], points[i] - ray.origin); // Negative if the origin is outside this edge
+			const float den = FPoint::dot(normals[i], ray.dir);
+
+			if (den == 0)
+			{
+				if (num < 0) return hit; // Parallel, and outside
+				continue;
+			}
+
+			const float t = num / den;
+			if (den < 0)
+			{
+				if (t > enter) { enter = t; enterEdge = i; }
+			}
+			else if (t < exit) { exit = t; exitEdge = i; }
+
+			if (enter > exit) return hit;
+		}
+
+		if (enter >= 0)
+		{
+			if (enter > 1) return hit;
+			hit.time = enter;
+			hit.normal = normals[enterEdge];
+		}
+		else
+		{
+			// Starting inside, so report where the ray leaves
+			if (exit < 0 || exit > 1) return hit;
+			hit.time = exit;
+			hit.normal = -normals[exitEdge];
+		}
+
+		hit.contact = true;
+		hit.point = ray.origin + ray.dir * hit.time;
+		return hit;
+	}
+
+	bool ConvexPolygon::Overlaps(const ConvexPolygon& other, FPoint* mtv) const
+	{
+		if (Size() < 3 || other.Size() < 3 || !RectsIntersect(bounds, other.bounds)) return false;
+
+		float depth = std::numeric_limits<float>::infinity();
+		FPoint axis(0, 0);
+
+		// Test along the normals of one polygon, whose own furthest extent along each is the edge it belongs to
+		auto separated = [&](const ConvexPolygon& owner, const ConvexPolygon& against, float sign)
+		{
+			for (int i = 0; i < owner.Size(); i++)
+			{
+				const FPoint& n = owner.normals[i];
+				const float ownerMax = FPoint::dot(n, owner.points[i]);
+
+				float againstMin = std::numeric_limits<float>::infinity();
+				for (const FPoint& p : against.points) againstMin = std::min(againstMin, FPoint::dot(n, p));
+
+				// How far the other polygon reaches past this edge. These are the faces of the Minkowski difference
+				// of the two polygons, so the polygons are apart if any is not positive, and the smallest is exactly
+				// the shortest way out.
+				const float overlap = ownerMax - againstMin;
+				if (overlap <= 0) return true;
+
+				if (overlap < depth)
+				{
+					depth = overlap;
+					axis = n * sign;
+				}
+			}
+			return false;
+		};
+
+		// For this polygon's normals, this is moved back against n; for the other's, it is moved along n
+		if (separated(*this, other, -1.f) || separated(other, *this, 1.f)) return false;
+
+		if (mtv) *mtv = axis * depth;
+		return true;
+	}
+
+#pragma endregion
+}
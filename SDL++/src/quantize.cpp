@@ -0,0 +1,492 @@
+#include "quantize.hpp"
+#include "parallel.hpp"
+#include "pixelops.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace SDL
+{
+namespace Quantize
+{
+#pragma region Histogram
+
+	// A distinct colour, in Colour channel order, and the number of pixels using it
+	struct Entry
+	{
+		Uint8 c[4];
+		Uint32 count;
+	};
+
+	// Get a surface's pixels as RGBA32, whose bytes are in Colour channel order
+	static Surface AsRGBA(const Surface& surface)
+	{
+		if (!surface.surface)
+		{
+			SDL_SetError("Parameter 'surface' is invalid");
+			return Surface::FromPtr(NULL);
+		}
+
+		if (surface.surface->format->format == SDL_PIXELFORMAT_RGBA32) return surface;
+		return Surface::FromPtr(SDL_ConvertSurfaceFormat(surface.surface.get(), SDL_PIXELFORMAT_RGBA32, 0));
+	}
+
+	// Fully transparent pixels all become (0, 0, 0, 0)
+	static inline Uint32 Normalise(Uint32 p)
+	{
+		Uint8 c[4];
+		std::memcpy(c, &p, 4);
+		return c[3] == 0 ? 0 : p;
+	}
+
+	// Count the distinct colours of an RGBA32 surface
+	static std::vector<Entry> Histogram(SDL_Surface* s)
+	{
+		std::vector<Uint32> pixels;
+		pixels.reserve((size_t)s->w * s->h);
+		for (int y = 0; y < s->h; y++)
+		{
+			const Uint32* row = Row<const Uint32>(s, y);
+			for (int x = 0; x < s->w; x++) pixels.push_back(Normalise(row[x]));
+		}
+
+		std::sort(pixels.begin(), pixels.end());
+
+		std::vector<Entry> entries;
+		for (size_t i = 0; i < pixels.size();)
+		{
+			size_t j = i + 1;
+			while (j < pixels.size() && pixels[j] == pixels[i]) j++;
+
+			Entry e;
+			std::memcpy(e.c, &pixels[i], 4);
+			e.count = (Uint32)(j - i);
+			entries.push_back(e);
+			i = j;
+		}
+
+		return entries;
+	}
+
+#pragma endregion
+
+#pragma region Median Cut
+
+	// A range of histogram entries which becomes one palette colour
+	struct Box
+	{
+		size_t begin, end;
+		int axis;     // The channel with the greatest variance
+		double error; // The total squared distance of the box's pixels from their mean
+	};
+
+	static void Measure(Box& box, const std::vector<Entry>& entries)
+	{
+		Uint64 count = 0;
+		double sum[4] = { 0, 0, 0, 0 }, sqr[4] = { 0, 0, 0, 0 };
+
+		for (size_t i = box.begin; i < box.end; i++)
+		{
+			const Entry& e = entries[i];
+			count += e.count;
+			for (int c = 0; c < 4; c++)
+			{
+				sum[c] += (double)e.c[c] * e.count;
+				sqr[c] += (double)e.c[c] * e.c[c] * e.count;
+			}
+		}
+
+		box.axis = 0;
+		box.error = 0;
+		double best = -1;
+		for (int c = 0; c < 4; c++)
+		{
+			const double variance = sqr[c] - sum[c] * sum[c] / (double)count;
+			box.error += variance;
+			if (variance > best)
+			{
+				best = variance;
+				box.axis = c;
+			}
+		}
+
+		if (box.end - box.begin < 2) box.error = 0;
+	}
+
+	static Colour Mean(const Entry* begin, const Entry* end)
+	{
+		Uint64 count = 0, sum[4] = { 0, 0, 0, 0 };
+		for (const Entry* e = begin; e != end; e++)
+		{
+			count += e->count;
+			for (int c = 0; c < 4; c++) sum[c] += (Uint64)e->c[c] * e->count;
+		}
+
+		if (count == 0) return { 0, 0, 0, 0 };
+		return {
+			(Uint8)((sum[0] + count / 2) / count),
+			(Uint8)((sum[1] + count / 2) / count),
+			(Uint8)((sum[2] + count / 2) / count),
+			(Uint8)((sum[3] + count / 2) / count)
+		};
+	}
+
+	static std::vector<Colour> MedianCut(std::vector<Entry>& entries, int ncolours)
+	{
+		std::vector<Box> boxes;
+		boxes.push_back({ 0, entries.size(), 0, 0 });
+		Measure(boxes[0], entries);
+
+		while ((int)boxes.size() < ncolours)
+		{
+			// Split the box contributing the most error
+			const auto worst = std::max_element(boxes.begin(), boxes.end(), [](const Box& a, const Box& b) { return a.error < b.error; });
+			if (worst->error <= 0) break;
+
+			Box box = *worst;
+			const int axis = box.axis;
+			std::sort(entries.begin() + box.begin, entries.begin() + box.end, [axis](const Entry& a, const Entry& b) { return a.c[axis] < b.c[axis]; });
+
+			Uint64 total = 0, running = 0;
+			for (size_t i = box.begin; i < box.end; i++) total += entries[i].count;
+
+			size_t mid = box.begin + 1;
+			for (size_t i = box.begin; i < box.end - 1; i++)
+			{
+				running += entries[i].count;
+				mid = i + 1;
+				if (running * 2 >= total) break;
+			}
+
+			Box lo = { box.begin, mid, 0, 0 };
+			Box hi = { mid, box.end, 0, 0 };
+			Measure(lo, entries);
+			Measure(hi, entries);
+			*worst = lo;
+			boxes.push_back(hi);
+		}
+
+		std::vector<Colour> colours;
+		colours.reserve(boxes.size());
+		for (const Box& box : boxes) colours.push_back(Mean(entries.data() + box.begin, entries.data() + box.end));
+		return colours;
+	}
+
+#pragma endregion
+
+#pragma region Nearest Colour
+
+	static inline int Distance(const int a[4], const Uint8 b[4])
+	{
+		const int d0 = a[0] - b[0], d1 = a[1] - b[1], d2 = a[2] - b[2], d3 = a[3] - b[3];
+		return d0 * d0 + d1 * d1 + d2 * d2 + d3 * d3;
+	}
+
+	// A k-d tree over palette colours, for finding the nearest entry to any colour
+	class ColourTree
+	{
+		struct Node
+		{
+			Uint8 c[4];
+			Uint8 index;
+			Uint8 axis;
+			Sint16 left, right;
+		};
+
+		std::vector<Node> nodes;
+
+		int Build(std::vector<Node>& items, int begin, int end)
+		{
+			if (begin >= end) return -1;
+
+			// Split on the channel with the widest spread
+			int lo[4] = { 255, 255, 255, 255 }, hi[4] = { 0, 0, 0, 0 };
+			for (int i = begin; i < end; i++)
+				for (int c = 0; c < 4; c++)
+				{
+					lo[c] = std::min(lo[c], (int)items[i].c[c]);
+					hi[c] = std::max(hi[c], (int)items[i].c[c]);
+				}
+
+			int axis = 0;
+			for (int c = 1; c < 4; c++) if (hi[c] - lo[c] > hi[axis] - lo[axis]) axis = c;
+
+			const int mid = (begin + end) / 2;
+			std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end, [axis](const Node& a, const Node& b) { return a.c[axis] < b.c[axis]; });
+
+			const int node = (int)nodes.size();
+			nodes.push_back(items[mid]);
+			nodes[node].axis = (Uint8)axis;
+			const int left = Build(items, begin, mid);
+			const int right = Build(items, mid + 1, end);
+			nodes[node].left = (Sint16)left;
+			nodes[node].right = (Sint16)right;
+			return node;
+		}
+
+		void Search(int node, const int c[4], int& best, int& bestDist) const
+		{
+			if (node < 0) return;
+
+			const Node& n = nodes[node];
+			const int d = Distance(c, n.c);
+			if (d < bestDist)
+			{
+				bestDist = d;
+				best = n.index;
+			}
+
+			// Only look on the far side of the split if it could hold something closer
+			const int delta = c[n.axis] - n.c[n.axis];
+			Search(delta < 0 ? n.left : n.right, c, best, bestDist);
+			if (delta * delta < bestDist) Search(delta < 0 ? n.right : n.left, c, best, bestDist);
+		}
+
+	public:
+		ColourTree(const SDL_Palette* palette)
+		{
+			std::vector<Node> items(palette->ncolors);
+			for (int i = 0; i < palette->ncolors; i++)
+			{
+				const Colour& col = palette->colors[i];
+				items[i] = { { col.r, col.g, col.b, col.a }, (Uint8)i, 0, -1, -1 };
+			}
+
+			nodes.reserve(items.size());
+			Build(items, 0, (int)items.size());
+		}
+
+		// The index of the palette colour nearest to c, whose channels are in Colour order
+		int Nearest(const int c[4]) const
+		{
+			int best = 0, bestDist = INT_MAX;
+			Search(0, c, best, bestDist);
+			return best;
+		}
+
+		inline int Nearest(const Uint8 c[4]) const
+		{
+			const int v[4] = { c[0], c[1], c[2], c[3] };
+			return Nearest(v);
+		}
+	};
+
+	// A direct mapped cache of recent lookups, as images tend to repeat colours
+	class NearestCache
+	{
+		static constexpr int BITS = 12;
+
+		const ColourTree& tree;
+		std::vector<Uint64> keys; // Empty slots hold a key no pixel can match
+		std::vector<Uint8> values;
+
+	public:
+		NearestCache(const ColourTree& tree)
+			: tree(tree), keys(1 << BITS, ~(Uint64)0), values(1 << BITS, 0) {}
+
+		static inline size_t Slot(Uint32 key) { return (key * 2654435761u) >> (32 - BITS); }
+
+		inline Uint8 Nearest(Uint32 pixel)
+		{
+			const size_t slot = Slot(pixel);
+			if (keys[slot] != pixel)
+			{
+				Uint8 c[4];
+				std::memcpy(c, &pixel, 4);
+				keys[slot] = pixel;
+				values[slot] = (Uint8)tree.Nearest(c);
+			}
+			return values[slot];
+		}
+	};
+
+#pragma endregion
+
+#pragma region K-Means
+
+	static void KMeans(const std::vector<Entry>& entries, std::vector<Colour>& colours, int iterations)
+	{
+		struct Sum { Uint64 c[4], count; };
+
+		std::vector<Sum> sums(colours.size());
+		std::mutex merge;
+
+		for (int it = 0; it < iterations; it++)
+		{
+			Palette palette((int)colours.size());
+			if (palette.palette == nullptr) return;
+			palette.SetColours(colours.data(), 0, (int)colours.size());
+			const ColourTree tree(palette.palette.get());
+
+			std::fill(sums.begin(), sums.end(), Sum{ { 0, 0, 0, 0 }, 0 });
+
+			ParallelFor((int)entries.size(), [&](int begin, int end)
+			{
+				std::vector<Sum> local(colours.size(), Sum{ { 0, 0, 0, 0 }, 0 });
+				for (int i = begin; i < end; i++)
+				{
+					const Entry& e = entries[i];
+					Sum& s = local[tree.Nearest(e.c)];
+					for (int c = 0; c < 4; c++) s.c[c] += (Uint64)e.c[c] * e.count;
+					s.count += e.count;
+				}
+
+				std::lock_guard<std::mutex> lock(merge);
+				for (size_t i = 0; i < sums.size(); i++)
+				{
+					for (int c = 0; c < 4; c++) sums[i].c[c] += local[i].c[c];
+					sums[i].count += local[i].count;
+				}
+			}, 4096);
+
+			// Move each colour to the mean of its pixels; colours with no pixels stay put
+			bool moved = false;
+			for (size_t i = 0; i < colours.size(); i++)
+			{
+				const Sum& s = sums[i];
+				if (s.count == 0) continue;
+
+				const Colour next = {
+					(Uint8)((s.c[0] + s.count / 2) / s.count),
+					(Uint8)((s.c[1] + s.count / 2) / s.count),
+					(Uint8)((s.c[2] + s.count / 2) / s.count),
+					(Uint8)((s.c[3] + s.count / 2) / s.count)
+				};
+
+				moved |= next != colours[i];
+				colours[i] = next;
+			}
+
+			if (!moved) break;
+		}
+	}
+
+#pragma endregion
+
+	Palette GeneratePalette(const Surface& surface, int ncolours, Method method, int iterations)
+	{
+		if (ncolours < 1 || ncolours > 256)
+		{
+			SDL_SetError("Palettes for INDEX8 surfaces need 1 to 256 colours");
+			return Palette::FromPtr(NULL);
+		}
+
+		Surface rgba = AsRGBA(surface);
+		if (!rgba.surface || SDL_LockSurface(rgba.surface.get()) != 0) return Palette::FromPtr(NULL);
+		std::vector<Entry> entries = Histogram(rgba.surface.get());
+		SDL_UnlockSurface(rgba.surface.get());
+
+		if (entries.empty())
+		{
+			SDL_SetError("Cannot generate a palette for an empty surface");
+			return Palette::FromPtr(NULL);
+		}
+
+		std::vector<Colour> colours = MedianCut(entries, ncolours);
+		if (method == Method::KMEANS) KMeans(entries, colours, iterations);
+
+		Palette palette((int)colours.size());
+		if (palette.palette == nullptr || !palette.SetColours(colours.data(), 0, (int)colours.size())) return Palette::FromPtr(NULL);
+		return palette;
+	}
+
+	Surface ToIndexed(const Surface& surface, const Palette& palette, bool dither)
+	{
+		if (palette.palette == nullptr || palette.palette->ncolors < 1)
+		{
+			SDL_SetError("Parameter 'palette' is invalid");
+			return Surface::FromPtr(NULL);
+		}
+
+		Surface rgba = AsRGBA(surface);
+		if (!rgba.surface) return Surface::FromPtr(NULL);
+
+		SDL_Surface* s = rgba.surface.get();
+		Surface result(s->w, s->h, SDL_PIXELFORMAT_INDEX8);
+		if (!result.surface) return Surface::FromPtr(NULL);
+		if (SDL_SetSurfacePalette(result.surface.get(), palette.palette.get()) != 0) return Surface::FromPtr(NULL);
+
+		SDL_BlendMode blendMode = SDL_BLENDMODE_NONE;
+		SDL_GetSurfaceBlendMode(surface.surface.get(), &blendMode);
+		SDL_SetSurfaceBlendMode(result.surface.get(), blendMode);
+		result.SetPremultiplied(surface.IsPremultiplied());
+
+		if (SDL_LockSurface(s) != 0) return Surface::FromPtr(NULL);
+
+		const ColourTree tree(palette.palette.get());
+		const int transparent[4] = { 0, 0, 0, 0 };
+		const Uint8 clear = (Uint8)tree.Nearest(transparent);
+		SDL_Surface* d = result.surface.get();
+
+		if (!dither)
+		{
+			ParallelFor(s->h, [&](int begin, int end)
+			{
+				NearestCache cache(tree);
+				for (int y = begin; y < end; y++)
+				{
+					const Uint32* in = Row<const Uint32>(s, y);
+					Uint8* out = Row<Uint8>(d, y);
+					for (int x = 0; x < s->w; x++) out[x] = cache.Nearest(Normalise(in[x]));
+				}
+			});
+		}
+		else
+		{
+			// Errors are stored in sixteenths, with a pixel of padding at both ends of the row
+			const SDL_Colour* colours = palette.palette->colors;
+			std::vector<int> current(((size_t)s->w + 2) * 4, 0), next(current.size(), 0);
+
+			for (int y = 0; y < s->h; y++)
+			{
+				const Uint8* in = Row<const Uint8>(s, y);
+				Uint8* out = Row<Uint8>(d, y);
+				const bool reverse = y & 1;
+				const int dir = reverse ? -1 : 1;
+				std::fill(next.begin(), next.end(), 0);
+
+				for (int i = 0; i < s->w; i++)
+				{
+					const int x = reverse ? s->w - 1 - i : i;
+					int* err = current.data() + (size_t)(x + 1) * 4;
+
+					// Transparent pixels absorb no error, so dithering does not speckle them
+					if (in[x * 4 + 3] == 0)
+					{
+						out[x] = clear;
+						continue;
+					}
+
+					int c[4];
+					for (int k = 0; k < 4; k++) c[k] = std::clamp(in[x * 4 + k] + (err[k] >> 4), 0, 255);
+
+					const int index = tree.Nearest(c);
+					out[x] = (Uint8)index;
+
+					const Colour& p = colours[index];
+					const int e[4] = { c[0] - p.r, c[1] - p.g, c[2] - p.b, c[3] - p.a };
+
+					int* ahead = err + dir * 4;
+					int* below = next.data() + (size_t)(x + 1) * 4;
+					for (int k = 0; k < 4; k++)
+					{
+						ahead[k] += e[k] * 7;
+						below[k - dir * 4] += e[k] * 3;
+						below[k] += e[k] * 5;
+						below[k + dir * 4] += e[k];
+					}
+				}
+
+				std::swap(current, next);
+			}
+		}
+
+		SDL_UnlockSurface(s);
+
+		return result;
+	}
+}
+}
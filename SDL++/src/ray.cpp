@@ -0,0 +1,267 @@
+#include "ray.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+
+namespace SDL
+{
+#pragma region Helpers
+
+	// A ray's origin and the reciprocal of its direction. An axis the ray does not move along gets a huge reciprocal,
+	// so its slab spans every time if the origin lies between the rectangle's edges and no time otherwise
+	struct Slabs
+	{
+		float ox, oy;
+		float ix, iy;
+	};
+
+	static Slabs Prepare(const Ray& ray)
+	{
+		const float huge = 1e30f;
+		return {
+			ray.origin.x, ray.origin.y,
+			ray.dir.x != 0 ? 1.f / ray.dir.x : huge,
+			ray.dir.y != 0 ? 1.f / ray.dir.y : huge
+		};
+	}
+
+	// Slab test one rectangle, giving the times the ray enters each axis's slab if it passes through the rectangle
+	static bool TestRect(const Slabs& s, const RectSoA& rects, int i, float& nearX, float& nearY)
+	{
+		const float w = rects.w[i], h = rects.h[i];
+		if (!(w > 0 && h > 0)) return false;
+
+		const float x1 = (rects.x[i] - s.ox) * s.ix, x2 = (rects.x[i] + w - s.ox) * s.ix;
+		const float y1 = (rects.y[i] - s.oy) * s.iy, y2 = (rects.y[i] + h - s.oy) * s.iy;
+
+		nearX = std::min(x1, x2);
+		nearY = std::min(y1, y2);
+		const float tmin = std::max(nearX, nearY);
+		const float tmax = std::min(std::max(x1, x2), std::max(y1, y2));
+
+		return tmin <= tmax && tmax >= 0 && tmin <= 1;
+	}
+
+	// Slab test every rectangle, a batch at a time, calling hit(index, time) in order of index for each one passed through
+	template <typename F>
+	static void Sweep(const Slabs& s, const RectSoA& rects, F&& hit)
+	{
+		const int n = rects.Padded();
+		const float* X = rects.x.data();
+		const float* Y = rects.y.data();
+		const float* W = rects.w.data();
+		const float* H = rects.h.data();
+		int i = 0;
+
+#if defined(SDLPP_AVX)
+		const __m256 ox = _mm256_set1_ps(s.ox), oy = _mm256_set1_ps(s.oy);
+		const __m256 ix = _mm256_set1_ps(s.ix), iy = _mm256_set1_ps(s.iy);
+		const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f);
+		for (; i + 8 <= n; i += 8)
+		{
+			const __m256 x = _mm256_load_ps(X + i), y = _mm256_load_ps(Y + i);
+			const __m256 w = _mm256_load_ps(W + i), h = _mm256_load_ps(H + i);
+
+			const __m256 x1 = _mm256_mul_ps(_mm256_sub_ps(x, ox), ix);
+			const __m256 x2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(x, w), ox), ix);
+			const __m256 y1 = _mm256_mul_ps(_mm256_sub_ps(y, oy), iy);
+			const __m256 y2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(y, h), oy), iy);
+
+			const __m256 tmin = _mm256_max_ps(_mm256_min_ps(x1, x2), _mm256_min_ps(y1, y2));
+			const __m256 tmax = _mm256_min_ps(_mm256_max_ps(x1, x2), _mm256_max_ps(y1, y2));
+
+			__m256 mask = _mm256_and_ps(_mm256_cmp_ps(w, zero, _CMP_GT_OQ), _mm256_cmp_ps(h, zero, _CMP_GT_OQ));
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(tmin, tmax, _CMP_LE_OQ));
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(tmax, zero, _CMP_GE_OQ));
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(tmin, one, _CMP_LE_OQ));
+
+			const int bits = _mm256_movemask_ps(mask);
+			if (bits == 0) continue;
+
+			alignas(32) float t[8];
+			_mm256_store_ps(t, tmin);
+			for (int b = 0; b < 8; b++)
+				if (bits & (1 << b)) hit(i + b, t[b]);
+		}
+#elif defined(SDLPP_SSE2)
+		const __m128 ox = _mm_set1_ps(s.ox), oy = _mm_set1_ps(s.oy);
+		const __m128 ix = _mm_set1_ps(s.ix), iy = _mm_set1_ps(s.iy);
+		const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f);
+		for (; i + 4 <= n; i += 4)
+		{
+			const __m128 x = _mm_load_ps(X + i), y = _mm_load_ps(Y + i);
+			const __m128 w = _mm_load_ps(W + i), h = _mm_load_ps(H + i);
+
+			const __m128 x1 = _mm_mul_ps(_mm_sub_ps(x, ox), ix);
+			const __m128 x2 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(x, w), ox), ix);
+			const __m128 y1 = _mm_mul_ps(_mm_sub_ps(y, oy), iy);
+			const __m128 y2 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(y, h), oy), iy);
+
+			const __m128 tmin = _mm_max_ps(_mm_min_ps(x1, x2), _mm_min_ps(y1, y2));
+			const __m128 tmax = _mm_min_ps(_mm_max_ps(x1, x2), _mm_max_ps(y1, y2));
+
+			__m128 mask = _mm_and_ps(_mm_cmpgt_ps(w, zero), _mm_cmpgt_ps(h, zero));
+			mask = _mm_and_ps(mask, _mm_cmple_ps(tmin, tmax));
+			mask = _mm_and_ps(mask, _mm_cmpge_ps(tmax, zero));
+			mask = _mm_and_ps(mask, _mm_cmple_ps(tmin, one));
+
+			const int bits = _mm_movemask_ps(mask);
+			if (bits == 0) continue;
+
+			alignas(16) float t[4];
+			_mm_store_ps(t, tmin);
+			for (int b = 0; b < 4; b++)
+				if (bits & (1 << b)) hit(i + b, t[b]);
+		}
+#elif defined(SDLPP_NEON)
+		const float32x4_t ox = vdupq_n_f32(s.ox), oy = vdupq_n_f32(s.oy);
+		const float32x4_t ix = vdupq_n_f32(s.ix), iy = vdupq_n_f32(s.iy);
+		const float32x4_t zero = vdupq_n_f32(0.f), one = vdupq_n_f32(1.f);
+		for (; i + 4 <= n; i += 4)
+		{
+			const float32x4_t x = vld1q_f32(X + i), y = vld1q_f32(Y + i);
+			const float32x4_t w = vld1q_f32(W + i), h = vld1q_f32(H + i);
+
+			const float32x4_t x1 = vmulq_f32(vsubq_f32(x, ox), ix);
+			const float32x4_t x2 = vmulq_f32(vsubq_f32(vaddq_f32(x, w), ox), ix);
+			const float32x4_t y1 = vmulq_f32(vsubq_f32(y, oy), iy);
+			const float32x4_t y2 = vmulq_f32(vsubq_f32(vaddq_f32(y, h), oy), iy);
+
+			const float32x4_t tmin = vmaxq_f32(vminq_f32(x1, x2), vminq_f32(y1, y2));
+			const float32x4_t tmax = vminq_f32(vmaxq_f32(x1, x2), vmaxq_f32(y1, y2));
+
+			uint32x4_t mask = vandq_u32(vcgtq_f32(w, zero), vcgtq_f32(h, zero));
+			mask = vandq_u32(mask, vcleq_f32(tmin, tmax));
+			mask = vandq_u32(mask, vcgeq_f32(tmax, zero));
+			mask = vandq_u32(mask, vcleq_f32(tmin, one));
+
+			const uint32x2_t any = vorr_u32(vget_low_u32(mask), vget_high_u32(mask));
+			if ((vget_lane_u32(any, 0) | vget_lane_u32(any, 1)) == 0) continue;
+
+			Uint32 bits[4];
+			float t[4];
+			vst1q_u32(bits, mask);
+			vst1q_f32(t, tmin);
+			for (int b = 0; b < 4; b++)
+				if (bits[b]) hit(i + b, t[b]);
+		}
+#endif
+
+		for (; i < n; i++)
+		{
+			float nearX, nearY;
+			if (TestRect(s, rects, i, nearX, nearY)) hit(i, std::max(nearX, nearY));
+		}
+	}
+
+	static int FirstHit(const Ray& ray, const RectSoA& rects, Ray::Contact* contact)
+	{
+		if (contact != NULL) *contact = { false };
+		if (ray.dir.x == 0 && ray.dir.y == 0) return -1; // No ray
+
+		const Slabs s = Prepare(ray);
+		int index = -1;
+		float best = 0;
+
+		Sweep(s, rects, [&](int i, float t)
+		{
+			if (index < 0 || t < best)
+			{
+				index = i;
+				best = t;
+			}
+		});
+
+		if (index < 0 || contact == NULL) return index;
+
+		// Work out the normal of the side entered, as IntersectRect() does
+		float nearX, nearY;
+		TestRect(s, rects, index, nearX, nearY);
+
+		contact->contact = true;
+		contact->time = best;
+		contact->point = ray.origin + best * ray.dir;
+		if (nearX >= nearY) contact->normal.x = ray.dir.x < 0 ? 1.f : -1.f;
+		if (nearX <= nearY) contact->normal.y = ray.dir.y < 0 ? 1.f : -1.f;
+
+		return index;
+	}
+
+#pragma endregion
+
+#pragma region Ray
+
+	size_t Ray::IntersectAll(const RectSoA& rects, std::vector<Hit>& results) const
+	{
+		if (dir.x == 0 && dir.y == 0) return 0; // No ray
+
+		const size_t before = results.size();
+		Sweep(Prepare(*this), rects, [&](int i, float t) { results.push_back({ i, t }); });
+		return results.size() - before;
+	}
+
+	int Ray::FirstHit(const RectSoA& rects, Contact& contact) const { return SDL::FirstHit(*this, rects, &contact); }
+
+	void Ray::FirstHits(const Ray* rays, int count, const RectSoA& rects, int* indices, Contact* contacts, bool parallel)
+	{
+		MaybeParallelFor(parallel, count, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+				indices[i] = SDL::FirstHit(rays[i], rects, contacts != NULL ? contacts + i : NULL);
+		}, 64);
+	}
+
+	int Ray::TimeOfImpact(const FRect& moving, const FPoint& velocity, const FRect* obstacles, int count, Contact& contact)
+	{
+		contact = { false };
+		if (velocity.x == 0 && velocity.y == 0) return -1; // Not moving
+
+		int index = -1;
+		bool corner = false;
+
+		for (int i = 0; i < count; i++)
+		{
+			const Contact c = SweepRect(moving, velocity, obstacles[i]);
+			if (!c.contact) continue;
+
+			const bool onCorner = c.normal.x != 0 && c.normal.y != 0;
+			if (index < 0 || c.time < contact.time || (c.time == contact.time && corner && !onCorner))
+			{
+				index = i;
+				contact = c;
+				corner = onCorner;
+			}
+		}
+
+		return index;
+	}
+
+	FPoint Ray::SlideRect(const FRect& moving, const FPoint& velocity, const FRect* obstacles, int count, std::vector<Contact>* contacts, int iterations)
+	{
+		FRect rect = moving;
+		FPoint rest = velocity;
+
+		for (int i = 0; i < iterations && (rest.x != 0 || rest.y != 0); i++)
+		{
+			Contact c;
+			if (TimeOfImpact(rect, rest, obstacles, count, c) < 0)
+			{
+				rect.pos += rest;
+				return rect.pos;
+			}
+
+			if (contacts != NULL) contacts->push_back(c);
+
+			// Carry on with what is left of the move, without the part into the side hit
+			rest = rest * (1 - c.time);
+			if (c.normal.x != 0) rest.x = 0;
+			if (c.normal.y != 0) rest.y = 0;
+			rect.pos = c.point;
+		}
+
+		return rect.pos;
+	}
+
+#pragma endregion
+}
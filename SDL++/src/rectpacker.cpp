@@ -0,0 +1,501 @@
+#include "rectpacker.hpp"
+#include "region.hpp"
+
+#include <SDL_error.h>
+
+#include <algorithm>
+#include <climits>
+#include <numeric>
+
+namespace SDL
+{
+#pragma region Helpers
+
+	static inline bool Overlaps(const Rect& a, const Rect& b)
+		{ return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h; }
+
+	static inline bool Touches(const Rect& a, const Rect& b)
+		{ return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h; }
+
+	static inline bool Contains(const Rect& outer, const Rect& inner)
+		{ return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.w <= outer.x + outer.w && inner.y + inner.h <= outer.y + outer.h; }
+
+	static inline Rect ToRect(const FRect& r) { return Rect((int)r.x, (int)r.y, (int)r.w, (int)r.h); }
+	static inline FRect ToFRect(const Rect& r) { return FRect((float)r.x, (float)r.y, (float)r.w, (float)r.h); }
+
+	static inline Rect GetFree(const RectPacker& packer, int proxy) { return ToRect(packer.freeRects.GetRect(proxy)); }
+
+	static void AddFree(RectPacker& packer, const Rect& r)
+	{
+		const int proxy = packer.freeRects.Insert(ToFRect(r));
+		packer.freeByWidth.insert({ r.w, r.h, proxy });
+		packer.freeByHeight.insert({ r.h, r.w, proxy });
+	}
+
+	static void RemoveFree(RectPacker& packer, int proxy)
+	{
+		const Rect r = GetFree(packer, proxy);
+		packer.freeByWidth.erase({ r.w, r.h, proxy });
+		packer.freeByHeight.erase({ r.h, r.w, proxy });
+		packer.freeRects.Remove(proxy);
+	}
+
+	// Find the free rectangles overlapping or touching an area
+	static void FindNear(const RectPacker& packer, const Rect& r, std::vector<int>& found)
+	{
+		found.clear();
+		packer.freeRects.Query(FRect(r.x - 0.5f, r.y - 0.5f, r.w + 1.f, r.h + 1.f), [&](int proxy)
+		{
+			found.push_back(proxy);
+			return true;
+		});
+	}
+
+	// Find the free rectangle that a w x h rectangle (or h x w, if rotation is allowed) leaves the shortest side over
+	// in, breaking ties by the longer side. The shortest side over is either the least width over or the least height
+	// over of any rectangle it fits, so walking the free rectangles by width and by height from the size wanted finds
+	// it, stopping once they are further over than the best found so far, or after looking at limit of each.
+	static bool BestShortSideFit(const RectPacker& packer, int w, int h, int limit, Rect& best)
+	{
+		int bestShort = INT_MAX, bestLong = INT_MAX;
+
+		// Walk one ordering, of (side, other side, proxy), from a rectangle with the given sides
+		auto walk = [&](const std::set<std::tuple<int, int, int>>& order, int side, int other, bool across)
+		{
+			int seen = 0;
+			for (auto it = order.lower_bound({ side, INT_MIN, INT_MIN }); it != order.end() && std::get<0>(*it) - side <= bestShort && seen < limit; ++it, ++seen)
+			{
+				if (std::get<1>(*it) < other) continue;
+
+				const int shortSide = std::min(std::get<0>(*it) - side, std::get<1>(*it) - other);
+				const int longSide = std::max(std::get<0>(*it) - side, std::get<1>(*it) - other);
+				if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong))
+				{
+					const Rect f = GetFree(packer, std::get<2>(*it));
+					best = across ? Rect(f.x, f.y, other, side) : Rect(f.x, f.y, side, other);
+					bestShort = shortSide;
+					bestLong = longSide;
+				}
+			}
+		};
+
+		walk(packer.freeByWidth, w, h, false);
+		walk(packer.freeByHeight, h, w, true);
+		if (packer.allowRotation && w != h)
+		{
+			walk(packer.freeByWidth, h, w, false);
+			walk(packer.freeByHeight, w, h, true);
+		}
+
+		return bestShort != INT_MAX;
+	}
+
+	// Add a rectangle to a list unless one already holds it, dropping any it holds
+	static void AddMaximal(std::vector<Rect>& list, const Rect& r)
+	{
+		for (const Rect& f : list)
+			if (Contains(f, r)) return;
+
+		list.erase(std::remove_if(list.begin(), list.end(), [&](const Rect& f) { return Contains(r, f); }), list.end());
+		list.push_back(r);
+	}
+
+	// Add the parts of a free rectangle left on each side of a used area that are big enough to hold something
+	static void Split(const Rect& f, const Rect& used, int minSide, std::vector<Rect>& fresh)
+	{
+		const Rect parts[4] =
+		{
+			Rect(f.x, f.y, used.x - f.x, f.h),
+			Rect(used.x + used.w, f.y, f.x + f.w - used.x - used.w, f.h),
+			Rect(f.x, f.y, f.w, used.y - f.y),
+			Rect(f.x, used.y + used.h, f.w, f.y + f.h - used.y - used.h)
+		};
+
+		for (const Rect& part : parts)
+			if (part.w >= minSide && part.h >= minSide) AddMaximal(fresh, part);
+	}
+
+	// Take a used area out of the free rectangles, replacing each it overlaps with the parts of it left on each side
+	static void Reserve(RectPacker& packer, const Rect& used)
+	{
+		std::vector<Rect>& fresh = packer.newFree;
+		std::vector<int>& touching = packer.touching;
+		fresh.clear();
+		touching.clear();
+
+		FindNear(packer, used, packer.found);
+		for (int proxy : packer.found)
+		{
+			const Rect f = GetFree(packer, proxy);
+			if (!Overlaps(f, used))
+			{
+				touching.push_back(proxy);
+				continue;
+			}
+
+			RemoveFree(packer, proxy);
+			Split(f, used, packer.minSide, fresh);
+		}
+
+		// Parts of a split rectangle can only be redundant with the rectangles left, never the other way round. Each part
+		// runs up against the used area, so only a rectangle that does the same, without overlapping it, can hold one.
+		for (const Rect& r : fresh)
+		{
+			bool held = false;
+			for (size_t i = 0; i < touching.size() && !held; i++) held = Contains(GetFree(packer, touching[i]), r);
+			if (!held) AddFree(packer, r);
+		}
+	}
+
+	// Give an area back to the free rectangles. Strips too thin to keep were dropped when free rectangles were split
+	// around the area, so the free space within that distance of it that nothing is placed on is given back too. Any
+	// maximal free rectangle this makes overlaps what is given back, and lies within it and the free rectangles
+	// near it, so only those need working out again: take everything else in their bounds out of the bounds, as
+	// Reserve() does for placed rectangles, then drop the nearby rectangles the new ones hold.
+	static void Release(RectPacker& packer, const Rect& r)
+	{
+		std::vector<Rect>& fresh = packer.newFree;
+		std::vector<int>& near = packer.touching;
+
+		const int reach = std::max(packer.minSide - 1, 0);
+		const Rect space(0, 0, packer.bounds.w + packer.padding, packer.bounds.h + packer.padding);
+		const Rect around = RectIntersection(Rect(r.x - reach, r.y - reach, r.w + 2 * reach, r.h + 2 * reach), space);
+
+		// Anything placed, and for Skyline, the open space above the skyline, is not given back
+		std::vector<Rect> taken;
+		packer.usedRects.Query(ToFRect(around), [&](int proxy)
+		{
+			taken.push_back(ToRect(packer.usedRects.GetRect(proxy)));
+			return true;
+		});
+
+		for (const RectPacker::Segment& segment : packer.skyline)
+			if (segment.x < around.x + around.w && around.x < segment.x + segment.w)
+				taken.push_back(Rect(segment.x, segment.y, segment.w, space.h - segment.y));
+
+		std::vector<Rect> local;
+		FindNear(packer, around, near);
+		for (int proxy : near) local.push_back(GetFree(packer, proxy));
+
+		const Region added = Region(around) - Region(taken) - Region(local);
+		const Region area = added | Region(local);
+		const Rect window = area.Bounds();
+
+		std::vector<Rect> merged(1, window);
+		for (const Rect& b : Region(window) - area)
+		{
+			fresh.clear();
+			for (size_t i = 0; i < merged.size();)
+			{
+				if (!Overlaps(merged[i], b))
+				{
+					i++;
+					continue;
+				}
+
+				Split(merged[i], b, packer.minSide, fresh);
+				merged[i] = merged.back();
+				merged.pop_back();
+			}
+
+			for (const Rect& part : fresh) AddMaximal(merged, part);
+		}
+
+		// The rest were already free, and are either kept or held by a new rectangle
+		merged.erase(std::remove_if(merged.begin(), merged.end(), [&](const Rect& m) { return !added.Intersects(m); }), merged.end());
+
+		for (int proxy : near)
+		{
+			const Rect f = GetFree(packer, proxy);
+			if (std::any_of(merged.begin(), merged.end(), [&](const Rect& m) { return Contains(m, f); })) RemoveFree(packer, proxy);
+		}
+
+		for (const Rect& m : merged) AddFree(packer, m);
+	}
+
+	// The height a w x h rectangle would rest at with its left edge at the start of skyline segment i, if it fits
+	static bool SkylineFit(const std::vector<RectPacker::Segment>& skyline, size_t i, int w, int h, int width, int height, int& y)
+	{
+		if (skyline[i].x + w > width) return false;
+
+		y = skyline[i].y;
+		for (int left = w; left > 0; i++)
+		{
+			y = std::max(y, skyline[i].y);
+			if (y + h > height) return false;
+			left -= skyline[i].w;
+		}
+		return true;
+	}
+
+	// The index of the skyline segment over x
+	static size_t SegmentAt(const std::vector<RectPacker::Segment>& skyline, int x)
+	{
+		return (size_t)(std::upper_bound(skyline.begin(), skyline.end(), x, [](int x, const RectPacker::Segment& s) { return x < s.x; }) - skyline.begin()) - 1;
+	}
+
+	// Move the skyline from x0 to x1 to height y, joining it with neighbours at the same height
+	static void SetSkyline(RectPacker& packer, int x0, int x1, int y)
+	{
+		std::vector<RectPacker::Segment>& sky = packer.skyline;
+
+		// The segments under the change, and one either side to join with
+		size_t first = SegmentAt(sky, x0), last = SegmentAt(sky, x1 - 1) + 1;
+		if (first > 0) first--;
+		if (last < sky.size()) last++;
+
+		// At most two pieces are kept either side
+		RectPacker::Segment parts[5];
+		int count = 0;
+		auto add = [&](int x, int h, int w)
+		{
+			if (count > 0 && parts[count - 1].y == h) parts[count - 1].w += w;
+			else parts[count++] = { x, h, w };
+		};
+
+		for (size_t j = first; j < last; j++)
+			if (sky[j].x < x0) add(sky[j].x, sky[j].y, std::min(sky[j].x + sky[j].w, x0) - sky[j].x);
+		add(x0, y, x1 - x0);
+		for (size_t j = first; j < last; j++)
+		{
+			const int left = std::max(sky[j].x, x1);
+			if (sky[j].x + sky[j].w > left) add(left, sky[j].y, sky[j].x + sky[j].w - left);
+		}
+
+		sky.erase(sky.begin() + first, sky.begin() + last);
+		sky.insert(sky.begin() + first, parts, parts + count);
+	}
+
+	// Place a rectangle on the skyline, keeping the gaps left under it as free rectangles. These were under open sky
+	// until now, so cannot overlap any free rectangle already kept.
+	static void SkylinePlace(RectPacker& packer, size_t i, const Rect& r)
+	{
+		const std::vector<RectPacker::Segment>& sky = packer.skyline;
+		const int right = r.x + r.w;
+
+		for (size_t j = i; j < sky.size() && sky[j].x < right; j++)
+		{
+			const Rect gap(sky[j].x, sky[j].y, std::min(sky[j].x + sky[j].w, right) - sky[j].x, r.y - sky[j].y);
+			if (gap.w >= packer.minSide && gap.h >= packer.minSide) AddFree(packer, gap);
+		}
+
+		SetSkyline(packer, r.x, right, r.y + r.h);
+	}
+
+	// For Skyline, give free space reaching up to the skyline back to the open sky, lowering the skyline over it. A
+	// lower skyline can meet more free space, so this goes on until no free rectangle near the area reaches it.
+	static void Reopen(RectPacker& packer, const Rect& area)
+	{
+		const Rect space(0, 0, packer.bounds.w + packer.padding, packer.bounds.h + packer.padding);
+		std::vector<Rect> todo(1, area);
+		std::vector<int> found;
+
+		while (!todo.empty())
+		{
+			const Rect near = todo.back();
+			todo.pop_back();
+
+			FindNear(packer, near, found);
+			for (int proxy : found)
+			{
+				const Rect f = GetFree(packer, proxy);
+				const int bottom = f.y + f.h;
+
+				// The first stretch of skyline over the free rectangle at its bottom edge
+				int x0 = 0, x1 = 0;
+				for (size_t j = SegmentAt(packer.skyline, f.x); j < packer.skyline.size() && packer.skyline[j].x < f.x + f.w; j++)
+				{
+					const RectPacker::Segment& s = packer.skyline[j];
+					if (s.y != bottom) continue;
+
+					x0 = std::max(s.x, f.x);
+					x1 = std::min(s.x + s.w, f.x + f.w);
+					break;
+				}
+				if (x0 == x1) continue;
+
+				// Free rectangles overlapping what is opened are cut back as if something were placed there
+				Reserve(packer, Rect(x0, f.y, x1 - x0, f.h));
+				SetSkyline(packer, x0, x1, f.y);
+
+				// The proxies found may be gone, so look here again, and along the new stretch of skyline
+				todo.push_back(near);
+				todo.push_back(RectIntersection(Rect(x0, f.y - 1, x1 - x0, 2), space));
+				break;
+			}
+		}
+	}
+
+	// Find room for a padded w x h rectangle, relative to the bounds
+	static bool Place(RectPacker& packer, int w, int h, Rect& result)
+	{
+		const int width = packer.bounds.w + packer.padding;
+		const int height = packer.bounds.h + packer.padding;
+
+		// Skyline only looks at the gaps closest in size, keeping it fast however many there are
+		const int limit = packer.mode == RectPacker::Mode::MAXRECTS ? INT_MAX : RectPacker::SKYLINE_GAP_LIMIT;
+		if (BestShortSideFit(packer, w, h, limit, result))
+		{
+			Reserve(packer, result);
+			return true;
+		}
+
+		if (packer.mode == RectPacker::Mode::MAXRECTS) return false;
+
+		// Rest on the lowest point of the skyline, breaking ties by the narrowest segment
+		size_t best = SIZE_MAX;
+		int bestTop = INT_MAX, bestWidth = INT_MAX;
+
+		auto score = [&](size_t i, int rw, int rh)
+		{
+			// It rests at least as high as the segment, so most segments can be passed over without a closer look
+			int y = packer.skyline[i].y;
+			if (y + rh > bestTop || (y + rh == bestTop && packer.skyline[i].w >= bestWidth)) return;
+			if (!SkylineFit(packer.skyline, i, rw, rh, width, height, y)) return;
+			if (y + rh < bestTop || (y + rh == bestTop && packer.skyline[i].w < bestWidth))
+			{
+				best = i;
+				bestTop = y + rh;
+				bestWidth = packer.skyline[i].w;
+				result = Rect(packer.skyline[i].x, y, rw, rh);
+			}
+		};
+
+		for (size_t i = 0; i < packer.skyline.size(); i++)
+		{
+			score(i, w, h);
+			if (packer.allowRotation && w != h) score(i, h, w);
+		}
+
+		if (best == SIZE_MAX) return false;
+
+		SkylinePlace(packer, best, result);
+		return true;
+	}
+
+#pragma endregion
+
+#pragma region RectPacker
+
+	RectPacker::RectPacker(const Rect& bounds, Mode mode, int padding, bool allowRotation)
+		: bounds(bounds), mode(mode), padding(std::max(padding, 0)), allowRotation(allowRotation), freeRects(0.f, 0.f), usedRects(0.f, 0.f)
+	{
+		Clear();
+	}
+
+	bool RectPacker::Insert(const Point& size, Rect& placed)
+	{
+		placed = Rect(bounds.pos, Point(0, 0));
+
+		if (size.x <= 0 || size.y <= 0)
+		{
+			SDL_SetError("Cannot pack a %dx%d rectangle", size.x, size.y);
+			return false;
+		}
+
+		const int side = std::min(size.x, size.y) + padding;
+		if (minSide == 0 || side < minSide) minSide = side;
+
+		Rect r;
+		if (!Place(*this, size.x + padding, size.y + padding, r))
+		{
+			SDL_SetError("No room to pack a %dx%d rectangle", size.x, size.y);
+			return false;
+		}
+
+		usedRects.Insert(ToFRect(r));
+		usedArea += (long long)r.w * r.h;
+		placed = Rect(bounds.x + r.x, bounds.y + r.y, r.w - padding, r.h - padding);
+		return true;
+	}
+
+	int RectPacker::Insert(const Point* sizes, int count, Rect* placed)
+	{
+		std::vector<int> order(count);
+		std::iota(order.begin(), order.end(), 0);
+
+		for (int i = 0; i < count; i++)
+		{
+			if (sizes[i].x <= 0 || sizes[i].y <= 0) continue;
+
+			const int side = std::min(sizes[i].x, sizes[i].y) + padding;
+			if (minSide == 0 || side < minSide) minSide = side;
+		}
+
+		// Longest side first, then the other side, so the awkward rectangles go in while there is most room
+		std::sort(order.begin(), order.end(), [&](int a, int b)
+		{
+			const int longA = std::max(sizes[a].x, sizes[a].y), longB = std::max(sizes[b].x, sizes[b].y);
+			if (longA != longB) return longA > longB;
+			return std::min(sizes[a].x, sizes[a].y) > std::min(sizes[b].x, sizes[b].y);
+		});
+
+		int done = 0;
+		for (int i : order)
+		{
+			placed[i] = Rect(bounds.pos, Point(0, 0));
+			if (sizes[i].x <= 0 || sizes[i].y <= 0) continue;
+
+			Rect r;
+			if (!Place(*this, sizes[i].x + padding, sizes[i].y + padding, r)) continue;
+
+			usedRects.Insert(ToFRect(r));
+			usedArea += (long long)r.w * r.h;
+			placed[i] = Rect(bounds.x + r.x, bounds.y + r.y, r.w - padding, r.h - padding);
+			done++;
+		}
+
+		return done;
+	}
+
+	bool RectPacker::Free(const Rect& placed)
+	{
+		const Rect r(placed.x - bounds.x, placed.y - bounds.y, placed.w + padding, placed.h + padding);
+
+		int proxy = AABBTree::NONE;
+		usedRects.QueryPoint(FPoint(r.x + 0.5f, r.y + 0.5f), [&](int p)
+		{
+			if (ToRect(usedRects.GetRect(p)) == r) proxy = p;
+			return proxy == AABBTree::NONE;
+		});
+
+		if (placed.w <= 0 || placed.h <= 0 || proxy == AABBTree::NONE)
+		{
+			SDL_SetError("The %dx%d rectangle at (%d, %d) was not placed by this packer", placed.w, placed.h, placed.x, placed.y);
+			return false;
+		}
+
+		usedRects.Remove(proxy);
+		usedArea -= (long long)r.w * r.h;
+
+		// With nothing left, start again from the empty bounds rather than from whatever the free space was cut into
+		if (usedRects.Size() == 0) Clear();
+		else
+		{
+			Release(*this, r);
+			if (mode == Mode::SKYLINE) Reopen(*this, r);
+		}
+		return true;
+	}
+
+	void RectPacker::Clear()
+	{
+		const int width = bounds.w + padding;
+		const int height = bounds.h + padding;
+
+		freeRects.Clear();
+		usedRects.Clear();
+		freeByWidth.clear();
+		freeByHeight.clear();
+		skyline.clear();
+		usedArea = 0;
+		minSide = 0;
+
+		if (bounds.w <= 0 || bounds.h <= 0) return;
+
+		if (mode == Mode::MAXRECTS) AddFree(*this, Rect(0, 0, width, height));
+		else skyline.push_back({ 0, 0, width });
+	}
+
+#pragma endregion
+}
@@ -0,0 +1,289 @@
+#include "region.hpp"
+
+#include <algorithm>
+#include <climits>
+
+namespace SDL
+{
+#pragma region Helpers
+
+	static inline bool Overlaps(const Rect& a, const Rect& b)
+		{ return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h; }
+
+	static inline bool Encloses(const Rect& outer, const Rect& inner)
+		{ return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.w <= outer.x + outer.w && inner.y + inner.h <= outer.y + outer.h; }
+
+	// The index just past the band starting at i
+	static inline size_t BandEnd(const std::vector<Rect>& rects, size_t i)
+	{
+		const size_t start = i;
+		while (i < rects.size() && rects[i].y == rects[start].y) i++;
+		return i;
+	}
+
+	// Write the spans from top to bottom covered by op(in a, in b), given the spans of a band from each region
+	template <typename Op>
+	static void Spans(const Rect* a, const Rect* aEnd, const Rect* b, const Rect* bEnd, int top, int bottom, Op op, std::vector<Rect>& out)
+	{
+		bool inA = false, inB = false;
+		int start = 0;
+
+		while (a != aEnd || b != bEnd)
+		{
+			// The next edge along either list. Spans in a band never touch, so each list has at most one edge here.
+			const int edgeA = a == aEnd ? INT_MAX : inA ? a->x + a->w : a->x;
+			const int edgeB = b == bEnd ? INT_MAX : inB ? b->x + b->w : b->x;
+			const int x = std::min(edgeA, edgeB);
+
+			const bool was = op(inA, inB);
+			if (edgeA == x) { if (inA) a++; inA = !inA; }
+			if (edgeB == x) { if (inB) b++; inB = !inB; }
+			const bool now = op(inA, inB);
+
+			if (!was && now) start = x;
+			else if (was && !now) out.push_back(Rect(start, top, x - start, bottom - top));
+		}
+	}
+
+	// Join the band just written onto the one before it if they meet and hold the same spans
+	static void Coalesce(std::vector<Rect>& out, size_t& previous, size_t current)
+	{
+		if (current == out.size()) return;
+
+		const size_t count = out.size() - current;
+		if (previous != SIZE_MAX && current - previous == count && out[previous].y + out[previous].h == out[current].y)
+		{
+			bool same = true;
+			for (size_t i = 0; i < count && same; i++)
+				same = out[previous + i].x == out[current + i].x && out[previous + i].w == out[current + i].w;
+
+			if (same)
+			{
+				const int h = out[current].h;
+				for (size_t i = previous; i < current; i++) out[i].h += h;
+				out.resize(current);
+				return;
+			}
+		}
+
+		previous = current;
+	}
+
+	// Work out the area covered by op(in a, in b), one band at a time, from the top of both regions down
+	template <typename Op>
+	static void Combine(const std::vector<Rect>& a, const std::vector<Rect>& b, Op op, std::vector<Rect>& out)
+	{
+		out.clear();
+		out.reserve(a.size() + b.size());
+
+		size_t ia = 0, ib = 0;
+		size_t aEnd = BandEnd(a, 0), bEnd = BandEnd(b, 0);
+		size_t previous = SIZE_MAX;
+
+		int y = std::min(a.empty() ? INT_MAX : a[0].y, b.empty() ? INT_MAX : b[0].y);
+
+		while (ia < a.size() || ib < b.size())
+		{
+			if (ia < a.size() && a[ia].y + a[ia].h <= y) { ia = aEnd; aEnd = BandEnd(a, ia); continue; }
+			if (ib < b.size() && b[ib].y + b[ib].h <= y) { ib = bEnd; bEnd = BandEnd(b, ib); continue; }
+
+			const bool inA = ia < a.size() && a[ia].y <= y;
+			const bool inB = ib < b.size() && b[ib].y <= y;
+
+			// Bands only change where one of them starts or ends
+			int next = INT_MAX;
+			if (ia < a.size()) next = std::min(next, inA ? a[ia].y + a[ia].h : a[ia].y);
+			if (ib < b.size()) next = std::min(next, inB ? b[ib].y + b[ib].h : b[ib].y);
+
+			// Where only one region has a band, it is either kept whole or dropped whole
+			if ((inA || inB) && ((inA && inB) || op(inA, inB)))
+			{
+				const size_t current = out.size();
+				Spans(a.data() + ia, a.data() + (inA ? aEnd : ia), b.data() + ib, b.data() + (inB ? bEnd : ib), y, next, op, out);
+				Coalesce(out, previous, current);
+			}
+
+			y = next;
+		}
+	}
+
+	static Rect Extents(const std::vector<Rect>& rects)
+	{
+		if (rects.empty()) return Rect();
+
+		int left = INT_MAX, right = INT_MIN;
+		for (const Rect& r : rects)
+		{
+			left = std::min(left, r.x);
+			right = std::max(right, r.x + r.w);
+		}
+
+		const int top = rects.front().y, bottom = rects.back().y + rects.back().h;
+		return Rect(left, top, right - left, bottom - top);
+	}
+
+	// The first rectangle in the first band that ends below y
+	static inline std::vector<Rect>::const_iterator FirstBandBelow(const std::vector<Rect>& rects, int y)
+		{ return std::partition_point(rects.begin(), rects.end(), [y](const Rect& r) { return r.y + r.h <= y; }); }
+
+#pragma endregion
+
+#pragma region Region
+
+	Region::Region(const Rect* src, int count)
+	{
+		std::vector<Region> parts;
+		parts.reserve(count);
+		for (int i = 0; i < count; i++)
+			if (!src[i].empty()) parts.emplace_back(src[i]);
+
+		if (parts.empty()) return;
+
+		// Join in pairs, then pairs of pairs, so no one region grows much faster than the rest
+		for (size_t step = 1; step < parts.size(); step *= 2)
+			for (size_t i = 0; i + step < parts.size(); i += 2 * step)
+				parts[i].Union(parts[i + step]);
+
+		*this = std::move(parts[0]);
+	}
+
+	Region& Region::Union(const Region& other)
+	{
+		if (other.Empty() || (rects.size() == 1 && Encloses(extents, other.extents))) return *this;
+		if (Empty() || (other.rects.size() == 1 && Encloses(other.extents, extents))) return *this = other;
+
+		std::vector<Rect> out;
+		Combine(rects, other.rects, [](bool a, bool b) { return a || b; }, out);
+		rects.swap(out);
+		extents = Extents(rects);
+		return *this;
+	}
+
+	Region& Region::Subtract(const Region& other)
+	{
+		if (Empty() || other.Empty() || !Overlaps(extents, other.extents)) return *this;
+		if (other.rects.size() == 1 && Encloses(other.extents, extents))
+		{
+			Clear();
+			return *this;
+		}
+
+		std::vector<Rect> out;
+		Combine(rects, other.rects, [](bool a, bool b) { return a && !b; }, out);
+		rects.swap(out);
+		extents = Extents(rects);
+		return *this;
+	}
+
+	Region& Region::Intersect(const Region& other)
+	{
+		if (Empty() || other.Empty() || !Overlaps(extents, other.extents))
+		{
+			Clear();
+			return *this;
+		}
+		if (other.rects.size() == 1 && Encloses(other.extents, extents)) return *this;
+		if (rects.size() == 1 && Encloses(extents, other.extents)) return *this = other;
+
+		std::vector<Rect> out;
+		Combine(rects, other.rects, [](bool a, bool b) { return a && b; }, out);
+		rects.swap(out);
+		extents = Extents(rects);
+		return *this;
+	}
+
+	Region& Region::Xor(const Region& other)
+	{
+		if (other.Empty()) return *this;
+		if (Empty()) return *this = other;
+
+		std::vector<Rect> out;
+		Combine(rects, other.rects, [](bool a, bool b) { return a != b; }, out);
+		rects.swap(out);
+		extents = Extents(rects);
+		return *this;
+	}
+
+	Region& Region::Translate(const Point& offset)
+	{
+		if (Empty()) return *this;
+
+		for (Rect& r : rects) r.pos += offset;
+		extents.pos += offset;
+		return *this;
+	}
+
+	bool Region::Contains(const Point& point) const
+	{
+		if (point.x < extents.x || point.x >= extents.x + extents.w || point.y < extents.y || point.y >= extents.y + extents.h) return false;
+
+		const auto band = FirstBandBelow(rects, point.y);
+		if (band == rects.end() || band->y > point.y) return false;
+
+		const int top = band->y;
+		const auto last = std::partition_point(band, rects.end(), [top](const Rect& r) { return r.y == top; });
+		const auto span = std::partition_point(band, last, [&](const Rect& r) { return r.x + r.w <= point.x; });
+		return span != last && span->x <= point.x;
+	}
+
+	bool Region::Contains(const Rect& rect) const
+	{
+		if (rect.empty() || !Encloses(extents, rect)) return false;
+
+		const int bottom = rect.y + rect.h;
+		int y = rect.y;
+
+		for (auto it = FirstBandBelow(rects, y); it != rects.end();)
+		{
+			// Each band from the top of the rectangle down must meet the last, and have one span across it
+			if (it->y > y) return false;
+
+			const int top = it->y, h = it->h;
+			bool covered = false;
+			for (; it != rects.end() && it->y == top; ++it)
+				covered = covered || (it->x <= rect.x && it->x + it->w >= rect.x + rect.w);
+
+			if (!covered) return false;
+
+			y = top + h;
+			if (y >= bottom) return true;
+		}
+
+		return false;
+	}
+
+	bool Region::Intersects(const Rect& rect) const
+	{
+		if (Empty() || rect.empty() || !Overlaps(extents, rect)) return false;
+
+		const int bottom = rect.y + rect.h;
+		for (auto it = FirstBandBelow(rects, rect.y); it != rects.end() && it->y < bottom; ++it)
+			if (it->x < rect.x + rect.w && rect.x < it->x + it->w) return true;
+
+		return false;
+	}
+
+	long long Region::Area() const
+	{
+		long long area = 0;
+		for (const Rect& r : rects) area += (long long)r.w * r.h;
+		return area;
+	}
+
+	bool Region::operator==(const Region& other) const
+	{
+		if (rects.size() != other.rects.size()) return false;
+
+		// Every area has only one banded form, so the lists match exactly
+		for (size_t i = 0; i < rects.size(); i++)
+		{
+			const Rect& a = rects[i];
+			const Rect& b = other.rects[i];
+			if (a.x != b.x || a.y != b.y || a.w != b.w || a.h != b.h) return false;
+		}
+
+		return true;
+	}
+
+#pragma endregion
+}
@@ -0,0 +1,164 @@
+#include "shape.hpp"
+#include "pixelops.hpp"
+
+namespace SDL::WindowShape
+{
+	// Write 0xFFFFFFFF to out for each pixel inside the shape and 0 for the rest. A pixel is inside if
+	// ((pixel >> shift) & select) compares with value as the test asks: at least, at most, or not equal
+	enum class MaskTest { AT_LEAST, AT_MOST, NOT_EQUAL };
+
+	static void BinarizeRow(const Uint32* in, Uint32* out, int w, MaskTest test, int shift, Uint32 select, Uint32 value)
+	{
+		int x = 0;
+
+#if defined(SDLPP_SSE2)
+		// Alpha is shifted down to the low byte, so the signed 32-bit compares are exact
+		const __m128i vshift = _mm_cvtsi32_si128(shift);
+		const __m128i vselect = _mm_set1_epi32((int)select);
+		const __m128i ones = _mm_set1_epi32(-1);
+		const __m128i low = _mm_set1_epi32((int)value - 1);
+		const __m128i high = _mm_set1_epi32((int)value + 1);
+		const __m128i key = _mm_set1_epi32((int)value);
+
+		for (; x + 4 <= w; x += 4)
+		{
+			const __m128i p = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128((const __m128i*)(in + x)), vshift), vselect);
+			__m128i inside;
+
+			switch (test)
+			{
+			case MaskTest::AT_LEAST: inside = _mm_cmpgt_epi32(p, low); break;
+			case MaskTest::AT_MOST:  inside = _mm_cmplt_epi32(p, high); break;
+			default:                 inside = _mm_xor_si128(_mm_cmpeq_epi32(p, key), ones); break;
+			}
+
+			_mm_storeu_si128((__m128i*)(out + x), inside);
+		}
+#elif defined(SDLPP_NEON)
+		const int32x4_t vshift = vdupq_n_s32(-shift);
+		const uint32x4_t vselect = vdupq_n_u32(select);
+		const uint32x4_t vvalue = vdupq_n_u32(value);
+
+		for (; x + 4 <= w; x += 4)
+		{
+			const uint32x4_t p = vandq_u32(vshlq_u32(vld1q_u32(in + x), vshift), vselect);
+			uint32x4_t inside;
+
+			switch (test)
+			{
+			case MaskTest::AT_LEAST: inside = vcgeq_u32(p, vvalue); break;
+			case MaskTest::AT_MOST:  inside = vcleq_u32(p, vvalue); break;
+			default:                 inside = vmvnq_u32(vceqq_u32(p, vvalue)); break;
+			}
+
+			vst1q_u32(out + x, inside);
+		}
+#endif
+
+		for (; x < w; x++)
+		{
+			const Uint32 p = (in[x] >> shift) & select;
+			bool inside;
+
+			switch (test)
+			{
+			case MaskTest::AT_LEAST: inside = p >= value; break;
+			case MaskTest::AT_MOST:  inside = p <= value; break;
+			default:                 inside = p != value; break;
+			}
+
+			out[x] = inside ? 0xFFFFFFFF : 0;
+		}
+	}
+
+	bool ShapeMask::Update(const Surface& source, const Mode& shape_mode)
+	{
+		if (!source.surface)
+		{
+			SDL_SetError("Parameter 'source' is invalid");
+			return false;
+		}
+
+		Surface converted = source;
+		if (!Is8888(source.surface->format))
+		{
+			converted = Surface::FromPtr(SDL_ConvertSurfaceFormat(source.surface.get(), SDL_PIXELFORMAT_ARGB8888, 0));
+			if (!converted.surface) return false;
+		}
+
+		SDL_Surface* s = converted.surface.get();
+		if (!mask.surface || mask.surface->w != s->w || mask.surface->h != s->h)
+		{
+			mask = Surface(s->w, s->h, SDL_PIXELFORMAT_ARGB8888);
+			if (!mask.surface) return false;
+			applied = NULL;
+		}
+
+		// The tests match SDL_CalculateShapeBitmap(), but read channels in place rather than unpacking every pixel
+		const SDL_PixelFormat* f = s->format;
+		MaskTest test = MaskTest::AT_LEAST;
+		int shift = f->Ashift;
+		Uint32 select = 0xFF, value = 0;
+
+		switch (shape_mode.mode)
+		{
+		case ShapeMode::Default:
+			value = 1;
+			break;
+		case ShapeMode::BinarizeAlpha:
+			value = shape_mode.parameters.binarizationCutoff;
+			break;
+		case ShapeMode::ReverseBinarizeAlpha:
+			test = MaskTest::AT_MOST;
+			value = shape_mode.parameters.binarizationCutoff;
+			break;
+		case ShapeMode::ColourKey:
+		{
+			const Colour& key = shape_mode.parameters.colourKey;
+			test = MaskTest::NOT_EQUAL;
+			shift = 0;
+			select = f->Rmask | f->Gmask | f->Bmask;
+			value = ((Uint32)key.r << f->Rshift) | ((Uint32)key.g << f->Gshift) | ((Uint32)key.b << f->Bshift);
+			break;
+		}
+		default:
+			SDL_SetError("Parameter 'shape_mode' is invalid");
+			return false;
+		}
+
+		// Without an alpha channel every pixel is opaque, so an alpha test selects either the whole surface or none of it
+		if (f->Amask == 0 && test != MaskTest::NOT_EQUAL)
+		{
+			const bool inside = test == MaskTest::AT_LEAST || shape_mode.parameters.binarizationCutoff == 255;
+			return SDL_FillRect(mask.surface.get(), NULL, inside ? 0xFFFFFFFF : 0) == 0;
+		}
+
+		if (SDL_LockSurface(s) != 0) return false;
+
+		for (int y = 0; y < s->h; y++)
+			BinarizeRow(Row<const Uint32>(s, y), Row<Uint32>(mask.surface.get(), y), s->w, test, shift, select, value);
+
+		SDL_UnlockSurface(s);
+
+		return true;
+	}
+
+	int ShapeMask::Apply(Window& window, const Surface& source, const Mode& shape_mode)
+	{
+		if (!Update(source, shape_mode)) return INVALID_SHAPE_ARGUMENT;
+
+		const Uint64 next = mask.Hash();
+		if (applied == window.window.get() && next == hash) return 0;
+
+		Mode binarized = {};
+		binarized.mode = ShapeMode::Default;
+		binarized.parameters.binarizationCutoff = 1;
+
+		const int result = SetWindowShape(window, mask, binarized);
+		if (result != 0) return result;
+
+		applied = window.window.get();
+		hash = next;
+		return 0;
+	}
+}
@@ -0,0 +1,83 @@
+#include "spatialhash.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+
+namespace SDL
+{
+#pragma region SpatialHash
+
+	void SpatialHash::Rebuild(const FRect* src, int count, bool parallel)
+	{
+		// Enough buckets that each holds about one cell's worth of entities
+		int size = 16;
+		while (size < count) size *= 2;
+		buckets = std::max(buckets, size);
+
+		// Each thread sorts one block of entities, with its own count of ids per bucket
+		const int blocks = parallel ? std::clamp(count / 4096, 1, std::max(SDL_GetCPUCount(), 1)) : 1;
+
+		rects.assign(src, src + count);
+		cells.resize(count);
+		keys.resize(count);
+		entries.resize(count);
+		starts.resize((size_t)buckets + 1);
+		counts.resize((size_t)buckets * blocks);
+		reaches.resize(blocks);
+
+		auto block = [&](int b) { return std::make_pair((int)((long long)count * b / blocks), (int)((long long)count * (b + 1) / blocks)); };
+
+		// Find each entity's cell and bucket, and count the entities in each bucket
+		ParallelFor(blocks, [&](int begin, int end)
+		{
+			for (int b = begin; b < end; b++)
+			{
+				int* histogram = counts.data() + (size_t)buckets * b;
+				std::fill(histogram, histogram + buckets, 0);
+
+				FPoint r(0, 0);
+				const auto [first, last] = block(b);
+				for (int i = first; i < last; i++)
+				{
+					const FPoint half = rects[i].size / 2.f;
+					r = FPoint::max(r, half);
+					cells[i] = Cell(rects[i].pos + half);
+					keys[i] = Bucket(cells[i]);
+					histogram[keys[i]]++;
+				}
+				reaches[b] = r;
+			}
+		}, 1);
+
+		// Turn the counts into where each block's ids for each bucket start
+		int offset = 0;
+		for (int k = 0; k < buckets; k++)
+		{
+			starts[k] = offset;
+			for (int b = 0; b < blocks; b++)
+			{
+				int& n = counts[(size_t)buckets * b + k];
+				const int c = n;
+				n = offset;
+				offset += c;
+			}
+		}
+		starts[buckets] = offset;
+
+		reach = FPoint(0, 0);
+		for (const FPoint& r : reaches) reach = FPoint::max(reach, r);
+
+		// Put each id in place, keeping them in order of id within each bucket
+		ParallelFor(blocks, [&](int begin, int end)
+		{
+			for (int b = begin; b < end; b++)
+			{
+				int* next = counts.data() + (size_t)buckets * b;
+				const auto [first, last] = block(b);
+				for (int i = first; i < last; i++) entries[next[keys[i]]++] = i;
+			}
+		}, 1);
+	}
+
+#pragma endregion
+}
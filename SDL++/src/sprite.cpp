@@ -0,0 +1,336 @@
+#include "sprite.hpp"
+#include "pixelops.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace SDL
+{
+#pragma region Encoding
+
+	// Classify a pixel of an 8888 format with alpha in channel `alpha`, or no alpha if it is negative
+	static inline CompiledSprite::RunType Classify(Uint32 p, int alpha, bool premultiplied)
+	{
+		if (alpha < 0) return CompiledSprite::RunType::COPY;
+
+		const Uint32 a = (p >> (alpha * 8)) & 0xFF;
+		if (a == 0xFF) return CompiledSprite::RunType::COPY;
+
+		// Premultiplied pixels with zero alpha can still add light, so only all zero pixels are skipped
+		if (a == 0 && (!premultiplied || p == 0)) return CompiledSprite::RunType::SKIP;
+
+		return CompiledSprite::RunType::BLEND;
+	}
+
+	CompiledSprite::CompiledSprite(const Surface& surface, Uint32 format)
+		: CompiledSprite()
+	{
+		if (!surface.surface)
+		{
+			SDL_SetError("Parameter 'surface' is invalid");
+			return;
+		}
+
+		SDL_Surface* src = surface.surface.get();
+		const bool keyed = SDL_HasColorKey(src) == SDL_TRUE;
+
+		// Colour keys become alpha when converted, so keyed surfaces are always converted
+		if (format == SDL_PIXELFORMAT_UNKNOWN) format = Is8888(src->format) && !keyed ? src->format->format : (Uint32)SDL_PIXELFORMAT_ARGB8888;
+
+		Surface converted = surface;
+		if (format != src->format->format || keyed)
+		{
+			converted = Surface::FromPtr(SDL_ConvertSurfaceFormat(src, format, 0));
+			if (!converted.surface) return;
+		}
+
+		SDL_Surface* s = converted.surface.get();
+		if (!Is8888(s->format))
+		{
+			SDL_SetError("Compiled sprites need a 32-bit format with 8-bit channels");
+			return;
+		}
+
+		if (SDL_LockSurface(s) != 0) return;
+
+		const int alpha = AlphaChannel(s->format);
+		rowRuns.reserve((size_t)s->h + 1);
+		rowPixels.reserve((size_t)s->h + 1);
+
+		for (int y = 0; y < s->h; y++)
+		{
+			const Uint32* row = Row<const Uint32>(s, y);
+			rowRuns.push_back((Uint32)runs.size());
+			rowPixels.push_back((Uint32)pixels.size());
+
+			// Trailing transparency needs no run, as each row ends with an implicit skip
+			int end = s->w;
+			while (end > 0 && Classify(row[end - 1], alpha, surface.IsPremultiplied()) == RunType::SKIP) end--;
+
+			for (int x = 0; x < end;)
+			{
+				const RunType type = Classify(row[x], alpha, surface.IsPremultiplied());
+				int next = x + 1;
+				while (next < end && Classify(row[next], alpha, surface.IsPremultiplied()) == type) next++;
+
+				runs.push_back(MakeRun(type, (Uint32)(next - x)));
+				if (type != RunType::SKIP) pixels.insert(pixels.end(), row + x, row + next);
+				x = next;
+			}
+		}
+
+		rowRuns.push_back((Uint32)runs.size());
+		rowPixels.push_back((Uint32)pixels.size());
+
+		SDL_UnlockSurface(s);
+
+		w = s->w;
+		h = s->h;
+		this->format = format;
+		premultiplied = surface.IsPremultiplied();
+	}
+
+	Surface CompiledSprite::ToSurface() const
+	{
+		if (!IsValid())
+		{
+			SDL_SetError("Parameter 'sprite' is invalid");
+			return Surface::FromPtr(NULL);
+		}
+
+		Surface result(w, h, format);
+		if (!result.surface) return Surface::FromPtr(NULL);
+
+		SDL_Surface* s = result.surface.get();
+		result.SetPremultiplied(premultiplied);
+		if (AlphaChannel(s->format) >= 0) SDL_SetSurfaceBlendMode(s, SDL_BLENDMODE_BLEND);
+
+		SDL_FillRect(s, NULL, 0);
+		if (SDL_LockSurface(s) != 0) return Surface::FromPtr(NULL);
+
+		for (int y = 0; y < h; y++)
+		{
+			Uint32* out = Row<Uint32>(s, y);
+			const Uint32* px = pixels.data() + rowPixels[y];
+
+			for (Uint32 r = rowRuns[y]; r < rowRuns[y + 1]; r++)
+			{
+				const Uint32 len = GetRunLength(runs[r]);
+				if (GetRunType(runs[r]) != RunType::SKIP)
+				{
+					std::copy_n(px, len, out);
+					px += len;
+				}
+				out += len;
+			}
+		}
+
+		SDL_UnlockSurface(s);
+
+		return result;
+	}
+
+#pragma endregion
+
+#pragma region Blitting
+
+	bool CompiledSprite::Blit(Surface& dst, const Point& pos) const
+	{
+		if (!IsValid() || !dst.surface)
+		{
+			SDL_SetError("Parameter '%s' is invalid", IsValid() ? "dst" : "sprite");
+			return false;
+		}
+
+		SDL_Surface* d = dst.surface.get();
+		if (d->format->format != format)
+		{
+			SDL_SetError("Compiled sprites can only be blitted to surfaces in the format they were compiled for (%s)", SDL_GetPixelFormatName(format));
+			return false;
+		}
+
+		const SDL_Rect bounds = { pos.x, pos.y, w, h };
+		SDL_Rect area;
+		if (!SDL_IntersectRect(&bounds, &d->clip_rect, &area)) return true;
+
+		if (SDL_LockSurface(d) != 0) return false;
+
+		const int alpha = AlphaChannel(d->format);
+		const int left = area.x, right = area.x + area.w;
+
+		for (int y = area.y; y < area.y + area.h; y++)
+		{
+			const int sy = y - pos.y;
+			const Uint32* px = pixels.data() + rowPixels[sy];
+			Uint32* out = Row<Uint32>(d, y);
+			int x = pos.x;
+
+			for (Uint32 r = rowRuns[sy]; r < rowRuns[sy + 1] && x < right; r++)
+			{
+				const RunType type = GetRunType(runs[r]);
+				const int len = (int)GetRunLength(runs[r]);
+
+				if (type != RunType::SKIP)
+				{
+					const int lo = std::max(x, left);
+					const int hi = std::min(x + len, right);
+
+					if (lo < hi)
+					{
+						const Uint32* in = px + (lo - x);
+						if (type == RunType::COPY) std::memcpy(out + lo, in, (size_t)(hi - lo) * sizeof(Uint32));
+						else CompositeRow(in, out + lo, hi - lo, SDL_BLENDMODE_BLEND, alpha, premultiplied);
+					}
+
+					px += len;
+				}
+
+				x += len;
+			}
+		}
+
+		SDL_UnlockSurface(d);
+
+		return true;
+	}
+
+#pragma endregion
+
+#pragma region Serialization
+
+	// "SPRC", followed by a version number
+	static constexpr Uint32 SPRITE_MAGIC = SDL_FOURCC('S', 'P', 'R', 'C');
+	static constexpr Uint32 SPRITE_VERSION = 1;
+
+	static bool WriteWords(RWops& dst, const std::vector<Uint32>& words)
+	{
+		if (words.empty()) return true;
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+		return dst.Write(words.data(), words.size()) == words.size();
+#else
+		std::vector<Uint32> swapped(words.size());
+		for (size_t i = 0; i < words.size(); i++) swapped[i] = SDL_SwapLE32(words[i]);
+		return dst.Write(swapped.data(), swapped.size()) == swapped.size();
+#endif
+	}
+
+	// Read in pieces, so a corrupt count only allocates as much as the data really holds
+	static bool ReadWords(RWops& src, std::vector<Uint32>& words, size_t count)
+	{
+		constexpr size_t PIECE = 1 << 16;
+
+		words.clear();
+		while (words.size() < count)
+		{
+			const size_t start = words.size();
+			const size_t n = std::min(count - start, PIECE);
+			words.resize(start + n);
+			if (src.Read(words.data() + start, n) != n) return false;
+		}
+
+#if SDL_BYTEORDER != SDL_LIL_ENDIAN
+		for (Uint32& word : words) word = SDL_SwapLE32(word);
+#endif
+		return true;
+	}
+
+	// Evaluates to false if the stream knows its size and has fewer bytes left than this
+	static bool FitsInStream(RWops& src, Uint64 bytes)
+	{
+		const Sint64 size = src.Size();
+		const Sint64 at = src.Tell();
+		return size < 0 || at < 0 || (at <= size && (Uint64)(size - at) >= bytes);
+	}
+
+	bool CompiledSprite::Save_RW(RWops& dst, bool freedst) const
+	{
+		bool success = IsValid();
+		if (!success) SDL_SetError("Parameter 'sprite' is invalid");
+
+		success = success
+			&& dst.WriteLE32(SPRITE_MAGIC)
+			&& dst.WriteLE32(SPRITE_VERSION)
+			&& dst.WriteLE32((Uint32)w)
+			&& dst.WriteLE32((Uint32)h)
+			&& dst.WriteLE32(format)
+			&& dst.WriteLE32(premultiplied ? 1 : 0)
+			&& dst.WriteLE32((Uint32)runs.size())
+			&& dst.WriteLE32((Uint32)pixels.size())
+			&& WriteWords(dst, rowRuns)
+			&& WriteWords(dst, runs)
+			&& WriteWords(dst, pixels);
+
+		if (freedst && !dst.Close()) success = false;
+		return success;
+	}
+
+	CompiledSprite CompiledSprite::Load_RW(RWops& src, bool freesrc)
+	{
+		CompiledSprite sprite;
+		bool success = false;
+
+		const Uint32 magic = src.ReadLE32();
+		const Uint32 version = src.ReadLE32();
+		const Uint32 w = src.ReadLE32();
+		const Uint32 h = src.ReadLE32();
+		const Uint32 format = src.ReadLE32();
+		const Uint32 flags = src.ReadLE32();
+		const Uint32 nruns = src.ReadLE32();
+		const Uint32 npixels = src.ReadLE32();
+
+		SDL_PixelFormat* fmt = NULL;
+
+		if (magic != SPRITE_MAGIC || version != SPRITE_VERSION)
+			SDL_SetError("Data is not a compiled sprite, or has an unsupported version");
+		else if (w > RUN_LENGTH_MASK || h > RUN_LENGTH_MASK || (Uint64)w * h < npixels || (Uint64)w * h < nruns)
+			SDL_SetError("Compiled sprite is corrupt");
+		else if ((fmt = SDL_AllocFormat(format)) == NULL || !Is8888(fmt))
+			SDL_SetError("Compiled sprite has an unsupported pixel format");
+		else if (!FitsInStream(src, ((Uint64)h + 1 + nruns + npixels) * sizeof(Uint32)))
+			SDL_SetError("Compiled sprite is truncated");
+		else if (!ReadWords(src, sprite.rowRuns, (size_t)h + 1) || !ReadWords(src, sprite.runs, nruns) || !ReadWords(src, sprite.pixels, npixels))
+			SDL_SetError("Compiled sprite is truncated");
+		else
+		{
+			// Rebuild the pixel offsets, checking every row stays inside the sprite and the data
+			success = sprite.rowRuns[0] == 0 && sprite.rowRuns[h] == nruns;
+			sprite.rowPixels.reserve((size_t)h + 1);
+			Uint64 used = 0;
+
+			for (Uint32 y = 0; y < h && success; y++)
+			{
+				sprite.rowPixels.push_back((Uint32)used);
+				if (sprite.rowRuns[y + 1] < sprite.rowRuns[y] || sprite.rowRuns[y + 1] > nruns) success = false;
+
+				Uint64 width = 0;
+				for (Uint32 r = sprite.rowRuns[y]; success && r < sprite.rowRuns[y + 1]; r++)
+				{
+					const Uint32 len = GetRunLength(sprite.runs[r]);
+					const RunType type = GetRunType(sprite.runs[r]);
+					if (type != RunType::SKIP && type != RunType::COPY && type != RunType::BLEND) success = false;
+					if (type != RunType::SKIP) used += len;
+					width += len;
+				}
+
+				if (width > w) success = false;
+			}
+
+			sprite.rowPixels.push_back((Uint32)used);
+			if (used != npixels) success = false;
+			if (!success) SDL_SetError("Compiled sprite is corrupt");
+		}
+
+		if (fmt != NULL) SDL_FreeFormat(fmt);
+		if (freesrc) src.Close();
+		if (!success) return CompiledSprite();
+
+		sprite.w = (int)w;
+		sprite.h = (int)h;
+		sprite.format = format;
+		sprite.premultiplied = (flags & 1) != 0;
+		return sprite;
+	}
+
+#pragma endregion
+}
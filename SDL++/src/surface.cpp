@@ -0,0 +1,1382 @@
+#include "surface.hpp"
+#include "simd.hpp"
+#include "pixelops.hpp"
+
+#include <SDL_endian.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace SDL
+{
+#pragma region Views
+
+	Surface Surface::View(const Rect& rect) const
+	{
+		if (!surface)
+		{
+			SDL_SetError("Parameter 'surface' is invalid");
+			return FromPtr(NULL);
+		}
+
+		if (SDL_MUSTLOCK(surface.get()))
+		{
+			SDL_SetError("Cannot view a surface with RLE acceleration");
+			return FromPtr(NULL);
+		}
+
+		if (surface->format->BitsPerPixel < 8)
+		{
+			SDL_SetError("Cannot view a surface with fewer than 8 bits per pixel");
+			return FromPtr(NULL);
+		}
+
+		const SDL_Rect bounds = { 0, 0, surface->w, surface->h };
+		SDL_Rect area;
+		if (!SDL_IntersectRect(&rect.rect, &bounds, &area)) area = { 0, 0, 0, 0 };
+
+		Uint8* pixels = (Uint8*)surface->pixels + (size_t)area.y * surface->pitch + (size_t)area.x * surface->format->BytesPerPixel;
+		SDL_Surface* view = SDL_CreateRGBSurfaceWithFormatFrom(pixels, area.w, area.h, surface->format->BitsPerPixel, surface->pitch, surface->format->format);
+		if (view == NULL) return FromPtr(NULL);
+
+		// The view's deleter holds a reference to this surface, keeping its pixels alive
+		const std::shared_ptr<SDL_Surface> parent = surface;
+		Surface result(std::shared_ptr<SDL_Surface>(view, [parent](SDL_Surface* s) { SDL_FreeSurface(s); }));
+		result.palette = palette;
+		result.SetPremultiplied(IsPremultiplied());
+
+		if (surface->format->palette != NULL) SDL_SetSurfacePalette(view, surface->format->palette);
+
+		SDL_BlendMode blendMode;
+		Uint8 r, g, b, a;
+		Uint32 key;
+		if (SDL_GetSurfaceBlendMode(surface.get(), &blendMode) == 0) SDL_SetSurfaceBlendMode(view, blendMode);
+		if (SDL_GetSurfaceColorMod(surface.get(), &r, &g, &b) == 0) SDL_SetSurfaceColorMod(view, r, g, b);
+		if (SDL_GetSurfaceAlphaMod(surface.get(), &a) == 0) SDL_SetSurfaceAlphaMod(view, a);
+		if (SDL_GetColorKey(surface.get(), &key) == 0) SDL_SetColorKey(view, SDL_TRUE, key);
+
+		return result;
+	}
+
+#pragma endregion
+
+#pragma region Comparison
+
+	// The pixel hash follows XXH3: eight 64-bit lanes each add the product of the two 32-bit halves of a keyed
+	// word, which SSE2 and NEON compute two lanes at a time, and every lane is scrambled at the end of each row
+	static constexpr Uint64 HASH_PRIME32_1 = 0x9E3779B1u;
+	static constexpr Uint64 HASH_PRIME32_2 = 0x85EBCA77u;
+	static constexpr Uint64 HASH_PRIME32_3 = 0xC2B2AE3Du;
+	static constexpr Uint64 HASH_PRIME64_1 = 0x9E3779B185EBCA87ull;
+	static constexpr Uint64 HASH_PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+	static constexpr Uint64 HASH_PRIME64_3 = 0x165667B19E3779F9ull;
+	static constexpr Uint64 HASH_PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+	static constexpr Uint64 HASH_PRIME64_5 = 0x27D4EB2F165667C5ull;
+
+	alignas(16) static constexpr Uint64 HASH_KEYS[8] = {
+		0xBE4BA423396CFEB8ull, 0x1CAD21F72C81017Cull, 0xDB979083E96DD4DEull, 0x1F67B3B7A4A44072ull,
+		0x78E5C0CC4EE679CBull, 0x2172FFCC7DD05A82ull, 0x8E2443F7744608B8ull, 0x4C263A81E69035E0ull
+	};
+
+	struct PixelHasher
+	{
+		alignas(16) Uint64 acc[8] = {
+			HASH_PRIME32_3, HASH_PRIME64_1, HASH_PRIME64_2, HASH_PRIME64_3,
+			HASH_PRIME64_4, HASH_PRIME32_2, HASH_PRIME64_5, HASH_PRIME32_1
+		};
+
+		// Accumulate 64 bytes
+		inline void Stripe(const Uint8* p)
+		{
+#if defined(SDLPP_SSE2)
+			for (int i = 0; i < 8; i += 2)
+			{
+				const __m128i d = _mm_loadu_si128((const __m128i*)(p + i * 8));
+				const __m128i k = _mm_xor_si128(d, _mm_load_si128((const __m128i*)(HASH_KEYS + i)));
+				const __m128i product = _mm_mul_epu32(k, _mm_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1)));
+				const __m128i a = _mm_add_epi64(_mm_load_si128((const __m128i*)(acc + i)), _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2)));
+				_mm_store_si128((__m128i*)(acc + i), _mm_add_epi64(a, product));
+			}
+#elif defined(SDLPP_NEON)
+			for (int i = 0; i < 8; i += 2)
+			{
+				const uint64x2_t d = vreinterpretq_u64_u8(vld1q_u8(p + i * 8));
+				const uint64x2_t k = veorq_u64(d, vld1q_u64(HASH_KEYS + i));
+				const uint64x2_t a = vaddq_u64(vld1q_u64(acc + i), vextq_u64(d, d, 1));
+				vst1q_u64(acc + i, vmlal_u32(a, vmovn_u64(k), vshrn_n_u64(k, 32)));
+			}
+#else
+			for (int i = 0; i < 8; i++)
+			{
+				Uint64 d;
+				std::memcpy(&d, p + i * 8, sizeof(d));
+				d = SDL_SwapLE64(d);
+				const Uint64 k = d ^ HASH_KEYS[i];
+				acc[i ^ 1] += d;
+				acc[i] += (k & 0xFFFFFFFF) * (k >> 32);
+			}
+#endif
+		}
+
+		// Accumulate a row of n bytes, keeping only the bits of the last byte set in last
+		inline void Row(const Uint8* p, size_t n, Uint8 last = 0xFF)
+		{
+			for (; n > 64 || (n == 64 && last == 0xFF); p += 64, n -= 64) Stripe(p);
+
+			if (n > 0)
+			{
+				alignas(16) Uint8 tail[64] = {};
+				std::memcpy(tail, p, n);
+				tail[n - 1] &= last;
+				Stripe(tail);
+			}
+
+			for (int i = 0; i < 8; i++)
+			{
+				Uint64 a = acc[i];
+				a ^= a >> 47;
+				a ^= HASH_KEYS[i];
+				acc[i] = a * HASH_PRIME32_1;
+			}
+		}
+
+		// The high and low halves of a 128-bit product, folded together
+		static inline Uint64 MulFold(Uint64 a, Uint64 b)
+		{
+			const Uint64 lolo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+			const Uint64 hilo = (a >> 32) * (b & 0xFFFFFFFF);
+			const Uint64 lohi = (a & 0xFFFFFFFF) * (b >> 32);
+			const Uint64 hihi = (a >> 32) * (b >> 32);
+			const Uint64 cross = (lolo >> 32) + (hilo & 0xFFFFFFFF) + lohi;
+			const Uint64 hi = hihi + (hilo >> 32) + (cross >> 32);
+			const Uint64 lo = (cross << 32) | (lolo & 0xFFFFFFFF);
+			return hi ^ lo;
+		}
+
+		inline Uint64 Finish(Uint64 seed) const
+		{
+			Uint64 h = seed * HASH_PRIME64_1;
+			for (int i = 0; i < 8; i += 2) h += MulFold(acc[i] ^ HASH_KEYS[7 - i], acc[i + 1] ^ HASH_KEYS[6 - i]);
+
+			h ^= h >> 37;
+			h *= HASH_PRIME64_3;
+			return h ^ (h >> 32);
+		}
+	};
+
+	Uint64 Surface::Hash() const
+	{
+		if (!surface)
+		{
+			SDL_SetError("Parameter 'surface' is invalid");
+			return 0;
+		}
+
+		SDL_Surface* s = surface.get();
+		if (SDL_LockSurface(s) != 0) return 0;
+
+		// Only the bits of visible pixels in the last byte of a row count, which are the high bits in MSB first formats
+		const int bits = s->w * s->format->BitsPerPixel;
+		const size_t bytes = (size_t)(bits + 7) / 8;
+		const int spare = (8 - bits % 8) % 8;
+		const bool msb = SDL_PIXELORDER(s->format->format) == SDL_BITMAPORDER_1234;
+		const Uint8 last = (Uint8)(msb ? 0xFF << spare : 0xFF >> spare);
+
+		// The unused bits of packed formats without alpha, such as the padding byte of XRGB8888, are left out, as they
+		// are by Diff() and Matches()
+		const SDL_PixelFormat* f = s->format;
+		const Uint32 used = f->Rmask | f->Gmask | f->Bmask | f->Amask;
+		const bool padded = SDL_ISPIXELFORMAT_PACKED(f->format) && (f->BytesPerPixel == 2 || f->BytesPerPixel == 4)
+			&& used != (f->BytesPerPixel == 2 ? 0xFFFFu : 0xFFFFFFFFu);
+
+		PixelHasher hasher;
+		if (padded)
+		{
+			std::vector<Uint8> row(bytes);
+			for (int y = 0; y < s->h; y++)
+			{
+				const Uint8* src = Row<const Uint8>(s, y);
+				if (f->BytesPerPixel == 2)
+				{
+					for (size_t i = 0; i < bytes; i += 2)
+					{
+						Uint16 p;
+						std::memcpy(&p, src + i, 2);
+						p &= (Uint16)used;
+						std::memcpy(row.data() + i, &p, 2);
+					}
+				}
+				else
+				{
+					for (size_t i = 0; i < bytes; i += 4)
+					{
+						Uint32 p;
+						std::memcpy(&p, src + i, 4);
+						p &= used;
+						std::memcpy(row.data() + i, &p, 4);
+					}
+				}
+				hasher.Row(row.data(), bytes);
+			}
+		}
+		else for (int y = 0; y < s->h; y++) hasher.Row(Row<const Uint8>(s, y), bytes, last);
+
+		SDL_UnlockSurface(s);
+
+		if (s->format->palette != NULL && s->format->palette->ncolors > 0)
+			hasher.Row((const Uint8*)s->format->palette->colors, (size_t)s->format->palette->ncolors * sizeof(SDL_Color));
+
+		const Uint64 seed = (((Uint64)(Uint32)s->w << 32) | (Uint32)s->h) ^ ((Uint64)s->format->format * HASH_PRIME64_2);
+		return hasher.Finish(seed);
+	}
+
+	// The number of set bits in a 4-bit mask
+	static inline int PopCount4(int bits) { return (int)((0x4332322132212110ull >> (bits * 4)) & 0xF); }
+
+	// Two surfaces of the same size in the same 8888 format, ready for comparison
+	struct ComparePair
+	{
+		Surface a = Surface::FromPtr(NULL), b = Surface::FromPtr(NULL);
+		bool premultipliedA = false, premultipliedB = false;
+		int channel[4] = { 0, 1, 2, 3 }; // The byte of red, green, blue and alpha in a pixel; alpha is -1 if there is none
+		Uint32 ignore = 0;               // The bits of the padding byte, for formats without alpha
+
+		bool Prepare(const Surface& first, const Surface& second)
+		{
+			if (!first.surface || !second.surface)
+			{
+				SDL_SetError("Parameter '%s' is invalid", first.surface ? "other" : "surface");
+				return false;
+			}
+
+			if (first.surface->w != second.surface->w || first.surface->h != second.surface->h)
+			{
+				SDL_SetError("Surfaces of different sizes cannot be compared");
+				return false;
+			}
+
+			a = first;
+			b = second;
+			premultipliedA = first.IsPremultiplied();
+			premultipliedB = second.IsPremultiplied();
+
+			// Anything but two surfaces in one 8888 format is compared in RGBA32
+			const SDL_PixelFormat* fa = first.surface->format;
+			if (fa->format != second.surface->format->format || !Is8888(fa))
+			{
+				if (fa->format != SDL_PIXELFORMAT_RGBA32) a = Surface::FromPtr(SDL_ConvertSurfaceFormat(first.surface.get(), SDL_PIXELFORMAT_RGBA32, 0));
+				if (second.surface->format->format != SDL_PIXELFORMAT_RGBA32) b = Surface::FromPtr(SDL_ConvertSurfaceFormat(second.surface.get(), SDL_PIXELFORMAT_RGBA32, 0));
+				if (!a.surface || !b.surface) return false;
+			}
+
+			const SDL_PixelFormat* f = a.surface->format;
+			channel[0] = f->Rshift / 8;
+			channel[1] = f->Gshift / 8;
+			channel[2] = f->Bshift / 8;
+			channel[3] = AlphaChannel(f);
+			if (channel[3] < 0) ignore = 0xFFu << ((6 - channel[0] - channel[1] - channel[2]) * 8);
+
+			return true;
+		}
+
+		bool Lock()
+		{
+			if (SDL_LockSurface(a.surface.get()) != 0) return false;
+			if (SDL_LockSurface(b.surface.get()) == 0) return true;
+			SDL_UnlockSurface(a.surface.get());
+			return false;
+		}
+
+		void Unlock()
+		{
+			SDL_UnlockSurface(b.surface.get());
+			SDL_UnlockSurface(a.surface.get());
+		}
+	};
+
+	// Add the absolute difference of each byte of two rows to sum and max, indexed by byte, and set flags to 255
+	// for pixels that differ and 0 for the rest if it is not NULL. Returns the number of pixels that differ
+	static int DiffRow(const Uint32* a, const Uint32* b, int w, Uint32 ignore, Uint64* sum, Uint8* max, Uint8* flags)
+	{
+		int x = 0, count = 0;
+
+#if defined(SDLPP_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i ones = _mm_set1_epi32(-1);
+		const __m128i keep = _mm_set1_epi32((int)~ignore);
+		const __m128i mask0 = _mm_set1_epi32(0xFF), mask1 = _mm_slli_epi32(mask0, 8), mask2 = _mm_slli_epi32(mask0, 16), mask3 = _mm_slli_epi32(mask0, 24);
+		__m128i vmax = zero, sum0 = zero, sum1 = zero, sum2 = zero, sum3 = zero;
+
+		for (; x + 4 <= w; x += 4)
+		{
+			const __m128i pa = _mm_loadu_si128((const __m128i*)(a + x));
+			const __m128i pb = _mm_loadu_si128((const __m128i*)(b + x));
+			const __m128i d = _mm_and_si128(_mm_or_si128(_mm_subs_epu8(pa, pb), _mm_subs_epu8(pb, pa)), keep);
+
+			vmax = _mm_max_epu8(vmax, d);
+			sum0 = _mm_add_epi64(sum0, _mm_sad_epu8(_mm_and_si128(d, mask0), zero));
+			sum1 = _mm_add_epi64(sum1, _mm_sad_epu8(_mm_and_si128(d, mask1), zero));
+			sum2 = _mm_add_epi64(sum2, _mm_sad_epu8(_mm_and_si128(d, mask2), zero));
+			sum3 = _mm_add_epi64(sum3, _mm_sad_epu8(_mm_and_si128(d, mask3), zero));
+
+			const __m128i same = _mm_cmpeq_epi32(d, zero);
+			count += 4 - PopCount4(_mm_movemask_ps(_mm_castsi128_ps(same)));
+
+			if (flags != NULL)
+			{
+				const __m128i differ = _mm_xor_si128(same, ones);
+				const __m128i packed = _mm_packs_epi16(_mm_packs_epi32(differ, differ), zero);
+				const int v = _mm_cvtsi128_si32(packed);
+				std::memcpy(flags + x, &v, 4);
+			}
+		}
+
+		alignas(16) Uint8 bytes[16];
+		alignas(16) Uint64 sums[8];
+		_mm_store_si128((__m128i*)bytes, vmax);
+		_mm_store_si128((__m128i*)sums + 0, sum0);
+		_mm_store_si128((__m128i*)sums + 1, sum1);
+		_mm_store_si128((__m128i*)sums + 2, sum2);
+		_mm_store_si128((__m128i*)sums + 3, sum3);
+		for (int i = 0; i < 16; i++) max[i % 4] = std::max(max[i % 4], bytes[i]);
+		for (int c = 0; c < 4; c++) sum[c] += sums[c * 2] + sums[c * 2 + 1];
+#elif defined(SDLPP_NEON)
+		const uint8x16_t keep = vreinterpretq_u8_u32(vdupq_n_u32(~ignore));
+		uint8x16_t vmax = vdupq_n_u8(0);
+		uint32x4_t vsum = vdupq_n_u32(0), vcount = vdupq_n_u32(0);
+
+		while (x + 4 <= w)
+		{
+			// Byte lanes keep their channel in 16-bit sums, which are widened before they can overflow
+			uint16x8_t lo = vdupq_n_u16(0), hi = vdupq_n_u16(0);
+			for (int n = 0; n < 256 && x + 4 <= w; n++, x += 4)
+			{
+				const uint8x16_t d = vandq_u8(vabdq_u8(vld1q_u8((const Uint8*)(a + x)), vld1q_u8((const Uint8*)(b + x))), keep);
+				vmax = vmaxq_u8(vmax, d);
+				lo = vaddw_u8(lo, vget_low_u8(d));
+				hi = vaddw_u8(hi, vget_high_u8(d));
+
+				const uint32x4_t same = vceqq_u32(vreinterpretq_u32_u8(d), vdupq_n_u32(0));
+				vcount = vsubq_u32(vcount, vmvnq_u32(same));
+
+				if (flags != NULL)
+				{
+					const uint8x8_t packed = vmovn_u16(vcombine_u16(vmovn_u32(vmvnq_u32(same)), vdup_n_u16(0)));
+					vst1_lane_u32((uint32_t*)(flags + x), vreinterpret_u32_u8(packed), 0);
+				}
+			}
+
+			vsum = vaddq_u32(vsum, vaddq_u32(vaddl_u16(vget_low_u16(lo), vget_high_u16(lo)), vaddl_u16(vget_low_u16(hi), vget_high_u16(hi))));
+		}
+
+		Uint8 bytes[16];
+		Uint32 sums[4], counts[4];
+		vst1q_u8(bytes, vmax);
+		vst1q_u32(sums, vsum);
+		vst1q_u32(counts, vcount);
+		for (int i = 0; i < 16; i++) max[i % 4] = std::max(max[i % 4], bytes[i]);
+		for (int c = 0; c < 4; c++)
+		{
+			sum[c] += sums[c];
+			count += (int)counts[c];
+		}
+#endif
+
+		for (; x < w; x++)
+		{
+			const Uint32 pa = a[x] & ~ignore, pb = b[x] & ~ignore;
+			for (int c = 0; c < 4; c++)
+			{
+				const int ca = (pa >> (c * 8)) & 0xFF, cb = (pb >> (c * 8)) & 0xFF;
+				const Uint8 d = (Uint8)(ca > cb ? ca - cb : cb - ca);
+				sum[c] += d;
+				max[c] = std::max(max[c], d);
+			}
+
+			if (pa != pb) count++;
+			if (flags != NULL) flags[x] = pa != pb ? 0xFF : 0;
+		}
+
+		return count;
+	}
+
+	// Weights of the YIQ colour difference, as used by pixelmatch, and the largest difference possible
+	static constexpr float YIQ_Y = 0.5053f, YIQ_I = 0.299f, YIQ_Q = 0.1957f;
+	static constexpr float YIQ_MAX_DELTA = 35215.0f;
+
+	// Clear flags for pixels whose perceptual difference is at most limit. Returns the number of pixels still flagged
+	static int PerceptualRow(const Uint32* a, const Uint32* b, int w, const ComparePair& pair, float limit, Uint8* flags)
+	{
+		const int* ch = pair.channel;
+		int x = 0, count = 0;
+
+#if defined(SDLPP_SSE2)
+		const __m128i byte = _mm_set1_epi32(0xFF);
+		const __m128 white = _mm_set1_ps(255.0f), scale = _mm_set1_ps(1.0f / 255.0f), vlimit = _mm_set1_ps(limit);
+
+		// Blend a channel over white: c + (255 - a) if premultiplied, or 255 + (c - 255) * a / 255
+		const auto channel = [&](__m128i p, int c) { return _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(p, _mm_cvtsi32_si128(c * 8)), byte)); };
+		const auto blend = [&](__m128 c, __m128 alpha, bool premultiplied)
+		{
+			return premultiplied ? _mm_add_ps(c, _mm_sub_ps(white, alpha)) : _mm_add_ps(white, _mm_mul_ps(_mm_sub_ps(c, white), _mm_mul_ps(alpha, scale)));
+		};
+
+		for (; x + 4 <= w; x += 4)
+		{
+			const __m128i pa = _mm_loadu_si128((const __m128i*)(a + x));
+			const __m128i pb = _mm_loadu_si128((const __m128i*)(b + x));
+			const __m128 aa = ch[3] < 0 ? white : channel(pa, ch[3]);
+			const __m128 ab = ch[3] < 0 ? white : channel(pb, ch[3]);
+
+			const __m128 dr = _mm_sub_ps(blend(channel(pa, ch[0]), aa, pair.premultipliedA), blend(channel(pb, ch[0]), ab, pair.premultipliedB));
+			const __m128 dg = _mm_sub_ps(blend(channel(pa, ch[1]), aa, pair.premultipliedA), blend(channel(pb, ch[1]), ab, pair.premultipliedB));
+			const __m128 db = _mm_sub_ps(blend(channel(pa, ch[2]), aa, pair.premultipliedA), blend(channel(pb, ch[2]), ab, pair.premultipliedB));
+
+			const __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, _mm_set1_ps(0.29889531f)), _mm_mul_ps(dg, _mm_set1_ps(0.58662247f))), _mm_mul_ps(db, _mm_set1_ps(0.11448223f)));
+			const __m128 i = _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(dr, _mm_set1_ps(0.59597799f)), _mm_mul_ps(dg, _mm_set1_ps(0.27417610f))), _mm_mul_ps(db, _mm_set1_ps(0.32180189f)));
+			const __m128 q = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(dr, _mm_set1_ps(0.21147017f)), _mm_mul_ps(dg, _mm_set1_ps(0.52261711f))), _mm_mul_ps(db, _mm_set1_ps(0.31114694f)));
+			const __m128 delta = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(YIQ_Y), _mm_mul_ps(y, y)), _mm_mul_ps(_mm_set1_ps(YIQ_I), _mm_mul_ps(i, i))), _mm_mul_ps(_mm_set1_ps(YIQ_Q), _mm_mul_ps(q, q)));
+
+			const __m128i over = _mm_castps_si128(_mm_cmpgt_ps(delta, vlimit));
+			count += PopCount4(_mm_movemask_ps(_mm_castsi128_ps(over)));
+
+			const int v = _mm_cvtsi128_si32(_mm_packs_epi16(_mm_packs_epi32(over, over), over));
+			int f;
+			std::memcpy(&f, flags + x, 4);
+			f &= v;
+			std::memcpy(flags + x, &f, 4);
+		}
+#elif defined(SDLPP_NEON)
+		const uint32x4_t byte = vdupq_n_u32(0xFF);
+		const float32x4_t white = vdupq_n_f32(255.0f), vlimit = vdupq_n_f32(limit);
+
+		const auto channel = [&](uint32x4_t p, int c) { return vcvtq_f32_u32(vandq_u32(vshlq_u32(p, vdupq_n_s32(-c * 8)), byte)); };
+		const auto blend = [&](float32x4_t c, float32x4_t alpha, bool premultiplied)
+		{
+			return premultiplied ? vaddq_f32(c, vsubq_f32(white, alpha)) : vmlaq_f32(white, vsubq_f32(c, white), vmulq_n_f32(alpha, 1.0f / 255.0f));
+		};
+
+		uint32x4_t vcount = vdupq_n_u32(0);
+		for (; x + 4 <= w; x += 4)
+		{
+			const uint32x4_t pa = vld1q_u32(a + x);
+			const uint32x4_t pb = vld1q_u32(b + x);
+			const float32x4_t aa = ch[3] < 0 ? white : channel(pa, ch[3]);
+			const float32x4_t ab = ch[3] < 0 ? white : channel(pb, ch[3]);
+
+			const float32x4_t dr = vsubq_f32(blend(channel(pa, ch[0]), aa, pair.premultipliedA), blend(channel(pb, ch[0]), ab, pair.premultipliedB));
+			const float32x4_t dg = vsubq_f32(blend(channel(pa, ch[1]), aa, pair.premultipliedA), blend(channel(pb, ch[1]), ab, pair.premultipliedB));
+			const float32x4_t db = vsubq_f32(blend(channel(pa, ch[2]), aa, pair.premultipliedA), blend(channel(pb, ch[2]), ab, pair.premultipliedB));
+
+			const float32x4_t y = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(dr, 0.29889531f), dg, 0.58662247f), db, 0.11448223f);
+			const float32x4_t i = vmlsq_n_f32(vmlsq_n_f32(vmulq_n_f32(dr, 0.59597799f), dg, 0.27417610f), db, 0.32180189f);
+			const float32x4_t q = vmlaq_n_f32(vmlsq_n_f32(vmulq_n_f32(dr, 0.21147017f), dg, 0.52261711f), db, 0.31114694f);
+			const float32x4_t delta = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(vmulq_f32(y, y), YIQ_Y), vmulq_f32(i, i), YIQ_I), vmulq_f32(q, q), YIQ_Q);
+
+			const uint32x4_t over = vcgtq_f32(delta, vlimit);
+			vcount = vsubq_u32(vcount, over);
+
+			const uint8x8_t packed = vmovn_u16(vcombine_u16(vmovn_u32(over), vdup_n_u16(0)));
+			const uint32x2_t f = vand_u32(vld1_dup_u32((const uint32_t*)(flags + x)), vreinterpret_u32_u8(packed));
+			vst1_lane_u32((uint32_t*)(flags + x), f, 0);
+		}
+
+		Uint32 counts[4];
+		vst1q_u32(counts, vcount);
+		count = (int)(counts[0] + counts[1] + counts[2] + counts[3]);
+#endif
+
+		for (; x < w; x++)
+		{
+			const auto blend = [&](Uint32 p, int c, bool premultiplied)
+			{
+				const float v = (float)((p >> (ch[c] * 8)) & 0xFF);
+				const float alpha = ch[3] < 0 ? 255.0f : (float)((p >> (ch[3] * 8)) & 0xFF);
+				return premultiplied ? v + (255.0f - alpha) : 255.0f + (v - 255.0f) * (alpha * (1.0f / 255.0f));
+			};
+
+			const float dr = blend(a[x], 0, pair.premultipliedA) - blend(b[x], 0, pair.premultipliedB);
+			const float dg = blend(a[x], 1, pair.premultipliedA) - blend(b[x], 1, pair.premultipliedB);
+			const float db = blend(a[x], 2, pair.premultipliedA) - blend(b[x], 2, pair.premultipliedB);
+
+			const float y = dr * 0.29889531f + dg * 0.58662247f + db * 0.11448223f;
+			const float i = dr * 0.59597799f - dg * 0.27417610f - db * 0.32180189f;
+			const float q = dr * 0.21147017f - dg * 0.52261711f + db * 0.31114694f;
+			const float delta = YIQ_Y * y * y + YIQ_I * i * i + YIQ_Q * q * q;
+
+			if (delta <= limit) flags[x] = 0;
+			else count++;
+		}
+
+		return count;
+	}
+
+	bool Surface::Diff(const Surface& other, SurfaceDiff& result, float threshold, bool mask) const
+	{
+		result = SurfaceDiff();
+
+		ComparePair pair;
+		if (!pair.Prepare(*this, other)) return false;
+
+		const int w = surface->w, h = surface->h;
+		if (mask)
+		{
+			result.mask = Surface(w, h, SDL_PIXELFORMAT_INDEX8);
+			if (!result.mask.surface) return false;
+
+			SDL_Color grey[256];
+			for (int i = 0; i < 256; i++) grey[i] = { (Uint8)i, (Uint8)i, (Uint8)i, 255 };
+			SDL_SetPaletteColors(result.mask.surface->format->palette, grey, 0, 256);
+		}
+
+		if (!pair.Lock()) return false;
+
+		// The perceptual test needs the exact flags of each row, so it uses a scratch row if no mask was asked for
+		const bool perceptual = threshold > 0.0f;
+		const float limit = YIQ_MAX_DELTA * threshold * threshold;
+		std::vector<Uint8> scratch(perceptual && !mask ? (size_t)w : 0);
+
+		Uint64 sum[4] = { 0, 0, 0, 0 };
+		Uint8 max[4] = { 0, 0, 0, 0 };
+		for (int y = 0; y < h; y++)
+		{
+			const Uint32* ra = Row<const Uint32>(pair.a.surface.get(), y);
+			const Uint32* rb = Row<const Uint32>(pair.b.surface.get(), y);
+			Uint8* flags = mask ? Row<Uint8>(result.mask.surface.get(), y) : scratch.empty() ? NULL : scratch.data();
+
+			const int count = DiffRow(ra, rb, w, pair.ignore, sum, max, flags);
+			result.differing += perceptual && count > 0 ? PerceptualRow(ra, rb, w, pair, limit, flags) : count;
+		}
+
+		pair.Unlock();
+
+		const double pixels = std::max((double)w * h, 1.0);
+		for (int c = 0; c < 4; c++)
+		{
+			const int byte = pair.channel[c];
+			if (byte < 0) continue;
+			result.maxError[c] = max[byte];
+			result.meanError[c] = sum[byte] / pixels;
+		}
+
+		return true;
+	}
+
+	bool Surface::Matches(const Surface& other, float threshold) const
+	{
+		ComparePair pair;
+		if (!pair.Prepare(*this, other) || !pair.Lock()) return false;
+
+		const int w = pair.a.surface->w, h = pair.a.surface->h;
+		const bool perceptual = threshold > 0.0f;
+		const float limit = YIQ_MAX_DELTA * threshold * threshold;
+		std::vector<Uint8> flags(perceptual ? (size_t)w : 0);
+
+		// Rows are compared with memcmp first, so the kernels only run on rows that differ
+		bool matches = true;
+		for (int y = 0; y < h && matches; y++)
+		{
+			const Uint32* ra = Row<const Uint32>(pair.a.surface.get(), y);
+			const Uint32* rb = Row<const Uint32>(pair.b.surface.get(), y);
+			if (std::memcmp(ra, rb, (size_t)w * sizeof(Uint32)) == 0) continue;
+
+			Uint64 sum[4] = { 0, 0, 0, 0 };
+			Uint8 max[4] = { 0, 0, 0, 0 };
+			const int count = DiffRow(ra, rb, w, pair.ignore, sum, max, perceptual ? flags.data() : NULL);
+			matches = count == 0 || (perceptual && PerceptualRow(ra, rb, w, pair, limit, flags.data()) == 0);
+		}
+
+		pair.Unlock();
+
+		return matches;
+	}
+
+#pragma endregion
+
+#pragma region Mipmapping
+
+	// Expand a row of 8888 pixels into 14-bit channels in the filtering space
+	static void DecodeMipRow(const Uint32* src, int w, Uint16* dst, int alpha, FilterSpace space)
+	{
+		const LinearLUT& lut = GetLinearLUT();
+
+		for (int x = 0; x < w; x++, dst += 4)
+		{
+			const Uint32 p = src[x];
+			const Uint32 a = alpha < 0 ? 255 : (p >> (alpha * 8)) & 0xFF;
+
+			for (int c = 0; c < 4; c++)
+			{
+				const Uint32 v = (p >> (c * 8)) & 0xFF;
+
+				if (c == alpha || space == FilterSpace::STRAIGHT) dst[c] = (Uint16)(v << 6);
+				else if (space == FilterSpace::PREMULTIPLIED) dst[c] = (Uint16)((v * a) >> 2);
+				else dst[c] = (Uint16)((lut.toLinear[v] * a + 127) / 255);
+			}
+		}
+	}
+
+	// Average 2x2 blocks of two expanded rows into a row of half the width
+	static void BoxFilterRows(const Uint16* r0, const Uint16* r1, int w, Uint16* dst)
+	{
+		const int dw = std::max(1, w / 2);
+		int x = 0;
+
+		if (w >= 2)
+		{
+#if defined(SDLPP_SSE2)
+			const __m128i two = _mm_set1_epi16(2);
+			for (; x + 2 <= dw; x += 2)
+			{
+				const __m128i s0 = _mm_add_epi16(_mm_loadu_si128((const __m128i*)(r0 + x * 8    )), _mm_loadu_si128((const __m128i*)(r1 + x * 8    )));
+				const __m128i s1 = _mm_add_epi16(_mm_loadu_si128((const __m128i*)(r0 + x * 8 + 8)), _mm_loadu_si128((const __m128i*)(r1 + x * 8 + 8)));
+				const __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+				_mm_storeu_si128((__m128i*)(dst + x * 4), _mm_srli_epi16(_mm_add_epi16(sum, two), 2));
+			}
+#elif defined(SDLPP_NEON)
+			const uint16x8_t two = vdupq_n_u16(2);
+			for (; x + 2 <= dw; x += 2)
+			{
+				const uint16x8_t s0 = vaddq_u16(vld1q_u16(r0 + x * 8    ), vld1q_u16(r1 + x * 8    ));
+				const uint16x8_t s1 = vaddq_u16(vld1q_u16(r0 + x * 8 + 8), vld1q_u16(r1 + x * 8 + 8));
+				const uint16x8_t sum = vaddq_u16(vcombine_u16(vget_low_u16(s0), vget_low_u16(s1)), vcombine_u16(vget_high_u16(s0), vget_high_u16(s1)));
+				vst1q_u16(dst + x * 4, vshrq_n_u16(vaddq_u16(sum, two), 2));
+			}
+#endif
+		}
+
+		for (; x < dw; x++)
+		{
+			const int x0 = x * 2 * 4;
+			const int x1 = std::min(x * 2 + 1, w - 1) * 4;
+			for (int c = 0; c < 4; c++)
+				dst[x * 4 + c] = (Uint16)((r0[x0 + c] + r0[x1 + c] + r1[x0 + c] + r1[x1 + c] + 2) >> 2);
+		}
+	}
+
+	// Pack a row of 14-bit channels in the filtering space back into 8888 pixels
+	static void EncodeMipRow(const Uint16* src, int w, Uint32* dst, int alpha, FilterSpace space)
+	{
+		const LinearLUT& lut = GetLinearLUT();
+
+		for (int x = 0; x < w; x++, src += 4)
+		{
+			const Uint32 a = alpha < 0 ? 16383 : src[alpha];
+			Uint32 p = 0;
+
+			if (space != FilterSpace::STRAIGHT && a == 0)
+			{
+				dst[x] = 0;
+				continue;
+			}
+
+			for (int c = 0; c < 4; c++)
+			{
+				Uint32 v;
+
+				if (c == alpha || space == FilterSpace::STRAIGHT) v = (src[c] + 32) >> 6;
+				else if (space == FilterSpace::PREMULTIPLIED) v = std::min(255u, ((Uint32)src[c] * 256 + a / 2) / a);
+				else v = lut.toSRGB[std::min(16383u, ((Uint32)src[c] * 16383 + a / 2) / a)];
+
+				p |= std::min(v, 255u) << (c * 8);
+			}
+
+			dst[x] = p;
+		}
+	}
+
+	std::vector<Surface> Surface::BuildMipChain(FilterSpace space, int max_levels) const
+	{
+		std::vector<Surface> chain;
+
+		if (!surface)
+		{
+			SDL_SetError("Parameter 'surface' is invalid");
+			return chain;
+		}
+
+		Surface base = *this;
+		if (!Is8888(surface->format))
+		{
+			base = FromPtr(SDL_ConvertSurfaceFormat(surface.get(), SDL_PIXELFORMAT_ARGB8888, 0));
+			if (!base.surface) return chain;
+			base.SetPremultiplied(IsPremultiplied());
+		}
+
+		// Premultiplied channels already carry their alpha weighting, so they are averaged directly
+		if (IsPremultiplied()) space = FilterSpace::STRAIGHT;
+
+		SDL_BlendMode blendMode = SDL_BLENDMODE_NONE;
+		SDL_GetSurfaceBlendMode(surface.get(), &blendMode);
+
+		const Uint32 format = base.surface->format->format;
+		const int alpha = AlphaChannel(base.surface->format);
+		if (alpha < 0 && space == FilterSpace::PREMULTIPLIED) space = FilterSpace::STRAIGHT;
+
+		chain.push_back(base);
+
+		std::vector<Uint16> rows[2];
+		std::vector<Uint16> out;
+
+		while (max_levels <= 0 || (int)chain.size() < max_levels)
+		{
+			Surface& src = chain.back();
+			const int w = src.surface->w;
+			const int h = src.surface->h;
+			if (w <= 1 && h <= 1) break;
+
+			const int dw = std::max(1, w / 2);
+			const int dh = std::max(1, h / 2);
+
+			Surface dst = FromPtr(SDL_CreateRGBSurfaceWithFormat(0, dw, dh, 32, format));
+			if (!dst.surface) return {};
+			SDL_SetSurfaceBlendMode(dst.surface.get(), blendMode);
+			dst.SetPremultiplied(IsPremultiplied());
+
+			rows[0].resize((size_t)w * 4);
+			rows[1].resize((size_t)w * 4);
+			out.resize((size_t)dw * 4);
+
+			if (SDL_LockSurface(src.surface.get()) != 0) return {};
+
+			for (int y = 0; y < dh; y++)
+			{
+				const int y0 = y * 2;
+				const int y1 = std::min(y0 + 1, h - 1);
+
+				DecodeMipRow(Row<const Uint32>(src.surface.get(), y0), w, rows[0].data(), alpha, space);
+				if (y1 != y0) DecodeMipRow(Row<const Uint32>(src.surface.get(), y1), w, rows[1].data(), alpha, space);
+
+				BoxFilterRows(rows[0].data(), y1 != y0 ? rows[1].data() : rows[0].data(), w, out.data());
+				EncodeMipRow(out.data(), dw, Row<Uint32>(dst.surface.get(), y), alpha, space);
+			}
+
+			SDL_UnlockSurface(src.surface.get());
+
+			chain.push_back(dst);
+		}
+
+		return chain;
+	}
+
+#pragma endregion
+
+#pragma region Premultiplied Alpha
+
+	// Multiply the colour channels of a row of 8888 pixels by the alpha stored in channel A
+	template <int A>
+	static void PremultiplyRow(Uint32* px, int w)
+	{
+		int x = 0;
+
+#if defined(SDLPP_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i amask = _mm_set1_epi32((int)(0xFFu << (A * 8)));
+		for (; x + 4 <= w; x += 4)
+		{
+			const __m128i p = _mm_loadu_si128((const __m128i*)(px + x));
+			const __m128i lo = _mm_unpacklo_epi8(p, zero);
+			const __m128i hi = _mm_unpackhi_epi8(p, zero);
+			const __m128i mlo = Div255(_mm_mullo_epi16(lo, BroadcastChannel<A>(lo)));
+			const __m128i mhi = Div255(_mm_mullo_epi16(hi, BroadcastChannel<A>(hi)));
+			const __m128i r = _mm_packus_epi16(mlo, mhi);
+			_mm_storeu_si128((__m128i*)(px + x), _mm_or_si128(_mm_and_si128(p, amask), _mm_andnot_si128(amask, r)));
+		}
+#elif defined(SDLPP_NEON)
+		for (; x + 8 <= w; x += 8)
+		{
+			uint8x8x4_t p = vld4_u8((const uint8_t*)(px + x));
+			for (int c = 0; c < 4; c++)
+				if (c != A) p.val[c] = Div255(vmull_u8(p.val[c], p.val[A]));
+			vst4_u8((uint8_t*)(px + x), p);
+		}
+#endif
+
+		for (; x < w; x++)
+		{
+			const Uint32 p = px[x];
+			const Uint32 a = (p >> (A * 8)) & 0xFF;
+			Uint32 r = p & (0xFFu << (A * 8));
+			for (int c = 0; c < 4; c++)
+				if (c != A) r |= Div255(((p >> (c * 8)) & 0xFF) * a) << (c * 8);
+			px[x] = r;
+		}
+	}
+
+	// Composite a row of premultiplied pixels over a row of any 8888 format, applying colour and alpha modulation
+	static void BlendRowPremultipliedGeneric(const Uint32* src, const SDL_PixelFormat* sf, Uint32* dst, const SDL_PixelFormat* df, int w, bool add, const Uint8 mod[4])
+	{
+		const int sshift[4] = { sf->Rshift, sf->Gshift, sf->Bshift, sf->Ashift };
+		const int dshift[4] = { df->Rshift, df->Gshift, df->Bshift, df->Ashift };
+		const bool dalpha = df->Amask != 0;
+
+		for (int x = 0; x < w; x++)
+		{
+			Uint32 s[4], d[4];
+			for (int c = 0; c < 4; c++)
+			{
+				s[c] = (src[x] >> sshift[c]) & 0xFF;
+				d[c] = dalpha || c < 3 ? (dst[x] >> dshift[c]) & 0xFF : 255;
+			}
+
+			// Colour modulation scales RGB, while alpha modulation scales every premultiplied channel
+			for (int c = 0; c < 3; c++) s[c] = Div255(Div255(s[c] * mod[c]) * mod[3]);
+			s[3] = Div255(s[3] * mod[3]);
+
+			const Uint32 inv = 255 - s[3];
+			Uint32 r = dalpha ? 0 : dst[x] & ~(df->Rmask | df->Gmask | df->Bmask);
+			for (int c = 0; c < 4; c++)
+			{
+				if (c == 3 && !dalpha) break;
+				Uint32 v;
+				if (add) v = c == 3 ? d[c] : std::min(255u, s[c] + d[c]);
+				else v = std::min(255u, s[c] + Div255(d[c] * inv));
+				r |= v << dshift[c];
+			}
+			dst[x] = r;
+		}
+	}
+
+	// Clip the same way SDL_BlitSurface() does: first to the source, then to the destination's clip rectangle.
+	// Fills in dstrect with the final rectangle, and returns false if nothing is left to draw
+	static bool ClipBlit(const SDL_Surface* src, const Rect* srcrect, const SDL_Surface* dst, Rect* dstrect, SDL_Rect& sr, SDL_Rect& dr)
+	{
+		sr = srcrect ? *(const SDL_Rect*)srcrect : SDL_Rect{ 0, 0, src->w, src->h };
+		dr = { dstrect ? dstrect->x : 0, dstrect ? dstrect->y : 0, 0, 0 };
+
+		if (sr.x < 0) { sr.w += sr.x; dr.x -= sr.x; sr.x = 0; }
+		if (sr.y < 0) { sr.h += sr.y; dr.y -= sr.y; sr.y = 0; }
+		sr.w = std::min(sr.w, src->w - sr.x);
+		sr.h = std::min(sr.h, src->h - sr.y);
+
+		const SDL_Rect& clip = dst->clip_rect;
+		int d;
+		if ((d = clip.x - dr.x) > 0) { sr.w -= d; sr.x += d; dr.x += d; }
+		if ((d = clip.y - dr.y) > 0) { sr.h -= d; sr.y += d; dr.y += d; }
+		if ((d = dr.x + sr.w - clip.x - clip.w) > 0) sr.w -= d;
+		if ((d = dr.y + sr.h - clip.y - clip.h) > 0) sr.h -= d;
+
+		dr.w = std::max(sr.w, 0);
+		dr.h = std::max(sr.h, 0);
+		if (dstrect) *(SDL_Rect*)dstrect = dr;
+		return dr.w > 0 && dr.h > 0;
+	}
+
+	// Stretch the stored values of a surface into a temporary surface the size of dstrect with SDL's scaler, then
+	// composite that with the surface's blending state through blit
+	static bool BlitScaledVia(const Surface& src, const Rect* srcrect, Surface& dst, Rect* dstrect, bool (Surface::*blit)(const Rect*, Surface&, Rect*) const)
+	{
+		SDL_Surface* surface = src.surface.get();
+		if (!surface || !dst.surface)
+		{
+			SDL_SetError("Parameter '%s' is invalid", surface ? "dst" : "surface");
+			return false;
+		}
+
+		const SDL_Rect sr = srcrect ? *(const SDL_Rect*)srcrect : SDL_Rect{ 0, 0, surface->w, surface->h };
+		SDL_Rect dr = dstrect ? *(const SDL_Rect*)dstrect : SDL_Rect{ 0, 0, dst.surface->w, dst.surface->h };
+
+		if (sr.w == dr.w && sr.h == dr.h) return (src.*blit)(srcrect, dst, dstrect);
+		if (dr.w <= 0 || dr.h <= 0 || sr.w <= 0 || sr.h <= 0)
+		{
+			if (dstrect) dstrect->w = dstrect->h = 0;
+			return true;
+		}
+
+		Surface scaled = Surface::FromPtr(SDL_CreateRGBSurfaceWithFormat(0, dr.w, dr.h, surface->format->BitsPerPixel, surface->format->format));
+		if (!scaled.surface) return false;
+		scaled.SetPremultiplied(src.IsPremultiplied());
+		if (surface->format->palette != NULL) SDL_SetSurfacePalette(scaled.surface.get(), surface->format->palette);
+
+		// Stretch from a second SDL_Surface over the same pixels, with no blending, key or mods, so the source's own
+		// state is never changed
+		if (SDL_LockSurface(surface) != 0) return false;
+
+		SDL_Surface* view = SDL_CreateRGBSurfaceWithFormatFrom(surface->pixels, surface->w, surface->h, surface->format->BitsPerPixel, surface->pitch, surface->format->format);
+		bool stretched = false;
+		if (view != NULL)
+		{
+			if (surface->format->palette != NULL) SDL_SetSurfacePalette(view, surface->format->palette);
+			SDL_SetSurfaceBlendMode(view, SDL_BLENDMODE_NONE);
+			stretched = SDL_BlitScaled(view, &sr, scaled.surface.get(), NULL) == 0;
+			SDL_FreeSurface(view);
+		}
+
+		SDL_UnlockSurface(surface);
+		if (!stretched) return false;
+
+		SDL_BlendMode blendMode = SDL_BLENDMODE_NONE;
+		Uint8 r = 255, g = 255, b = 255, a = 255;
+		Uint32 key;
+		SDL_GetSurfaceBlendMode(surface, &blendMode);
+		SDL_GetSurfaceColorMod(surface, &r, &g, &b);
+		SDL_GetSurfaceAlphaMod(surface, &a);
+
+		SDL_SetSurfaceBlendMode(scaled.surface.get(), blendMode);
+		SDL_SetSurfaceColorMod(scaled.surface.get(), r, g, b);
+		SDL_SetSurfaceAlphaMod(scaled.surface.get(), a);
+		if (SDL_GetColorKey(surface, &key) == 0) SDL_SetColorKey(scaled.surface.get(), SDL_TRUE, key);
+
+		return (scaled.*blit)(NULL, dst, dstrect);
+	}
+
+	bool Surface::Premultiply()
+	{
+		if (!surface)
+		{
+			SDL_SetError("Parameter 'surface' is invalid");
+			return false;
+		}
+
+		if (IsPremultiplied()) return true;
+
+		const SDL_PixelFormat* format = surface->format;
+		if (format->palette != NULL)
+		{
+			for (int i = 0; i < format->palette->ncolors; i++)
+			{
+				if (format->palette->colors[i].a != 255)
+				{
+					SDL_SetError("Paletted surfaces with translucent colours cannot be premultiplied");
+					return false;
+				}
+			}
+		}
+
+		if (format->Amask != 0)
+		{
+			if (SDL_LockSurface(surface.get()) != 0) return false;
+
+			// Other formats go through one ARGB8888 row at a time, and are written back in their own format
+			const bool direct = Is8888(format);
+			const int alpha = direct ? AlphaChannel(format) : 3;
+			std::vector<Uint32> buffer(direct ? 0 : (size_t)surface->w);
+
+			bool converted = true;
+			for (int y = 0; y < surface->h && converted; y++)
+			{
+				Uint32* row = direct ? Row<Uint32>(surface.get(), y) : buffer.data();
+				if (!direct) converted = SDL_ConvertPixels(surface->w, 1, format->format, Row<Uint8>(surface.get(), y), surface->pitch, SDL_PIXELFORMAT_ARGB8888, row, surface->w * 4) == 0;
+				if (!converted) break;
+
+				switch (alpha)
+				{
+				case 0: PremultiplyRow<0>(row, surface->w); break;
+				case 1: PremultiplyRow<1>(row, surface->w); break;
+				case 2: PremultiplyRow<2>(row, surface->w); break;
+				case 3: PremultiplyRow<3>(row, surface->w); break;
+				}
+
+				if (!direct) converted = SDL_ConvertPixels(surface->w, 1, SDL_PIXELFORMAT_ARGB8888, row, surface->w * 4, format->format, Row<Uint8>(surface.get(), y), surface->pitch) == 0;
+			}
+
+			SDL_UnlockSurface(surface.get());
+			if (!converted) return false;
+		}
+
+		SetPremultiplied(true);
+		return true;
+	}
+
+	bool Surface::BlitPremultiplied(const Rect* srcrect, Surface& dst, Rect* dstrect) const
+	{
+		if (!surface || !dst.surface)
+		{
+			SDL_SetError("Parameter '%s' is invalid", surface ? "dst" : "surface");
+			return false;
+		}
+
+		SDL_BlendMode blendMode = SDL_BLENDMODE_NONE;
+		SDL_GetSurfaceBlendMode(surface.get(), &blendMode);
+
+		// Modes that do not weight the source by its alpha behave the same for premultiplied colour
+		if ((blendMode != SDL_BLENDMODE_BLEND && blendMode != SDL_BLENDMODE_ADD) || surface->format->Amask == 0)
+			return SDL_BlitSurface(surface.get(), (const SDL_Rect*)srcrect, dst.surface.get(), (SDL_Rect*)dstrect) == 0;
+
+		if (!Is8888(surface->format) || !Is8888(dst.surface->format))
+		{
+			SDL_SetError("Premultiplied blits need 32-bit surfaces with 8-bit channels");
+			return false;
+		}
+
+		SDL_Rect sr, dr;
+		if (!ClipBlit(surface.get(), srcrect, dst.surface.get(), dstrect, sr, dr)) return true;
+
+		Uint8 mod[4] = { 255, 255, 255, 255 };
+		SDL_GetSurfaceColorMod(surface.get(), &mod[0], &mod[1], &mod[2]);
+		SDL_GetSurfaceAlphaMod(surface.get(), &mod[3]);
+
+		const bool add = blendMode == SDL_BLENDMODE_ADD;
+		const bool fast = surface->format->format == dst.surface->format->format && (mod[0] & mod[1] & mod[2] & mod[3]) == 255;
+		const int alpha = AlphaChannel(surface->format);
+
+		if (SDL_LockSurface(surface.get()) != 0) return false;
+		if (SDL_LockSurface(dst.surface.get()) != 0)
+		{
+			SDL_UnlockSurface(surface.get());
+			return false;
+		}
+
+		for (int y = 0; y < dr.h; y++)
+		{
+			const Uint32* s = Row<const Uint32>(surface.get(), sr.y + y) + sr.x;
+			Uint32* t = Row<Uint32>(dst.surface.get(), dr.y + y) + dr.x;
+
+			if (!fast) BlendRowPremultipliedGeneric(s, surface->format, t, dst.surface->format, dr.w, add, mod);
+			else switch (alpha)
+			{
+			case 0: BlendRowPremultiplied<0>(s, t, dr.w, add); break;
+			case 1: BlendRowPremultiplied<1>(s, t, dr.w, add); break;
+			case 2: BlendRowPremultiplied<2>(s, t, dr.w, add); break;
+			case 3: BlendRowPremultiplied<3>(s, t, dr.w, add); break;
+			}
+		}
+
+		SDL_UnlockSurface(dst.surface.get());
+		SDL_UnlockSurface(surface.get());
+
+		return true;
+	}
+
+	bool Surface::BlitScaledPremultiplied(const Rect* srcrect, Surface& dst, Rect* dstrect) const
+		{ return BlitScaledVia(*this, srcrect, dst, dstrect, &Surface::BlitPremultiplied); }
+
+#pragma endregion
+
+#pragma region Linear Light Blits
+
+	// Composite a row of straight alpha pixels over a row of any 8888 format in linear light, applying colour and alpha modulation
+	static void BlendRowLinearGeneric(const Uint32* src, const SDL_PixelFormat* sf, Uint32* dst, const SDL_PixelFormat* df, int w, bool add, const Uint8 mod[4])
+	{
+		const LinearLUT& lut = GetLinearLUT();
+		const int sshift[4] = { sf->Rshift, sf->Gshift, sf->Bshift, sf->Ashift };
+		const int dshift[4] = { df->Rshift, df->Gshift, df->Bshift, df->Ashift };
+		const bool dalpha = df->Amask != 0;
+
+		for (int x = 0; x < w; x++)
+		{
+			const Uint32 a = Div255(((src[x] >> sshift[3]) & 0xFF) * mod[3]);
+			if (a == 0) continue;
+
+			Uint32 r = dalpha ? 0 : dst[x] & ~(df->Rmask | df->Gmask | df->Bmask);
+			for (int c = 0; c < 3; c++)
+			{
+				const Uint32 s = lut.toLinear16[Div255(((src[x] >> sshift[c]) & 0xFF) * mod[c])];
+				const Uint32 d = lut.toLinear16[(dst[x] >> dshift[c]) & 0xFF];
+				const Uint32 v = add ? d + (s * a + 127) / 255 : (s * a + d * (255 - a) + 127) / 255;
+				r |= (Uint32)FromLinear16(lut, v) << dshift[c];
+			}
+
+			if (dalpha)
+			{
+				const Uint32 d = (dst[x] >> dshift[3]) & 0xFF;
+				r |= (add ? d : std::min(255u, a + Div255(d * (255 - a)))) << dshift[3];
+			}
+
+			dst[x] = r;
+		}
+	}
+
+	bool Surface::BlitLinear(const Rect* srcrect, Surface& dst, Rect* dstrect) const
+	{
+		if (!surface || !dst.surface)
+		{
+			SDL_SetError("Parameter '%s' is invalid", surface ? "dst" : "surface");
+			return false;
+		}
+
+		SDL_BlendMode blendMode = SDL_BLENDMODE_NONE;
+		SDL_GetSurfaceBlendMode(surface.get(), &blendMode);
+
+		// Without alpha weighting there is nothing to mix, and premultiplied colour cannot be linearized per channel
+		if ((blendMode != SDL_BLENDMODE_BLEND && blendMode != SDL_BLENDMODE_ADD) || surface->format->Amask == 0)
+			return SDL_BlitSurface(surface.get(), (const SDL_Rect*)srcrect, dst.surface.get(), (SDL_Rect*)dstrect) == 0;
+		if (IsPremultiplied()) return BlitPremultiplied(srcrect, dst, dstrect);
+
+		if (!Is8888(surface->format) || !Is8888(dst.surface->format))
+		{
+			SDL_SetError("Linear blits need 32-bit surfaces with 8-bit channels");
+			return false;
+		}
+
+		SDL_Rect sr, dr;
+		if (!ClipBlit(surface.get(), srcrect, dst.surface.get(), dstrect, sr, dr)) return true;
+
+		Uint8 mod[4] = { 255, 255, 255, 255 };
+		SDL_GetSurfaceColorMod(surface.get(), &mod[0], &mod[1], &mod[2]);
+		SDL_GetSurfaceAlphaMod(surface.get(), &mod[3]);
+
+		const bool add = blendMode == SDL_BLENDMODE_ADD;
+		const bool fast = surface->format->format == dst.surface->format->format && (mod[0] & mod[1] & mod[2] & mod[3]) == 255;
+		const int alpha = AlphaChannel(surface->format);
+
+		if (SDL_LockSurface(surface.get()) != 0) return false;
+		if (SDL_LockSurface(dst.surface.get()) != 0)
+		{
+			SDL_UnlockSurface(surface.get());
+			return false;
+		}
+
+		for (int y = 0; y < dr.h; y++)
+		{
+			const Uint32* s = Row<const Uint32>(surface.get(), sr.y + y) + sr.x;
+			Uint32* t = Row<Uint32>(dst.surface.get(), dr.y + y) + dr.x;
+
+			if (fast) CompositeRow(s, t, dr.w, blendMode, alpha, false, true);
+			else BlendRowLinearGeneric(s, surface->format, t, dst.surface->format, dr.w, add, mod);
+		}
+
+		SDL_UnlockSurface(dst.surface.get());
+		SDL_UnlockSurface(surface.get());
+
+		return true;
+	}
+
+	bool Surface::BlitScaledLinear(const Rect* srcrect, Surface& dst, Rect* dstrect) const
+		{ return BlitScaledVia(*this, srcrect, dst, dstrect, &Surface::BlitLinear); }
+
+#pragma endregion
+
+#pragma region Transformed Blits
+
+	// Bilinear interpolation of four pixels, with 8-bit fractions fx and fy
+	static inline Uint32 Bilerp(Uint32 p00, Uint32 p10, Uint32 p01, Uint32 p11, Uint32 fx, Uint32 fy)
+	{
+#if defined(SDLPP_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i round = _mm_set1_epi16(128);
+		const __m128i wx = _mm_unpacklo_epi64(_mm_set1_epi16((short)(256 - fx)), _mm_set1_epi16((short)fx));
+		const __m128i top = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128((int)p00), _mm_cvtsi32_si128((int)p10)), zero), wx);
+		const __m128i bot = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128((int)p01), _mm_cvtsi32_si128((int)p11)), zero), wx);
+		const __m128i h0 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(top, _mm_srli_si128(top, 8)), round), 8);
+		const __m128i h1 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(bot, _mm_srli_si128(bot, 8)), round), 8);
+		const __m128i v = _mm_add_epi16(_mm_mullo_epi16(h0, _mm_set1_epi16((short)(256 - fy))), _mm_mullo_epi16(h1, _mm_set1_epi16((short)fy)));
+		const __m128i r = _mm_srli_epi16(_mm_add_epi16(v, round), 8);
+		return (Uint32)_mm_cvtsi128_si32(_mm_packus_epi16(r, r));
+#elif defined(SDLPP_NEON)
+		const uint16x8_t wx = vcombine_u16(vdup_n_u16((uint16_t)(256 - fx)), vdup_n_u16((uint16_t)fx));
+		const uint16x8_t top = vmulq_u16(vmovl_u8(vcreate_u8(((uint64_t)p10 << 32) | p00)), wx);
+		const uint16x8_t bot = vmulq_u16(vmovl_u8(vcreate_u8(((uint64_t)p11 << 32) | p01)), wx);
+		const uint16x4_t h0 = vrshr_n_u16(vadd_u16(vget_low_u16(top), vget_high_u16(top)), 8);
+		const uint16x4_t h1 = vrshr_n_u16(vadd_u16(vget_low_u16(bot), vget_high_u16(bot)), 8);
+		const uint16x4_t r = vrshr_n_u16(vadd_u16(vmul_n_u16(h0, (uint16_t)(256 - fy)), vmul_n_u16(h1, (uint16_t)fy)), 8);
+		return vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(r, r))), 0);
+#else
+		Uint32 r = 0;
+		for (int c = 0; c < 32; c += 8)
+		{
+			const Uint32 t = (((p00 >> c) & 0xFF) * (256 - fx) + ((p10 >> c) & 0xFF) * fx + 128) >> 8;
+			const Uint32 b = (((p01 >> c) & 0xFF) * (256 - fx) + ((p11 >> c) & 0xFF) * fx + 128) >> 8;
+			r |= ((t * (256 - fy) + b * fy + 128) >> 8) << c;
+		}
+		return r;
+#endif
+	}
+
+	// Bilinear interpolation of four pixels in linear light, with 8-bit fractions fx and fy and alpha in channel alpha
+	static inline Uint32 BilerpLinear(Uint32 p00, Uint32 p10, Uint32 p01, Uint32 p11, Uint32 fx, Uint32 fy, int alpha, const LinearLUT& lut)
+	{
+		const Uint32 w00 = (256 - fx) * (256 - fy), w10 = fx * (256 - fy), w01 = (256 - fx) * fy, w11 = fx * fy;
+		Uint32 r = 0;
+
+		for (int c = 0; c < 4; c++)
+		{
+			const int shift = c * 8;
+			const Uint32 c00 = (p00 >> shift) & 0xFF, c10 = (p10 >> shift) & 0xFF, c01 = (p01 >> shift) & 0xFF, c11 = (p11 >> shift) & 0xFF;
+
+			if (c == alpha) r |= ((c00 * w00 + c10 * w10 + c01 * w01 + c11 * w11 + 32768) >> 16) << shift;
+			else
+			{
+				const Uint32 l = (lut.toLinear16[c00] * w00 + lut.toLinear16[c10] * w10 + lut.toLinear16[c01] * w01 + lut.toLinear16[c11] * w11 + 32768) >> 16;
+				r |= (Uint32)FromLinear16(lut, l) << shift;
+			}
+		}
+
+		return r;
+	}
+
+	// Floor and ceiling of a / b for any signs
+	static inline Sint64 FloorDiv(Sint64 a, Sint64 b) { const Sint64 q = a / b; return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q; }
+	static inline Sint64 CeilDiv(Sint64 a, Sint64 b) { return -FloorDiv(-a, b); }
+
+	// Narrow [first, last) to the steps i where lo <= start + i * step < hi
+	static void ClipSpan(Sint64 start, Sint64 step, Sint64 lo, Sint64 hi, Sint64& first, Sint64& last)
+	{
+		if (step == 0)
+		{
+			if (start < lo || start >= hi) last = first;
+		}
+		else if (step > 0)
+		{
+			first = std::max(first, CeilDiv(lo - start, step));
+			last = std::min(last, FloorDiv(hi - 1 - start, step) + 1);
+		}
+		else
+		{
+			first = std::max(first, CeilDiv(hi - 1 - start, step));
+			last = std::min(last, FloorDiv(lo - start, step) + 1);
+		}
+	}
+
+	bool Surface::BlitTransformed(const Rect* srcrect, Surface& dst, const Transform2D& transform, SampleMode sampling, ColourSpace space) const
+	{
+		if (!surface || !dst.surface)
+		{
+			SDL_SetError("Parameter '%s' is invalid", surface ? "dst" : "surface");
+			return false;
+		}
+
+		if (!Is8888(dst.surface->format))
+		{
+			SDL_SetError("Transformed blits need a destination with 8-bit channels");
+			return false;
+		}
+
+		SDL_BlendMode blendMode = SDL_BLENDMODE_NONE;
+		SDL_GetSurfaceBlendMode(surface.get(), &blendMode);
+		if (blendMode != SDL_BLENDMODE_NONE && blendMode != SDL_BLENDMODE_BLEND && blendMode != SDL_BLENDMODE_ADD)
+		{
+			SDL_SetError("Transformed blits only support the NONE, BLEND and ADD blend modes");
+			return false;
+		}
+
+		if (transform.determinant() == 0) return true;
+
+		SDL_Surface* d = dst.surface.get();
+
+		// Sample in the destination's channel order. If it has no alpha, such as a window surface, put the source's
+		// alpha in its unused byte, so blending still sees it. A source already in the destination's format has no
+		// alpha to keep, so it is read as it is.
+		Uint32 format = d->format->format;
+		if (!d->format->Amask)
+		{
+			const Uint32 rgb = d->format->Rmask | d->format->Gmask | d->format->Bmask;
+			format = SDL_MasksToPixelFormatEnum(32, d->format->Rmask, d->format->Gmask, d->format->Bmask, ~rgb);
+		}
+
+		Surface source = *this;
+		if (surface->format->format != format && surface->format->format != d->format->format)
+		{
+			source = FromPtr(SDL_ConvertSurfaceFormat(surface.get(), format, 0));
+			if (!source.surface) return false;
+		}
+
+		SDL_Surface* s = source.surface.get();
+
+		// The transform works relative to the requested rectangle, but only its part inside the surface is read
+		const SDL_Rect bounds = { 0, 0, s->w, s->h };
+		const SDL_Rect requested = srcrect ? *(const SDL_Rect*)srcrect : bounds;
+		SDL_Rect sr;
+		if (!SDL_IntersectRect(&requested, &bounds, &sr)) return true;
+
+		const int ox = requested.x;
+		const int oy = requested.y;
+		const FRect box = transform.bounds(FRect((float)(sr.x - ox), (float)(sr.y - oy), (float)sr.w, (float)sr.h));
+
+		SDL_Rect area = { (int)std::floor(box.x), (int)std::floor(box.y), 0, 0 };
+		area.w = (int)std::ceil(box.x + box.w) - area.x;
+		area.h = (int)std::ceil(box.y + box.h) - area.y;
+		if (!SDL_IntersectRect(&area, &d->clip_rect, &area)) return true;
+
+		const Transform2D inv = transform.inverse();
+		const Sint64 du = std::llround((double)inv.a * 65536.0);
+		const Sint64 dv = std::llround((double)inv.b * 65536.0);
+		const auto whole = [](float v) { return std::abs(v - std::round(v)) < 1e-4f; };
+		const auto sourceAt = [&](double x, double y, Sint64& u, Sint64& v)
+		{
+			u = std::llround(((double)inv.a * x + (double)inv.c * y + inv.tx + ox) * 65536.0);
+			v = std::llround(((double)inv.b * x + (double)inv.d * y + inv.ty + oy) * 65536.0);
+		};
+
+		// Quarter turns, flips and whole pixel moves map pixel centres exactly onto pixel centres
+		Sint64 u0, v0;
+		sourceAt(area.x + 0.5, area.y + 0.5, u0, v0);
+		const bool exact =
+			whole(inv.a) && whole(inv.b) && whole(inv.c) && whole(inv.d) &&
+			std::abs(inv.a) + std::abs(inv.b) > 0.5f && std::abs(inv.a) + std::abs(inv.b) < 1.5f &&
+			std::abs(inv.c) + std::abs(inv.d) > 0.5f && std::abs(inv.c) + std::abs(inv.d) < 1.5f &&
+			whole(u0 / 65536.0f - 0.5f) && whole(v0 / 65536.0f - 0.5f);
+
+		const int alpha = AlphaChannel(s->format);
+		const int pitch = s->pitch / 4;
+		std::vector<Uint32> samples(area.w);
+
+		// Premultiplied colour is always mixed as stored
+		const bool premultiplied = IsPremultiplied();
+		const bool linear = space == ColourSpace::LINEAR && !premultiplied;
+		const LinearLUT& lut = GetLinearLUT();
+
+		if (SDL_LockSurface(s) != 0) return false;
+		if (SDL_LockSurface(d) != 0)
+		{
+			SDL_UnlockSurface(s);
+			return false;
+		}
+
+		const Uint32* pixels = (const Uint32*)s->pixels;
+
+		for (int y = area.y; y < area.y + area.h; y++)
+		{
+			Sint64 u, v;
+			sourceAt(area.x + 0.5, y + 0.5, u, v);
+			if (exact)
+			{
+				u = (FloorDiv(u, 65536) << 16) + 0x8000;
+				v = (FloorDiv(v, 65536) << 16) + 0x8000;
+			}
+
+			Sint64 first = 0, last = area.w;
+			ClipSpan(u, du, (Sint64)sr.x << 16, (Sint64)(sr.x + sr.w) << 16, first, last);
+			ClipSpan(v, dv, (Sint64)sr.y << 16, (Sint64)(sr.y + sr.h) << 16, first, last);
+			if (first >= last) continue;
+
+			const int n = (int)(last - first);
+			Uint32* out = Row<Uint32>(d, y) + area.x + first;
+			Uint32* target = blendMode == SDL_BLENDMODE_NONE ? out : samples.data();
+			u += first * du;
+			v += first * dv;
+
+			if (exact)
+			{
+				const Uint32* in = pixels + (v >> 16) * pitch + (u >> 16);
+				const ptrdiff_t step = (ptrdiff_t)(du >> 16) + (ptrdiff_t)(dv >> 16) * pitch;
+
+				if (step == 1) std::copy_n(in, n, target);
+				else for (int i = 0; i < n; i++, in += step) target[i] = *in;
+			}
+			else if (sampling == SampleMode::NEAREST)
+			{
+				for (int i = 0; i < n; i++, u += du, v += dv)
+					target[i] = pixels[(v >> 16) * pitch + (u >> 16)];
+			}
+			else
+			{
+				// Sample around pixel centres, clamping to the edges of the source rectangle
+				for (int i = 0; i < n; i++, u += du, v += dv)
+				{
+					const Sint64 bu = u - 0x8000;
+					const Sint64 bv = v - 0x8000;
+					const int x0 = std::clamp((int)(bu >> 16),     sr.x, sr.x + sr.w - 1);
+					const int x1 = std::clamp((int)(bu >> 16) + 1, sr.x, sr.x + sr.w - 1);
+					const int y0 = std::clamp((int)(bv >> 16),     sr.y, sr.y + sr.h - 1);
+					const int y1 = std::clamp((int)(bv >> 16) + 1, sr.y, sr.y + sr.h - 1);
+					const Uint32* r0 = pixels + y0 * pitch;
+					const Uint32* r1 = pixels + y1 * pitch;
+					const Uint32 fx = (Uint32)(bu >> 8) & 0xFF, fy = (Uint32)(bv >> 8) & 0xFF;
+					target[i] = linear ? BilerpLinear(r0[x0], r0[x1], r1[x0], r1[x1], fx, fy, alpha, lut) : Bilerp(r0[x0], r0[x1], r1[x0], r1[x1], fx, fy);
+				}
+			}
+
+			if (target != out) CompositeRow(target, out, n, blendMode, alpha, premultiplied, linear);
+		}
+
+		SDL_UnlockSurface(d);
+		SDL_UnlockSurface(s);
+
+		return true;
+	}
+
+#pragma endregion
+}
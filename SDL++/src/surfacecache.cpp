@@ -0,0 +1,561 @@
+#include "surfacecache.hpp"
+#include "parallel.hpp"
+#include "pixelops.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+namespace SDL
+{
+#pragma region QOI Bands
+
+	// The QOI operations. RGB and RGBA are whole bytes; the rest keep their argument in the low 6 bits
+	static constexpr Uint8 QOI_OP_INDEX = 0x00;
+	static constexpr Uint8 QOI_OP_DIFF  = 0x40;
+	static constexpr Uint8 QOI_OP_LUMA  = 0x80;
+	static constexpr Uint8 QOI_OP_RUN   = 0xC0;
+	static constexpr Uint8 QOI_OP_RGB   = 0xFE;
+	static constexpr Uint8 QOI_OP_RGBA  = 0xFF;
+
+	static inline int QOIHash(Uint32 r, Uint32 g, Uint32 b, Uint32 a) { return (int)((r * 3 + g * 5 + b * 7 + a * 11) & 63); }
+
+	// The shifts of the red, green, blue and alpha bytes of an 8888 pixel. Formats without alpha have
+	// a padding byte, which is stored in its place so the encoding stays lossless
+	static void ChannelShifts(const SDL_PixelFormat* f, int shifts[4])
+	{
+		shifts[0] = f->Rshift;
+		shifts[1] = f->Gshift;
+		shifts[2] = f->Bshift;
+		shifts[3] = 48 - f->Rshift - f->Gshift - f->Bshift;
+	}
+
+	// Pixels are compared and kept in the recent colour table in their own format, and only split into
+	// channels for the difference operations
+	static void EncodeQOI(SDL_Surface* s, int y0, int y1, const int shifts[4], std::vector<Uint8>& out)
+	{
+		Uint32 index[64] = {};
+		Uint32 prev = 0xFFu << shifts[3];
+		Uint32 pr = 0, pg = 0, pb = 0, pa = 0xFF;
+		int run = 0;
+
+		for (int y = y0; y < y1; y++)
+		{
+			const Uint32* row = Row<const Uint32>(s, y);
+
+			for (int x = 0; x < s->w; x++)
+			{
+				const Uint32 p = row[x];
+				if (p == prev)
+				{
+					if (++run == 62)
+					{
+						out.push_back(QOI_OP_RUN | 61);
+						run = 0;
+					}
+					continue;
+				}
+
+				if (run > 0)
+				{
+					out.push_back((Uint8)(QOI_OP_RUN | (run - 1)));
+					run = 0;
+				}
+
+				const Uint32 r = (p >> shifts[0]) & 0xFF, g = (p >> shifts[1]) & 0xFF, b = (p >> shifts[2]) & 0xFF, a = (p >> shifts[3]) & 0xFF;
+				const int h = QOIHash(r, g, b, a);
+
+				if (index[h] == p) out.push_back((Uint8)(QOI_OP_INDEX | h));
+				else
+				{
+					index[h] = p;
+
+					if (a == pa)
+					{
+						const int vr = (Sint8)(r - pr), vg = (Sint8)(g - pg), vb = (Sint8)(b - pb);
+						const int vgr = vr - vg, vgb = vb - vg;
+
+						if (vr >= -2 && vr <= 1 && vg >= -2 && vg <= 1 && vb >= -2 && vb <= 1)
+							out.push_back((Uint8)(QOI_OP_DIFF | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2)));
+						else if (vg >= -32 && vg <= 31 && vgr >= -8 && vgr <= 7 && vgb >= -8 && vgb <= 7)
+						{
+							out.push_back((Uint8)(QOI_OP_LUMA | (vg + 32)));
+							out.push_back((Uint8)(((vgr + 8) << 4) | (vgb + 8)));
+						}
+						else
+						{
+							const Uint8 op[4] = { QOI_OP_RGB, (Uint8)r, (Uint8)g, (Uint8)b };
+							out.insert(out.end(), op, op + 4);
+						}
+					}
+					else
+					{
+						const Uint8 op[5] = { QOI_OP_RGBA, (Uint8)r, (Uint8)g, (Uint8)b, (Uint8)a };
+						out.insert(out.end(), op, op + 5);
+					}
+				}
+
+				prev = p;
+				pr = r; pg = g; pb = b; pa = a;
+			}
+		}
+
+		if (run > 0) out.push_back((Uint8)(QOI_OP_RUN | (run - 1)));
+	}
+
+	// The recent colour table is only written by the operations that write it when encoding, so the two stay in step
+	static void DecodeQOI(SDL_Surface* s, int y0, int y1, const int shifts[4], const Uint8* in, const Uint8* end)
+	{
+		Uint32 index[64] = {};
+		Uint32 p = 0xFFu << shifts[3];
+		Uint32 r = 0, g = 0, b = 0, a = 0xFF;
+		int run = 0;
+
+		for (int y = y0; y < y1; y++)
+		{
+			Uint32* row = Row<Uint32>(s, y);
+
+			for (int x = 0; x < s->w; x++)
+			{
+				if (run > 0) run--;
+				else if (in < end)
+				{
+					const Uint8 op = *in++;
+					bool store = true;
+
+					if (op == QOI_OP_RGB)
+					{
+						r = in[0]; g = in[1]; b = in[2];
+						in += 3;
+					}
+					else if (op == QOI_OP_RGBA)
+					{
+						r = in[0]; g = in[1]; b = in[2]; a = in[3];
+						in += 4;
+					}
+					else switch (op & 0xC0)
+					{
+					case QOI_OP_INDEX:
+						p = index[op];
+						r = (p >> shifts[0]) & 0xFF; g = (p >> shifts[1]) & 0xFF; b = (p >> shifts[2]) & 0xFF; a = (p >> shifts[3]) & 0xFF;
+						store = false;
+						break;
+					case QOI_OP_DIFF:
+						r = (r + ((op >> 4) & 3) - 2) & 0xFF;
+						g = (g + ((op >> 2) & 3) - 2) & 0xFF;
+						b = (b + (op & 3) - 2) & 0xFF;
+						break;
+					case QOI_OP_LUMA:
+					{
+						const int vg = (op & 0x3F) - 32;
+						const Uint8 rb = *in++;
+						r = (r + vg + (rb >> 4) - 8) & 0xFF;
+						g = (g + vg) & 0xFF;
+						b = (b + vg + (rb & 0xF) - 8) & 0xFF;
+						break;
+					}
+					default:
+						run = op & 0x3F;
+						store = false;
+						break;
+					}
+
+					if (store)
+					{
+						p = (r << shifts[0]) | (g << shifts[1]) | (b << shifts[2]) | (a << shifts[3]);
+						index[QOIHash(r, g, b, a)] = p;
+					}
+				}
+
+				row[x] = p;
+			}
+		}
+	}
+
+#pragma endregion
+
+#pragma region Row Bands
+
+	// The bytes of pixel data in a row. Formats under 8 bits per pixel pack several pixels to a byte, so a row can be
+	// shorter than its width.
+	static inline int RowBytes(const SDL_Surface* s) { return (s->w * s->format->BitsPerPixel + 7) / 8; }
+
+	// Each row is stored as its difference from the row above, or for the first row of a band, from the pixel to its
+	// left. The differences are then written as tokens: below 128, a literal of token + 1 bytes follows; otherwise
+	// the token stands for token - 127 zero bytes
+	static void EncodeRows(SDL_Surface* s, int y0, int y1, int bpp, std::vector<Uint8>& out)
+	{
+		const int n = RowBytes(s);
+		std::vector<Uint8> diff((size_t)n);
+
+		for (int y = y0; y < y1; y++)
+		{
+			const Uint8* row = Row<const Uint8>(s, y);
+			if (y == y0)
+			{
+				std::copy_n(row, std::min(bpp, n), diff.data());
+				for (int i = bpp; i < n; i++) diff[i] = (Uint8)(row[i] - row[i - bpp]);
+			}
+			else
+			{
+				const Uint8* above = Row<const Uint8>(s, y - 1);
+				for (int i = 0; i < n; i++) diff[i] = (Uint8)(row[i] - above[i]);
+			}
+
+			for (int i = 0; i < n;)
+			{
+				int zeros = 0;
+				while (i + zeros < n && zeros < 128 && diff[i + zeros] == 0) zeros++;
+
+				if (zeros >= 2)
+				{
+					out.push_back((Uint8)(127 + zeros));
+					i += zeros;
+					continue;
+				}
+
+				// Extend the literal until the next pair of zeros
+				int len = 1;
+				while (i + len < n && len < 128 && !(diff[i + len] == 0 && i + len + 1 < n && diff[i + len + 1] == 0)) len++;
+
+				out.push_back((Uint8)(len - 1));
+				out.insert(out.end(), diff.data() + i, diff.data() + i + len);
+				i += len;
+			}
+		}
+	}
+
+	static void DecodeRows(SDL_Surface* s, int y0, int y1, int bpp, const Uint8* in, const Uint8* end)
+	{
+		const int n = RowBytes(s);
+
+		for (int y = y0; y < y1; y++)
+		{
+			Uint8* row = Row<Uint8>(s, y);
+			const Uint8* above = y == y0 ? NULL : Row<const Uint8>(s, y - 1);
+
+			for (int i = 0; i < n && in < end;)
+			{
+				const Uint8 token = *in++;
+				if (token >= 128)
+				{
+					const int len = std::min((int)token - 127, n - i);
+					if (above) std::copy_n(above + i, len, row + i);
+					else for (int j = i; j < i + len; j++) row[j] = j < bpp ? 0 : row[j - bpp];
+					i += len;
+				}
+				else
+				{
+					const int len = std::min({ (int)token + 1, n - i, (int)(end - in) });
+					for (int j = i; j < i + len; j++, in++)
+						row[j] = (Uint8)(*in + (above ? above[j] : j < bpp ? 0 : row[j - bpp]));
+					i += len;
+				}
+			}
+		}
+	}
+
+#pragma endregion
+
+#pragma region CompressedSurface
+
+	// Copy the state RestoreState() puts back, other than the palette
+	static void CaptureState(CompressedSurface& c, const Surface& surface)
+	{
+		SDL_Surface* s = surface.surface.get();
+		SDL_GetSurfaceBlendMode(s, &c.blendMode);
+		SDL_GetSurfaceColorMod(s, &c.colourMod[0], &c.colourMod[1], &c.colourMod[2]);
+		SDL_GetSurfaceAlphaMod(s, &c.alphaMod);
+		c.keyed = SDL_GetColorKey(s, &c.colourKey) == 0;
+		c.premultiplied = surface.IsPremultiplied();
+	}
+
+	CompressedSurface::CompressedSurface(const Surface& surface, bool parallel)
+		: CompressedSurface()
+	{
+		if (!surface.surface)
+		{
+			SDL_SetError("Parameter 'surface' is invalid");
+			return;
+		}
+
+		SDL_Surface* s = surface.surface.get();
+		const SDL_PixelFormat* f = s->format;
+
+		hash = surface.Hash();
+		codec = Is8888(f) ? Codec::QOI : Codec::ROWS;
+		CaptureState(*this, surface);
+		if (f->palette) palette.assign(f->palette->colors, f->palette->colors + f->palette->ncolors);
+
+		if (SDL_LockSurface(s) != 0) return;
+
+		int shifts[4];
+		if (codec == Codec::QOI) ChannelShifts(f, shifts);
+
+		const int count = (s->h + BAND_ROWS - 1) / BAND_ROWS;
+		std::vector<std::vector<Uint8>> encoded((size_t)count);
+
+		MaybeParallelFor(parallel, count, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				const int y0 = i * BAND_ROWS, y1 = std::min(y0 + BAND_ROWS, s->h);
+				if (codec == Codec::QOI) EncodeQOI(s, y0, y1, shifts, encoded[i]);
+				else EncodeRows(s, y0, y1, f->BytesPerPixel, encoded[i]);
+			}
+		}, 4);
+
+		SDL_UnlockSurface(s);
+
+		size_t total = 0;
+		for (const std::vector<Uint8>& band : encoded) total += band.size();
+
+		data.reserve(total);
+		bands.reserve((size_t)count + 1);
+		for (const std::vector<Uint8>& band : encoded)
+		{
+			bands.push_back((Uint32)data.size());
+			data.insert(data.end(), band.begin(), band.end());
+		}
+		bands.push_back((Uint32)data.size());
+
+		w = s->w;
+		h = s->h;
+		format = f->format;
+	}
+
+	bool CompressedSurface::Decompress(Surface& dst, bool parallel) const
+	{
+		if (!IsValid() || !dst.surface)
+		{
+			SDL_SetError("Parameter '%s' is invalid", IsValid() ? "dst" : "compressed");
+			return false;
+		}
+
+		SDL_Surface* s = dst.surface.get();
+		if (s->w != w || s->h != h || s->format->format != format)
+		{
+			SDL_SetError("The destination must be %dx%d in %s", w, h, SDL_GetPixelFormatName(format));
+			return false;
+		}
+
+		if (SDL_LockSurface(s) != 0) return false;
+
+		int shifts[4];
+		if (codec == Codec::QOI) ChannelShifts(s->format, shifts);
+
+		MaybeParallelFor(parallel, (int)bands.size() - 1, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				const int y0 = i * BAND_ROWS, y1 = std::min(y0 + BAND_ROWS, h);
+				const Uint8* in = data.data() + bands[i];
+				const Uint8* stop = data.data() + bands[i + 1];
+
+				if (codec == Codec::QOI) DecodeQOI(s, y0, y1, shifts, in, stop);
+				else DecodeRows(s, y0, y1, s->format->BytesPerPixel, in, stop);
+			}
+		}, 4);
+
+		SDL_UnlockSurface(s);
+
+		return true;
+	}
+
+	Surface CompressedSurface::Decompress(bool parallel) const
+	{
+		if (!IsValid())
+		{
+			SDL_SetError("Parameter 'compressed' is invalid");
+			return Surface::FromPtr(NULL);
+		}
+
+		Surface result(w, h, format);
+		if (!result.surface) return Surface::FromPtr(NULL);
+
+		if (!Decompress(result, parallel) || !RestoreState(result)) return Surface::FromPtr(NULL);
+
+		return result;
+	}
+
+	bool CompressedSurface::RestoreState(Surface& dst) const
+	{
+		if (!dst.surface)
+		{
+			SDL_SetError("Parameter 'dst' is invalid");
+			return false;
+		}
+
+		SDL_Surface* s = dst.surface.get();
+		bool success = true;
+
+		if (!palette.empty() && s->format->palette)
+			success &= SDL_SetPaletteColors(s->format->palette, palette.data(), 0, std::min((int)palette.size(), s->format->palette->ncolors)) == 0;
+
+		success &= SDL_SetSurfaceBlendMode(s, blendMode) == 0;
+		success &= SDL_SetSurfaceColorMod(s, colourMod[0], colourMod[1], colourMod[2]) == 0;
+		success &= SDL_SetSurfaceAlphaMod(s, alphaMod) == 0;
+		success &= SDL_SetColorKey(s, keyed ? SDL_TRUE : SDL_FALSE, colourKey) == 0;
+		dst.SetPremultiplied(premultiplied);
+
+		return success;
+	}
+
+#pragma endregion
+
+#pragma region SurfaceCache
+
+	// Idle pixel buffers, reused by the surfaces SurfaceCache::Get() returns. Buffers come back from the
+	// surfaces' deleters, which can run on any thread
+	struct SurfaceCache::BufferPool
+	{
+		struct Buffer
+		{
+			std::unique_ptr<Uint8[]> data;
+			size_t size;
+		};
+
+		std::mutex lock;
+		std::vector<Buffer> idle; // Oldest first
+		size_t bytes = 0;
+		size_t limit;
+
+		BufferPool(size_t limit) : limit(limit) {}
+
+		// Reuse the smallest idle buffer that fits, as long as it is not more than twice the size needed
+		Buffer Take(size_t size)
+		{
+			{
+				std::lock_guard<std::mutex> guard(lock);
+
+				auto best = idle.end();
+				for (auto it = idle.begin(); it != idle.end(); ++it)
+					if (it->size >= size && it->size / 2 <= size && (best == idle.end() || it->size < best->size)) best = it;
+
+				if (best != idle.end())
+				{
+					Buffer buffer = std::move(*best);
+					idle.erase(best);
+					bytes -= buffer.size;
+					return buffer;
+				}
+			}
+
+			return { std::unique_ptr<Uint8[]>(new Uint8[size]), size };
+		}
+
+		void Give(Buffer buffer)
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (buffer.size > limit) return;
+
+			idle.push_back(std::move(buffer));
+			bytes += idle.back().size;
+			TrimLocked(limit);
+		}
+
+		void TrimLocked(size_t max_bytes)
+		{
+			size_t drop = 0;
+			while (bytes > max_bytes && drop < idle.size()) bytes -= idle[drop++].size;
+			idle.erase(idle.begin(), idle.begin() + drop);
+		}
+	};
+
+	SurfaceCache::SurfaceCache(size_t pool_limit)
+		: entries(), pool(std::make_shared<BufferPool>(pool_limit)) {}
+
+	bool SurfaceCache::Store(const std::string& key, const Surface& surface, bool parallel)
+	{
+		if (!surface.surface)
+		{
+			SDL_SetError("Parameter 'surface' is invalid");
+			return false;
+		}
+
+		auto it = entries.find(key);
+		if (it != entries.end())
+		{
+			const SDL_Surface* s = surface.surface.get();
+			const CompressedSurface& old = it->second;
+
+			if (old.IsValid() && old.w == s->w && old.h == s->h && old.format == s->format->format && old.hash == surface.Hash())
+			{
+				// Same pixels, so only the surface state needs refreshing
+				CaptureState(it->second, surface);
+				return true;
+			}
+		}
+
+		CompressedSurface compressed(surface, parallel);
+		if (!compressed.IsValid()) return false;
+
+		entries[key] = std::move(compressed);
+		return true;
+	}
+
+	Surface SurfaceCache::Get(const std::string& key, bool parallel) const
+	{
+		auto it = entries.find(key);
+		if (it == entries.end())
+		{
+			SDL_SetError("No surface is stored under '%s'", key.c_str());
+			return Surface::FromPtr(NULL);
+		}
+
+		const CompressedSurface& entry = it->second;
+
+		// Rows are padded to 4 bytes, as SDL pads the surfaces it allocates
+		const int pitch = ((int)entry.RowSize() + 3) & ~3;
+		BufferPool::Buffer buffer = pool->Take(std::max((size_t)pitch * entry.h, (size_t)1));
+
+		SDL_Surface* s = SDL_CreateRGBSurfaceWithFormatFrom(buffer.data.get(), entry.w, entry.h, SDL_BITSPERPIXEL(entry.format), pitch, entry.format);
+		if (s == NULL)
+		{
+			pool->Give(std::move(buffer));
+			return Surface::FromPtr(NULL);
+		}
+
+		// The buffer goes back to the pool when the last copy of the surface is destroyed
+		std::shared_ptr<BufferPool> owner = pool;
+		Uint8* pixels = buffer.data.release();
+		const size_t size = buffer.size;
+
+		Surface result(std::shared_ptr<SDL_Surface>(s, [owner, pixels, size](SDL_Surface* surface)
+		{
+			SDL_FreeSurface(surface);
+			owner->Give({ std::unique_ptr<Uint8[]>(pixels), size });
+		}));
+
+		if (!entry.Decompress(result, parallel) || !entry.RestoreState(result)) return Surface::FromPtr(NULL);
+
+		return result;
+	}
+
+	size_t SurfaceCache::CompressedBytes() const
+	{
+		size_t total = 0;
+		for (const auto& entry : entries) total += entry.second.CompressedSize();
+		return total;
+	}
+
+	size_t SurfaceCache::DecompressedBytes() const
+	{
+		size_t total = 0;
+		for (const auto& entry : entries) total += entry.second.DecompressedSize();
+		return total;
+	}
+
+	size_t SurfaceCache::PooledBytes() const
+	{
+		std::lock_guard<std::mutex> guard(pool->lock);
+		return pool->bytes;
+	}
+
+	void SurfaceCache::TrimPool(size_t max_bytes)
+	{
+		std::lock_guard<std::mutex> guard(pool->lock);
+		pool->TrimLocked(max_bytes);
+	}
+
+#pragma endregion
+}
@@ -0,0 +1,110 @@
+#include "sweepandprune.hpp"
+
+namespace SDL
+{
+#pragma region Helpers
+
+	static inline float NearEdge(const FRect& r, int axis) { return axis == 0 ? r.x : r.y; }
+	static inline float FarEdge(const FRect& r, int axis) { return axis == 0 ? r.x + r.w : r.y + r.h; }
+
+	// Pick the axis the rectangles' centres vary along most, only switching away from the current one once the other
+	// is clearly better, so a set spread evenly on both does not flip back and forth
+	static int ChooseAxis(const std::vector<FRect>& rects, int current)
+	{
+		if (rects.size() < 2) return current;
+
+		double sum[2] = { 0, 0 }, sq[2] = { 0, 0 };
+		for (const FRect& r : rects)
+		{
+			const double cx = r.x + r.w / 2.0, cy = r.y + r.h / 2.0;
+			sum[0] += cx; sq[0] += cx * cx;
+			sum[1] += cy; sq[1] += cy * cy;
+		}
+
+		const double n = (double)rects.size();
+		const double var[2] = { sq[0] / n - (sum[0] / n) * (sum[0] / n), sq[1] / n - (sum[1] / n) * (sum[1] / n) };
+
+		const int other = 1 - current;
+		return var[other] > 2 * var[current] ? other : current;
+	}
+
+	// Add the pairs in one sorted list that are not in another
+	static void Difference(const std::vector<Uint64>& from, const std::vector<Uint64>& without, std::vector<SweepAndPrune::Pair>& out)
+	{
+		out.clear();
+		size_t j = 0;
+		for (Uint64 key : from)
+		{
+			while (j < without.size() && without[j] < key) j++;
+			if (j == without.size() || without[j] != key) out.push_back(SweepAndPrune::Unkey(key));
+		}
+	}
+
+#pragma endregion
+
+#pragma region SweepAndPrune
+
+	void SweepAndPrune::Update(const FRect* src, int count)
+	{
+		rects.assign(src, src + count);
+
+		// Drop removed ids and add new ones to the end, for the sort to move into place
+		if ((int)order.size() > count) order.erase(std::remove_if(order.begin(), order.end(), [&](int id) { return id >= count; }), order.end());
+		for (int id = (int)order.size(); id < count; id++) order.push_back(id);
+
+		auto edge = [&](int id) { return NearEdge(rects[id], axis); };
+
+		const int best = ChooseAxis(rects, axis);
+		if (best != axis)
+		{
+			// The new axis's order has nothing to do with the old one, so sort from scratch
+			axis = best;
+			std::sort(order.begin(), order.end(), [&](int a, int b) { return edge(a) < edge(b); });
+		}
+		else
+		{
+			for (int i = 1; i < count; i++)
+			{
+				const int id = order[i];
+				const float e = edge(id);
+				int j = i;
+				for (; j > 0 && edge(order[j - 1]) > e; j--) order[j] = order[j - 1];
+				order[j] = id;
+			}
+		}
+
+		// Sweep the list, testing each rectangle against those that start before it ends
+		std::swap(pairs, previous);
+		pairs.clear();
+
+		for (int i = 0; i < count; i++)
+		{
+			const int a = order[i];
+			const FRect& A = rects[a];
+			const float end = FarEdge(A, axis);
+
+			for (int j = i + 1; j < count && edge(order[j]) < end; j++)
+			{
+				const int b = order[j];
+				if (RectsIntersect(A, rects[b])) pairs.push_back(Key(a, b));
+			}
+		}
+
+		std::sort(pairs.begin(), pairs.end());
+
+		Difference(pairs, previous, begun);
+		Difference(previous, pairs, ended);
+	}
+
+	void SweepAndPrune::Clear()
+	{
+		rects.clear();
+		order.clear();
+		pairs.clear();
+		previous.clear();
+		begun.clear();
+		ended.clear();
+	}
+
+#pragma endregion
+}
@@ -0,0 +1,295 @@
+#include "textureregistry.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+
+namespace SDL
+{
+#pragma region Helpers
+
+	typedef TextureRegistry::Entry Entry;
+	typedef TextureRegistry::SourceType SourceType;
+
+	// Read the surface a texture is created from. Runs on worker threads, so it must not touch the renderer
+	static Surface Decode(const TextureRegistry& registry, const Entry& entry)
+	{
+		switch (entry.type)
+		{
+		case SourceType::FILE:
+		{
+			RWops src = RWops::FromFile(entry.file, "rb");
+			if ((SDL_RWops*)src == NULL) return Surface::FromPtr(NULL);
+			return registry.decoder(src);
+		}
+		case SourceType::MEMORY:
+		{
+			RWops src = RWops::FromConstMem(entry.data->data(), (int)entry.data->size());
+			if ((SDL_RWops*)src == NULL) return Surface::FromPtr(NULL);
+			return registry.decoder(src);
+		}
+		case SourceType::SURFACE:
+			return entry.cacheKey.empty() ? entry.surface : registry.cache.Get(entry.cacheKey, false);
+		case SourceType::GENERATOR:
+			return entry.generate();
+		default:
+			return Surface::FromPtr(NULL);
+		}
+	}
+
+	// Draw a render target's contents, putting the renderer's previous target back afterwards
+	static bool Paint(TextureRegistry& registry, Entry& entry, Texture& target)
+	{
+		SDL_Renderer* r = registry.renderer.renderer.get();
+		SDL_Texture* previous = SDL_GetRenderTarget(r);
+
+		if (SDL_SetRenderTarget(r, target.texture.get()) != 0) return false;
+		const bool success = entry.paint(registry.renderer, target);
+		SDL_SetRenderTarget(r, previous);
+
+		return success;
+	}
+
+	// Carry the blend mode, mods and scale mode set on a lost texture over to its replacement
+	static void CopyState(const Texture& from, Texture& to)
+	{
+		SDL_Texture* src = from.texture.get();
+		SDL_Texture* dst = to.texture.get();
+
+		SDL_BlendMode blend;
+		Uint8 r, g, b, a;
+		if (SDL_GetTextureBlendMode(src, &blend) == 0) SDL_SetTextureBlendMode(dst, blend);
+		if (SDL_GetTextureColorMod(src, &r, &g, &b) == 0) SDL_SetTextureColorMod(dst, r, g, b);
+		if (SDL_GetTextureAlphaMod(src, &a) == 0) SDL_SetTextureAlphaMod(dst, a);
+
+#if SDL_VERSION_ATLEAST(2, 0, 12)
+		SDL_ScaleMode scale;
+		if (SDL_GetTextureScaleMode(src, &scale) == 0) SDL_SetTextureScaleMode(dst, scale);
+#endif
+	}
+
+	// Create or repaint an entry's texture on the calling thread, from a surface decoded by Decode() unless it is a target
+	static bool Upload(TextureRegistry& registry, Entry& entry, Surface& surface)
+	{
+		Texture next;
+
+		if (entry.type == SourceType::TARGET)
+		{
+			next = entry.lost || !entry.texture->texture
+				? Texture(registry.renderer, entry.size, Texture::Access::TARGET, entry.format)
+				: *entry.texture;
+
+			if (!next.texture || !Paint(registry, entry, next)) return false;
+		}
+		else
+		{
+			if (!surface.surface) return false;
+
+			next = Texture(registry.renderer, surface);
+			if (!next.texture) return false;
+		}
+
+		if (entry.texture->texture && next.texture != entry.texture->texture) CopyState(*entry.texture, next);
+
+		*entry.texture = next;
+		entry.pending = false;
+		entry.lost = false;
+		return true;
+	}
+
+	// Create the texture for a new entry and add it, using surface if it is given rather than decoding it again
+	static std::shared_ptr<Texture> AddEntry(TextureRegistry& registry, Entry entry, Surface surface = Surface::FromPtr(NULL))
+	{
+		entry.texture = std::make_shared<Texture>();
+
+		if (entry.type != SourceType::TARGET && !surface.surface) surface = Decode(registry, entry);
+
+		if (!Upload(registry, entry, surface))
+		{
+			if (!entry.cacheKey.empty()) registry.cache.Remove(entry.cacheKey);
+			return nullptr;
+		}
+
+		std::shared_ptr<Texture> texture = entry.texture;
+		registry.entries.emplace(texture.get(), std::move(entry));
+		return texture;
+	}
+
+#pragma endregion
+
+#pragma region Registration
+
+	TextureRegistry::TextureRegistry(Renderer& renderer)
+		: renderer(renderer), decoder([](RWops& src) { return Surface(src, false); }), cache(), entries() {}
+
+	std::shared_ptr<Texture> TextureRegistry::Load(const std::string& file, int priority)
+	{
+		Entry entry;
+		entry.type = SourceType::FILE;
+		entry.file = file;
+		entry.priority = priority;
+		return AddEntry(*this, std::move(entry));
+	}
+
+	std::shared_ptr<Texture> TextureRegistry::LoadMemory(std::vector<Uint8> data, int priority)
+	{
+		Entry entry;
+		entry.type = SourceType::MEMORY;
+		entry.data = std::make_shared<std::vector<Uint8>>(std::move(data));
+		entry.priority = priority;
+		return AddEntry(*this, std::move(entry));
+	}
+
+	std::shared_ptr<Texture> TextureRegistry::Load_RW(RWops& src, bool freesrc, int priority)
+	{
+		std::vector<Uint8> data;
+		Uint8 chunk[4096];
+		size_t read;
+
+		while ((read = SDL_RWread((SDL_RWops*)src, chunk, 1, sizeof(chunk))) > 0)
+			data.insert(data.end(), chunk, chunk + read);
+
+		if (freesrc) src.Close();
+
+		if (data.empty())
+		{
+			SDL_SetError("Parameter 'src' holds no data");
+			return nullptr;
+		}
+
+		return LoadMemory(std::move(data), priority);
+	}
+
+	std::shared_ptr<Texture> TextureRegistry::Add(const Surface& surface, bool compress, int priority)
+	{
+		if (!surface.surface)
+		{
+			SDL_SetError("Parameter 'surface' is invalid");
+			return nullptr;
+		}
+
+		Entry entry;
+		entry.type = SourceType::SURFACE;
+		entry.priority = priority;
+
+		if (compress)
+		{
+			entry.cacheKey = std::to_string(nextKey++);
+			if (!cache.Store(entry.cacheKey, surface)) return nullptr;
+		}
+		else entry.surface = surface;
+
+		return AddEntry(*this, std::move(entry), surface);
+	}
+
+	std::shared_ptr<Texture> TextureRegistry::Generate(Generator generate, int priority)
+	{
+		if (!generate)
+		{
+			SDL_SetError("Parameter 'generate' is invalid");
+			return nullptr;
+		}
+
+		Entry entry;
+		entry.type = SourceType::GENERATOR;
+		entry.generate = std::move(generate);
+		entry.priority = priority;
+		return AddEntry(*this, std::move(entry));
+	}
+
+	std::shared_ptr<Texture> TextureRegistry::CreateTarget(const Point& size, Painter paint, Uint32 format, int priority)
+	{
+		if (!paint)
+		{
+			SDL_SetError("Parameter 'paint' is invalid");
+			return nullptr;
+		}
+
+		Entry entry;
+		entry.type = SourceType::TARGET;
+		entry.paint = std::move(paint);
+		entry.size = size;
+		entry.format = format;
+		entry.priority = priority;
+		return AddEntry(*this, std::move(entry));
+	}
+
+	bool TextureRegistry::Remove(const std::shared_ptr<Texture>& texture)
+	{
+		auto it = entries.find(texture.get());
+		if (it == entries.end()) return false;
+
+		if (!it->second.cacheKey.empty()) cache.Remove(it->second.cacheKey);
+		entries.erase(it);
+		return true;
+	}
+
+#pragma endregion
+
+#pragma region Restoring
+
+	size_t TextureRegistry::Pending() const
+	{
+		size_t count = 0;
+		for (const auto& entry : entries) count += entry.second.pending;
+		return count;
+	}
+
+	void TextureRegistry::Notify(const Event& e)
+	{
+		switch (e.type)
+		{
+		case Event::Type::RENDER_DEVICE_RESET:
+			for (auto& entry : entries) entry.second.pending = entry.second.lost = true;
+			break;
+		case Event::Type::RENDER_TARGETS_RESET:
+			for (auto& entry : entries)
+				if (entry.second.type == SourceType::TARGET) entry.second.pending = true;
+			break;
+		default:
+			break;
+		}
+	}
+
+	size_t TextureRegistry::Update(double budget_ms)
+	{
+		std::vector<Entry*> queue;
+		for (auto& entry : entries)
+			if (entry.second.pending) queue.push_back(&entry.second);
+
+		// Visible this frame first, then by priority, then most recently seen
+		const Uint64 now = frame;
+		std::sort(queue.begin(), queue.end(), [now](const Entry* a, const Entry* b)
+		{
+			const bool av = a->seenFrame == now, bv = b->seenFrame == now;
+			if (av != bv) return av;
+			if (a->priority != b->priority) return a->priority > b->priority;
+			return a->seenFrame > b->seenFrame;
+		});
+
+		const Uint64 start = SDL_GetPerformanceCounter();
+		const double budget = budget_ms * SDL_GetPerformanceFrequency() / 1000.0;
+		const int batch = std::max(SDL_GetCPUCount(), 1);
+
+		for (size_t next = 0; next < queue.size();)
+		{
+			const int count = (int)std::min(queue.size() - next, (size_t)batch);
+			std::vector<Surface> surfaces((size_t)count, Surface::FromPtr(NULL));
+
+			ParallelFor(count, [&](int begin, int end)
+			{
+				for (int i = begin; i < end; i++)
+					if (queue[next + i]->type != SourceType::TARGET) surfaces[i] = Decode(*this, *queue[next + i]);
+			}, 1);
+
+			for (int i = 0; i < count; i++) Upload(*this, *queue[next + i], surfaces[i]);
+
+			next += count;
+			if ((double)(SDL_GetPerformanceCounter() - start) >= budget) break;
+		}
+
+		frame++;
+		return Pending();
+	}
+
+#pragma endregion
+}
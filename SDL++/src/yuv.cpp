@@ -0,0 +1,365 @@
+#include "yuv.hpp"
+#include "parallel.hpp"
+#include "pixelops.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace SDL
+{
+#pragma region Kernels
+
+	// Conversion factors in 1/64ths, except yk in 1/128ths. The chroma products fit in 16 bits, so SIMD lanes can hold
+	// them directly. (Y - yoff) * yk does not for limited range, where it reaches 239 * 149, so the SIMD kernels work out
+	// (Y - yoff) * yk / 2 as (Y - yoff) * (yk / 2) plus half of (Y - yoff) * (yk % 2), which rounds the same way.
+	struct YUVCoefficients
+	{
+		Sint16 yoff, yk;     // Y' = (Y - yoff) * yk / 2
+		Sint16 crr;          // R = Y' + Cr * crr
+		Sint16 cbg, crg;     // G = Y' + Cb * cbg + Cr * crg
+		Sint16 cbb;          // B = Y' + Cb * cbb
+	};
+
+	static YUVCoefficients GetCoefficients(YUVMatrix matrix, YUVRange range)
+	{
+		const double kr = matrix == YUVMatrix::BT709 ? 0.2126 : 0.299;
+		const double kb = matrix == YUVMatrix::BT709 ? 0.0722 : 0.114;
+		const double kg = 1.0 - kr - kb;
+		const bool full = range == YUVRange::FULL;
+		const double ys = full ? 1.0 : 255.0 / 219.0;
+		const double cs = full ? 1.0 : 255.0 / 224.0;
+
+		const auto fixed = [](double v) { return (Sint16)std::lround(v * 64.0); };
+		return {
+			(Sint16)(full ? 0 : 16), (Sint16)std::lround(ys * 128.0),
+			fixed(2.0 * (1.0 - kr) * cs),
+			fixed(-2.0 * (1.0 - kb) * kb / kg * cs), fixed(-2.0 * (1.0 - kr) * kr / kg * cs),
+			fixed(2.0 * (1.0 - kb) * cs)
+		};
+	}
+
+	// The byte offsets of each channel within a destination pixel in memory
+	struct ChannelLayout
+	{
+		int r, g, b, a;
+	};
+
+	static inline Uint8 Clamp6(int v) { return (Uint8)std::clamp(v >> 6, 0, 255); }
+
+	// Convert one row, with U and V at half the horizontal resolution of Y
+	static void ConvertRow(const Uint8* Y, const Uint8* U, const Uint8* V, int w, Uint8* out, const YUVCoefficients& k, const ChannelLayout& l)
+	{
+		int x = 0;
+
+#if defined(SDLPP_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i bias = _mm_set1_epi16(128);
+		const __m128i round = _mm_set1_epi16(32);
+		const __m128i yoff = _mm_set1_epi16(k.yoff), ykHalf = _mm_set1_epi16(k.yk >> 1), ykOdd = _mm_set1_epi16(k.yk & 1);
+		const __m128i crr = _mm_set1_epi16(k.crr), cbg = _mm_set1_epi16(k.cbg), crg = _mm_set1_epi16(k.crg), cbb = _mm_set1_epi16(k.cbb);
+
+		for (; x + 16 <= w; x += 16)
+		{
+			const __m128i y8 = _mm_loadu_si128((const __m128i*)(Y + x));
+			const __m128i u = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(U + x / 2)), zero), bias);
+			const __m128i v = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(V + x / 2)), zero), bias);
+
+			// Chroma terms for 8 pixel pairs
+			const __m128i rc = _mm_mullo_epi16(v, crr);
+			const __m128i gc = _mm_add_epi16(_mm_mullo_epi16(u, cbg), _mm_mullo_epi16(v, crg));
+			const __m128i bc = _mm_mullo_epi16(u, cbb);
+
+			const auto luma = [&](__m128i y)
+			{
+				const __m128i a = _mm_sub_epi16(y, yoff);
+				return _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(a, ykHalf), _mm_srai_epi16(_mm_mullo_epi16(a, ykOdd), 1)), round);
+			};
+
+			const __m128i ylo = luma(_mm_unpacklo_epi8(y8, zero));
+			const __m128i yhi = luma(_mm_unpackhi_epi8(y8, zero));
+
+			// Each chroma term is shared by two neighbouring pixels; saturation only happens far outside 0-255
+			const auto channel = [&](__m128i c)
+			{
+				const __m128i lo = _mm_srai_epi16(_mm_adds_epi16(ylo, _mm_unpacklo_epi16(c, c)), 6);
+				const __m128i hi = _mm_srai_epi16(_mm_adds_epi16(yhi, _mm_unpackhi_epi16(c, c)), 6);
+				return _mm_packus_epi16(lo, hi);
+			};
+
+			__m128i ch[4];
+			ch[l.r] = channel(rc);
+			ch[l.g] = channel(gc);
+			ch[l.b] = channel(bc);
+			ch[l.a] = _mm_set1_epi8((char)0xFF);
+
+			const __m128i lo01 = _mm_unpacklo_epi8(ch[0], ch[1]), hi01 = _mm_unpackhi_epi8(ch[0], ch[1]);
+			const __m128i lo23 = _mm_unpacklo_epi8(ch[2], ch[3]), hi23 = _mm_unpackhi_epi8(ch[2], ch[3]);
+			__m128i* dst = (__m128i*)(out + x * 4);
+			_mm_storeu_si128(dst + 0, _mm_unpacklo_epi16(lo01, lo23));
+			_mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(lo01, lo23));
+			_mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(hi01, hi23));
+			_mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(hi01, hi23));
+		}
+#elif defined(SDLPP_NEON)
+		const int16x8_t bias = vdupq_n_s16(128);
+		const int16x8_t yoff = vdupq_n_s16(k.yoff);
+		const int16x8_t round = vdupq_n_s16(32);
+
+		for (; x + 16 <= w; x += 16)
+		{
+			const uint8x16_t y8 = vld1q_u8(Y + x);
+			const int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(U + x / 2))), bias);
+			const int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(V + x / 2))), bias);
+
+			const int16x8x2_t rc = vzipq_s16(vmulq_n_s16(v, k.crr), vmulq_n_s16(v, k.crr));
+			const int16x8_t g = vmlaq_n_s16(vmulq_n_s16(u, k.cbg), v, k.crg);
+			const int16x8x2_t gc = vzipq_s16(g, g);
+			const int16x8x2_t bc = vzipq_s16(vmulq_n_s16(u, k.cbb), vmulq_n_s16(u, k.cbb));
+
+			const auto luma = [&](uint8x8_t y)
+			{
+				const int16x8_t a = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(y)), yoff);
+				return vaddq_s16(vaddq_s16(vmulq_n_s16(a, k.yk >> 1), vshrq_n_s16(vmulq_n_s16(a, k.yk & 1), 1)), round);
+			};
+
+			const int16x8_t ylo = luma(vget_low_u8(y8));
+			const int16x8_t yhi = luma(vget_high_u8(y8));
+
+			uint8x16x4_t px;
+			px.val[l.r] = vcombine_u8(vqshrun_n_s16(vqaddq_s16(ylo, rc.val[0]), 6), vqshrun_n_s16(vqaddq_s16(yhi, rc.val[1]), 6));
+			px.val[l.g] = vcombine_u8(vqshrun_n_s16(vqaddq_s16(ylo, gc.val[0]), 6), vqshrun_n_s16(vqaddq_s16(yhi, gc.val[1]), 6));
+			px.val[l.b] = vcombine_u8(vqshrun_n_s16(vqaddq_s16(ylo, bc.val[0]), 6), vqshrun_n_s16(vqaddq_s16(yhi, bc.val[1]), 6));
+			px.val[l.a] = vdupq_n_u8(0xFF);
+			vst4q_u8(out + x * 4, px);
+		}
+#endif
+
+		for (; x < w; x++)
+		{
+			const int y = (((Y[x] - k.yoff) * k.yk) >> 1) + 32;
+			const int u = U[x >> 1] - 128;
+			const int v = V[x >> 1] - 128;
+			Uint8* p = out + x * 4;
+			p[l.r] = Clamp6(y + v * k.crr);
+			p[l.g] = Clamp6(y + u * k.cbg + v * k.crg);
+			p[l.b] = Clamp6(y + u * k.cbb);
+			p[l.a] = 0xFF;
+		}
+	}
+
+	// Split a row of interleaved chroma pairs into separate rows
+	static void SplitChroma(const Uint8* uv, int n, Uint8* first, Uint8* second)
+	{
+		int i = 0;
+
+#if defined(SDLPP_SSE2)
+		const __m128i mask = _mm_set1_epi16(0x00FF);
+		for (; i + 16 <= n; i += 16)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i*)(uv + i * 2));
+			const __m128i b = _mm_loadu_si128((const __m128i*)(uv + i * 2 + 16));
+			_mm_storeu_si128((__m128i*)(first + i), _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+			_mm_storeu_si128((__m128i*)(second + i), _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+		}
+#elif defined(SDLPP_NEON)
+		for (; i + 16 <= n; i += 16)
+		{
+			const uint8x16x2_t pairs = vld2q_u8(uv + i * 2);
+			vst1q_u8(first + i, pairs.val[0]);
+			vst1q_u8(second + i, pairs.val[1]);
+		}
+#endif
+
+		for (; i < n; i++)
+		{
+			first[i] = uv[i * 2];
+			second[i] = uv[i * 2 + 1];
+		}
+	}
+
+#pragma endregion
+
+#pragma region Conversion
+
+	// Where the planes of a frame are and how they are arranged
+	struct YUVSource
+	{
+		enum class Kind { PLANAR, SEMIPLANAR, PACKED } kind;
+
+		const Uint8* Y;
+		const Uint8* U;     // For semiplanar frames, the interleaved chroma plane
+		const Uint8* V;
+		int Ypitch, Upitch, Vpitch;
+
+		bool vFirst;        // Semiplanar chroma stores V before U
+		int offsets[4];     // Packed frames: the byte offsets of Y0, U, Y1 and V in each pixel pair
+	};
+
+	static bool GetLayout(Uint32 format, ChannelLayout& layout)
+	{
+		SDL_PixelFormat* fmt = SDL_AllocFormat(format);
+		if (fmt == NULL) return false;
+
+		const bool ok = Is8888(fmt);
+		if (ok)
+		{
+			const auto offset = [](int shift)
+			{
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+				return shift / 8;
+#else
+				return 3 - shift / 8;
+#endif
+			};
+
+			layout.r = offset(fmt->Rshift);
+			layout.g = offset(fmt->Gshift);
+			layout.b = offset(fmt->Bshift);
+
+			// Formats without alpha still have a padding byte, which is set like alpha
+			layout.a = 6 - layout.r - layout.g - layout.b;
+		}
+		else SDL_SetError("YUV frames can only be converted to 32-bit formats with 8-bit channels");
+
+		SDL_FreeFormat(fmt);
+		return ok;
+	}
+
+	static bool Convert(int width, int height, const YUVSource& src, Uint32 dst_format, void* dst, int dst_pitch, YUVMatrix matrix, YUVRange range, bool parallel)
+	{
+		if (width < 0 || height < 0 || src.Y == NULL || (src.kind != YUVSource::Kind::PACKED && src.U == NULL) || (src.kind == YUVSource::Kind::PLANAR && src.V == NULL) || dst == NULL)
+		{
+			SDL_SetError("Invalid YUV conversion parameters");
+			return false;
+		}
+
+		ChannelLayout layout;
+		if (!GetLayout(dst_format, layout)) return false;
+
+		const YUVCoefficients k = GetCoefficients(matrix, range);
+		const int cw = (width + 1) / 2;
+
+		MaybeParallelFor(parallel, height, [&](int begin, int end)
+		{
+			std::vector<Uint8> scratch(src.kind == YUVSource::Kind::PACKED ? (size_t)width + cw * 2 + 2 : (size_t)cw * 2);
+
+			for (int y = begin; y < end; y++)
+			{
+				const Uint8* Y;
+				const Uint8* U;
+				const Uint8* V;
+
+				switch (src.kind)
+				{
+				case YUVSource::Kind::PLANAR:
+					Y = src.Y + (size_t)y * src.Ypitch;
+					U = src.U + (size_t)(y / 2) * src.Upitch;
+					V = src.V + (size_t)(y / 2) * src.Vpitch;
+					break;
+
+				case YUVSource::Kind::SEMIPLANAR:
+				{
+					Uint8* first = scratch.data();
+					Uint8* second = first + cw;
+					SplitChroma(src.U + (size_t)(y / 2) * src.Upitch, cw, first, second);
+					Y = src.Y + (size_t)y * src.Ypitch;
+					U = src.vFirst ? second : first;
+					V = src.vFirst ? first : second;
+					break;
+				}
+
+				default:
+				{
+					const Uint8* in = src.Y + (size_t)y * src.Ypitch;
+					Uint8* ys = scratch.data();
+					Uint8* us = ys + width + 1;
+					Uint8* vs = us + cw;
+					for (int i = 0; i < cw; i++, in += 4)
+					{
+						ys[i * 2] = in[src.offsets[0]];
+						ys[i * 2 + 1] = in[src.offsets[2]];
+						us[i] = in[src.offsets[1]];
+						vs[i] = in[src.offsets[3]];
+					}
+					Y = ys;
+					U = us;
+					V = vs;
+					break;
+				}
+				}
+
+				ConvertRow(Y, U, V, width, (Uint8*)dst + (size_t)y * dst_pitch, k, layout);
+			}
+		}, 32);
+
+		return true;
+	}
+
+	bool ConvertYUV(int width, int height, Uint32 yuv_format, const void* yuv, int yuv_pitch, Uint32 dst_format, void* dst, int dst_pitch, YUVMatrix matrix, YUVRange range, bool parallel)
+	{
+		const Uint8* base = (const Uint8*)yuv;
+		const size_t ysize = (size_t)yuv_pitch * height;
+		const int cpitch = (yuv_pitch + 1) / 2;
+		const size_t csize = (size_t)cpitch * ((height + 1) / 2);
+
+		YUVSource src = {};
+		src.Y = base;
+		src.Ypitch = yuv_pitch;
+
+		switch (yuv_format)
+		{
+		case SDL_PIXELFORMAT_IYUV:
+		case SDL_PIXELFORMAT_YV12:
+		{
+			const Uint8* first = base + ysize;
+			const Uint8* second = first + csize;
+			src.kind = YUVSource::Kind::PLANAR;
+			src.U = yuv_format == SDL_PIXELFORMAT_IYUV ? first : second;
+			src.V = yuv_format == SDL_PIXELFORMAT_IYUV ? second : first;
+			src.Upitch = src.Vpitch = cpitch;
+			break;
+		}
+
+		case SDL_PIXELFORMAT_NV12:
+		case SDL_PIXELFORMAT_NV21:
+			src.kind = YUVSource::Kind::SEMIPLANAR;
+			src.U = base + ysize;
+			src.Upitch = cpitch * 2;
+			src.vFirst = yuv_format == SDL_PIXELFORMAT_NV21;
+			break;
+
+		case SDL_PIXELFORMAT_YUY2: src = { YUVSource::Kind::PACKED, base, NULL, NULL, yuv_pitch, 0, 0, false, { 0, 1, 2, 3 } }; break;
+		case SDL_PIXELFORMAT_UYVY: src = { YUVSource::Kind::PACKED, base, NULL, NULL, yuv_pitch, 0, 0, false, { 1, 0, 3, 2 } }; break;
+		case SDL_PIXELFORMAT_YVYU: src = { YUVSource::Kind::PACKED, base, NULL, NULL, yuv_pitch, 0, 0, false, { 0, 3, 2, 1 } }; break;
+
+		default:
+			SDL_SetError("Unsupported YUV format %s", SDL_GetPixelFormatName(yuv_format));
+			return false;
+		}
+
+		return Convert(width, height, src, dst_format, dst, dst_pitch, matrix, range, parallel);
+	}
+
+	bool ConvertYUVPlanes(int width, int height, const Uint8* Yplane, int Ypitch, const Uint8* Uplane, int Upitch, const Uint8* Vplane, int Vpitch,
+		Uint32 dst_format, void* dst, int dst_pitch, YUVMatrix matrix, YUVRange range, bool parallel)
+	{
+		const YUVSource src = { YUVSource::Kind::PLANAR, Yplane, Uplane, Vplane, Ypitch, Upitch, Vpitch, false, { 0, 0, 0, 0 } };
+		return Convert(width, height, src, dst_format, dst, dst_pitch, matrix, range, parallel);
+	}
+
+	bool ConvertNVPlanes(int width, int height, const Uint8* Yplane, int Ypitch, const Uint8* UVplane, int UVpitch, Uint32 nv_format,
+		Uint32 dst_format, void* dst, int dst_pitch, YUVMatrix matrix, YUVRange range, bool parallel)
+	{
+		if (nv_format != SDL_PIXELFORMAT_NV12 && nv_format != SDL_PIXELFORMAT_NV21)
+		{
+			SDL_SetError("Unsupported NV format %s", SDL_GetPixelFormatName(nv_format));
+			return false;
+		}
+
+		const YUVSource src = { YUVSource::Kind::SEMIPLANAR, Yplane, UVplane, NULL, Ypitch, UVpitch, 0, nv_format == SDL_PIXELFORMAT_NV21, { 0, 0, 0, 0 } };
+		return Convert(width, height, src, dst_format, dst, dst_pitch, matrix, range, parallel);
+	}
+
+#pragma endregion
+}